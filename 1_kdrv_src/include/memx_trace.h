@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Data path tracepoints: one start / done pair per ifmap write and ofmap read,
+ * enabled through tracefs (events/memx_pcie, events/memx_usb) and merged with
+ * the host side frame events of the test suite into one timeline.
+ *
+ * Shared by both drivers; the including driver names its event system first:
+ *	#define MEMX_TRACE_SYSTEM memx_pcie
+ *	#define CREATE_TRACE_POINTS
+ *	#include "memx_trace.h"
+ */
+#ifndef MEMX_TRACE_SYSTEM
+#error "define MEMX_TRACE_SYSTEM (memx_pcie / memx_usb) before including memx_trace.h"
+#endif
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM MEMX_TRACE_SYSTEM
+
+#if !defined(_MEMX_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _MEMX_TRACE_H_
+
+#include <linux/tracepoint.h>
+
+// id: target chip of pcie writes, rx indicator of pcie reads, 0 on usb; ret: 0 on start events
+DECLARE_EVENT_CLASS(memx_xfer,
+	TP_PROTO(u32 minor, s32 id, size_t size, ssize_t ret),
+	TP_ARGS(minor, id, size, ret),
+	TP_STRUCT__entry(
+		__field(u32, minor)
+		__field(s32, id)
+		__field(size_t, size)
+		__field(ssize_t, ret)
+	),
+	TP_fast_assign(
+		__entry->minor = minor;
+		__entry->id = id;
+		__entry->size = size;
+		__entry->ret = ret;
+	),
+	TP_printk("memx%u id=%d size=%zu ret=%zd", __entry->minor, __entry->id, __entry->size, __entry->ret)
+);
+
+DEFINE_EVENT(memx_xfer, memx_write_start,
+	TP_PROTO(u32 minor, s32 id, size_t size, ssize_t ret),
+	TP_ARGS(minor, id, size, ret));
+
+DEFINE_EVENT(memx_xfer, memx_write_done,
+	TP_PROTO(u32 minor, s32 id, size_t size, ssize_t ret),
+	TP_ARGS(minor, id, size, ret));
+
+DEFINE_EVENT(memx_xfer, memx_read_start,
+	TP_PROTO(u32 minor, s32 id, size_t size, ssize_t ret),
+	TP_ARGS(minor, id, size, ret));
+
+DEFINE_EVENT(memx_xfer, memx_read_done,
+	TP_PROTO(u32 minor, s32 id, size_t size, ssize_t ret),
+	TP_ARGS(minor, id, size, ret));
+
+#endif /* _MEMX_TRACE_H_ */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE memx_trace
+#include <trace/define_trace.h>
@@ -9,6 +9,9 @@
 #include "memx_fw_cmd.h"
 #include "memx_fw_init.h"
 #include "memx_fs.h"
+#define MEMX_TRACE_SYSTEM memx_pcie
+#define CREATE_TRACE_POINTS
+#include "memx_trace.h"
 
 dev_t g_memx_devno;
 dev_t g_feature_devno;
@@ -27,6 +30,10 @@ u32 tx_time_us = 0, rx_time_us = 0;
 u32 tx_size = 0, rx_size = 0;
 static u32 dma_cohernet_buffer_size = DMA_COHERENT_BUFFER_SIZE_2MB;
 struct memx_throughput_info udrv_throughput_info = {0};
+ktime_t memx_module_init_time;
+const char * const memx_startup_phase_name[MEMX_STARTUP_PHASE_MAX] = {
+	"probe", "device_node", "fs", "fw_download", "fw_boot", "hw_info", "fw_log", "done"
+};
 
 module_param(g_drv_fs_type, uint, 0);
 MODULE_PARM_DESC(g_drv_fs_type, "debugfs control:: 0-Disable debugfs  1-proc filesys  2-sysfs filesys(default)");
@@ -334,10 +341,20 @@ static long memx_fops_ioctl(struct file *filp, u32 cmd, unsigned long arg)
 
 		switch (pCmd->SQ.subOpCode) {
 		case DFP_DOWNLOAD_WEIGHT_MEMORY:
-		case DFP_DOWNLOAD_REG_CONFIG:
+		case DFP_DOWNLOAD_REG_CONFIG: {
+			ktime_t dl_start_time = ktime_get();
+
 			dma_sync_single_for_device(&memx_dev->pDev->dev, (dma_addr_t)memx_dev->mpu_data.hw_info.fw.rx_dma_coherent_buffer_base, DMA_COHERENT_BUFFER_SIZE_2MB, DMA_BIDIRECTIONAL);
 			memx_send_cmd_to_fw_and_get_result(memx_dev, PCIE_CMD_VENDOR_0, sizeof(struct transport_cmd), CHIP_ID0);
 			pCmd->CQ.status = 0;
+			if (pCmd->SQ.subOpCode == DFP_DOWNLOAD_WEIGHT_MEMORY) {
+				atomic_inc(&memx_dev->dfp_download.wtmem_cnt);
+				atomic64_add(ktime_us_delta(ktime_get(), dl_start_time), &memx_dev->dfp_download.wtmem_us);
+			} else {
+				atomic_inc(&memx_dev->dfp_download.rgcfg_cnt);
+				atomic64_add(ktime_us_delta(ktime_get(), dl_start_time), &memx_dev->dfp_download.rgcfg_us);
+			}
+		}
 			break;
 		default:
 			break;
@@ -451,6 +468,7 @@ static ssize_t memx_fops_read(struct file *filp, char __user *buf, size_t count,
 	}
 
 	rx_start_time = ktime_get();
+	trace_memx_read_start(memx_dev->minor_index, -1, count, 0);
 	// check until received ofmap process done msix if there no pending rx msix
 	if (!kfifo_out_locked(&memx_dev->rx_msix_fifo, &indicator, sizeof(s32), &memx_dev->mpu_data.rx_ctrl.lock)) {
 		do {
@@ -461,7 +479,7 @@ static ssize_t memx_fops_read(struct file *filp, char __user *buf, size_t count,
 
 				wq_status = -ERESTARTSYS;
 				memx_dev->mpu_data.rx_ctrl.is_abort = 0;
-				return indicator;
+				goto done;
 			}
 			if (wq_status == -ERESTARTSYS) {
 				pr_warn("memryx: fops_read: cancelled by interrupt signal\n");
@@ -476,7 +494,7 @@ static ssize_t memx_fops_read(struct file *filp, char __user *buf, size_t count,
 			if (!kfifo_out_locked(&memx_dev->rx_msix_fifo, &indicator, sizeof(s32), &memx_dev->mpu_data.rx_ctrl.lock)) {
 				pr_err("memryx: fops_read: kfifo_out is empty\n");
 				indicator = -EFAULT;
-				return indicator;
+				goto done;
 			}
 		}
 	}
@@ -489,12 +507,14 @@ static ssize_t memx_fops_read(struct file *filp, char __user *buf, size_t count,
 		if (copy_to_user((void __user *)buf, memx_dev->mpu_data.rx_dma_coherent_buffer_virtual_base, count)) {
 			pr_err("memryx: fops_read: copy egress_dcore_flow_data to user failed\n");
 			indicator = -EFAULT;
-			return indicator;
+			goto done;
 		}
 #ifdef DEBUG
 		pr_info("memryx: read: received ofmap rx done notification from msix isr(%d)\n", indicator);
 #endif
 	}
+done:
+	trace_memx_read_done(memx_dev->minor_index, indicator, indicator >= 0 ? count : 0, indicator);
 	return indicator;
 }
 
@@ -516,6 +536,7 @@ static ssize_t memx_fops_write(struct file *filp, const char __user *buf, size_t
 		pr_err("memryx: fops_write: get memx_dev->mutex failed\n");
 		return -ERESTARTSYS;
 	}
+	trace_memx_write_start(memx_dev->minor_index, -1, count, 0);
 
 	// Todo: serperate tx_dma_buf for different chip
 	tx_dma_buf = memx_dev->mpu_data.rx_dma_coherent_buffer_virtual_base + IFMAP_INGRESS_DCORE_DMA_COHERENT_BUFFER_SIZE_512KB;
@@ -545,8 +566,8 @@ static ssize_t memx_fops_write(struct file *filp, const char __user *buf, size_t
 		if (memx_dev->mpu_data.tx_ctrl[target_chip_id].is_abort) {
 			wq_status = -ERESTARTSYS;
 			memx_dev->mpu_data.tx_ctrl[target_chip_id].is_abort = 0;
-			up(&memx_dev->mutex);
-			return 0;
+			write_len = 0;
+			goto done;
 		}
 		if (wq_status == -ERESTARTSYS) {
 			pr_warn("memryx: fops_write: cancelled by interrupt signal\n");
@@ -570,6 +591,7 @@ static ssize_t memx_fops_write(struct file *filp, const char __user *buf, size_t
 	}
 done:
 	up(&memx_dev->mutex);
+	trace_memx_write_done(memx_dev->minor_index, target_chip_id, count, write_len);
 	return write_len;
 }
 
@@ -708,6 +730,7 @@ static s32 memx_pcie_probe(struct pci_dev *pDev, const struct pci_device_id *id)
 	struct device *char_dev = NULL;
 	struct device *feature_dev = NULL;
 	struct memx_firmware_bin memx_fw_bin;
+	ktime_t probe_time = ktime_get();
 
 #ifdef DEBUG
 	pr_info("memryx: bdf(bus(%04x):device(%02x):func(%x)), Vid(%04x):Did(%04x)\n",
@@ -726,6 +749,7 @@ static s32 memx_pcie_probe(struct pci_dev *pDev, const struct pci_device_id *id)
 		ret = -ENOMEM;
 		goto probe_exit;
 	}
+	memx_dev->startup_time[MEMX_STARTUP_PROBE] = probe_time;
 
 	// Enable the device before we access any pci resource.
 	ret = pcim_enable_device(pDev);
@@ -997,6 +1021,7 @@ static s32 memx_pcie_probe(struct pci_dev *pDev, const struct pci_device_id *id)
 		ret = PTR_ERR(feature_dev);
 		goto err_dev_init;
 	}
+	memx_dev->startup_time[MEMX_STARTUP_DEVICE_NODE] = ktime_get();
 
 	memx_dev->fs.type = g_drv_fs_type;
 	memx_dev->fs.debug_en = fs_debug_en;
@@ -1007,6 +1032,7 @@ static s32 memx_pcie_probe(struct pci_dev *pDev, const struct pci_device_id *id)
 			goto err_dev_init;
 		}
 	}
+	memx_dev->startup_time[MEMX_STARTUP_FS] = ktime_get();
 
 	memx_fw_bin.request_firmware_update_in_linux = true;
 	strscpy(&memx_fw_bin.name[0], FIRMWARE_BIN_NAME, FILE_NAME_LENGTH - 1);
@@ -1025,6 +1051,7 @@ static s32 memx_pcie_probe(struct pci_dev *pDev, const struct pci_device_id *id)
 			goto err_fs_init;
 		}
 	}
+	memx_dev->startup_time[MEMX_STARTUP_FW_LOG] = ktime_get();
 
 	if (memx_dev->bar_mode == MEMXBAR_XFLOW256MB_SRAM1MB) {
 		if ((pcie_lane_no > 2) || (pcie_lane_no < 1) || (pcie_lane_speed > 3) || (pcie_lane_speed < 1)) {
@@ -1041,7 +1068,17 @@ static s32 memx_pcie_probe(struct pci_dev *pDev, const struct pci_device_id *id)
 				memx_xflow_write(memx_dev, i, MEMX_DBGLOG_CONTROL_BASE, 0x6C, pcie_aspm&0xF, false);
 		}
 	}
+	memx_dev->startup_time[MEMX_STARTUP_DONE] = ktime_get();
 	pr_info("memryx: PCIe probe success\n");
+	pr_info("memryx: startup: memx%u probe(us): device_node %lld fs %lld fw_download %lld fw_boot %lld hw_info %lld fw_log %lld done %lld\n",
+		memx_dev->minor_index,
+		ktime_us_delta(memx_dev->startup_time[MEMX_STARTUP_DEVICE_NODE], probe_time),
+		ktime_us_delta(memx_dev->startup_time[MEMX_STARTUP_FS], probe_time),
+		ktime_us_delta(memx_dev->startup_time[MEMX_STARTUP_FW_DOWNLOAD], probe_time),
+		ktime_us_delta(memx_dev->startup_time[MEMX_STARTUP_FW_BOOT], probe_time),
+		ktime_us_delta(memx_dev->startup_time[MEMX_STARTUP_HW_INFO], probe_time),
+		ktime_us_delta(memx_dev->startup_time[MEMX_STARTUP_FW_LOG], probe_time),
+		ktime_us_delta(memx_dev->startup_time[MEMX_STARTUP_DONE], probe_time));
 
 	return 0;
 
@@ -1242,6 +1279,7 @@ static s32 __init memx_pcie_module_init(void)
 {
 	s32 ret = 0;
 
+	memx_module_init_time = ktime_get();
 	ret = alloc_chrdev_region(&g_memx_devno, 0, MAX_CHIP_NUM, PCIE_NAME);
 	if (ret < 0) {
 		pr_err("memryx: module_init: failed to call alloc_chrdev_region for g_memx_devno, ret(%d)\n", ret);
@@ -242,8 +242,13 @@ static long _admin_command(struct memx_pcie_dev *memx_dev, struct transport_cmd
 		case MEMX_ADMIN_CMD_GET_FEATURE:
 			ret = _admin_get_feature(memx_dev, pCmd);
 			break;
-		case MEMX_ADMIN_CMD_DOWNLOAD_DFP:
+		case MEMX_ADMIN_CMD_DOWNLOAD_DFP: {
+			ktime_t dl_start_time = ktime_get();
+
 			ret = _admin_download_dfp(memx_dev, pCmd);
+			atomic_inc(&memx_dev->dfp_download.admin_cnt);
+			atomic64_add(ktime_us_delta(ktime_get(), dl_start_time), &memx_dev->dfp_download.admin_us);
+		}
 			break;
 		case MEMX_ADMIN_CMD_SELFTEST:
 			ret = _admin_selftest(memx_dev, pCmd);
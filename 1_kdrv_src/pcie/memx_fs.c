@@ -323,6 +323,16 @@ s32 memx_fs_parse_gpioctrl_and_exec(struct memx_pcie_dev *memx_dev, const char _
 	return 0;
 }
 
+void memx_fs_dfp_download_reset(struct memx_pcie_dev *memx_dev)
+{
+	atomic_set(&memx_dev->dfp_download.wtmem_cnt, 0);
+	atomic_set(&memx_dev->dfp_download.rgcfg_cnt, 0);
+	atomic_set(&memx_dev->dfp_download.admin_cnt, 0);
+	atomic64_set(&memx_dev->dfp_download.wtmem_us, 0);
+	atomic64_set(&memx_dev->dfp_download.rgcfg_us, 0);
+	atomic64_set(&memx_dev->dfp_download.admin_us, 0);
+}
+
 u32 memx_crc32(const uint8_t *data, size_t length)
 {
 	u32 *crc32_table;
@@ -54,6 +54,8 @@ union memx_fs_hif {
 		struct proc_dir_entry *i2ctrl_entry;
 		struct proc_dir_entry *gpio_entry;
 		struct proc_dir_entry *throughput_entry;
+		struct proc_dir_entry *dfp_download_entry;
+		struct proc_dir_entry *startup_entry;
 	} proc;
 	struct {
 		struct kobject *root_dir;
@@ -74,6 +76,7 @@ s32 memx_fs_cmd_handler(struct memx_pcie_dev *memx_dev, u8 argc, char **argv);
 s32 memx_fs_parse_cmd_and_exec(struct memx_pcie_dev *memx_dev, const char __user *user_input_buf, size_t user_input_buf_size);
 s32 memx_fs_parse_i2ctrl_and_exec(struct memx_pcie_dev *memx_dev, const char __user *user_input_buf, size_t user_input_buf_size);
 s32 memx_fs_parse_gpioctrl_and_exec(struct memx_pcie_dev *memx_dev, const char __user *user_input_buf, size_t user_input_buf_size);
+void memx_fs_dfp_download_reset(struct memx_pcie_dev *memx_dev);
 u32 memx_crc32(const uint8_t *data, size_t length);
 extern void memx_admin_trigger(struct memx_pcie_dev *memx_dev, uint8_t chip_id, struct transport_cmd *pCmd);
 extern enum CASCADE_PLUS_ADMINCMD_ERROR_STATUS memx_admin_fetch_result(struct memx_pcie_dev *memx_dev, uint8_t chip_id, struct transport_cmd *cmd);
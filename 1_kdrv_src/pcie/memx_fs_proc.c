@@ -292,6 +292,34 @@ static s32 memx_proc_throughput_usage(struct seq_file *sfile, void *v)
 	return 0;
 }
 
+static s32 memx_proc_dfp_download_usage(struct seq_file *sfile, void *v)
+{
+	struct memx_pcie_dev *memx_dev = sfile->private;
+	struct memx_dfp_download_info *info = &memx_dev->dfp_download;
+
+	seq_puts(sfile, "  Item  |    Count     |  Period(us)\n");
+	seq_puts(sfile, "--------+--------------+--------------\n");
+	seq_printf(sfile, " WtMem  |  %10u  |  %10llu\n", atomic_read(&info->wtmem_cnt), (u64)atomic64_read(&info->wtmem_us));
+	seq_printf(sfile, " RgCfg  |  %10u  |  %10llu\n", atomic_read(&info->rgcfg_cnt), (u64)atomic64_read(&info->rgcfg_us));
+	seq_printf(sfile, " Admin  |  %10u  |  %10llu\n", atomic_read(&info->admin_cnt), (u64)atomic64_read(&info->admin_us));
+
+	return 0;
+}
+
+static s32 memx_proc_startup_usage(struct seq_file *sfile, void *v)
+{
+	struct memx_pcie_dev *memx_dev = sfile->private;
+	u8 idx = 0;
+
+	seq_puts(sfile, "    Phase     |  Monotonic(ns)\n");
+	seq_puts(sfile, "--------------+---------------------\n");
+	seq_printf(sfile, " %-12s |  %lld\n", "module_init", ktime_to_ns(memx_module_init_time));
+	for (idx = 0; idx < MEMX_STARTUP_PHASE_MAX; idx++)
+		seq_printf(sfile, " %-12s |  %lld\n", memx_startup_phase_name[idx], ktime_to_ns(memx_dev->startup_time[idx]));
+
+	return 0;
+}
+
 static int memx_proc_open(struct inode *inode, struct file *file)
 {
 #if KERNEL_VERSION(5, 17, 11) <= _LINUX_VERSION_CODE_
@@ -382,6 +410,24 @@ static int memx_proc_open_throughput(struct inode *inode, struct file *file)
 #endif
 }
 
+static int memx_proc_open_dfp_download(struct inode *inode, struct file *file)
+{
+#if KERNEL_VERSION(5, 17, 11) <= _LINUX_VERSION_CODE_
+	return single_open(file, memx_proc_dfp_download_usage, pde_data(inode));
+#else
+	return single_open(file, memx_proc_dfp_download_usage, PDE_DATA(inode));
+#endif
+}
+
+static int memx_proc_open_startup(struct inode *inode, struct file *file)
+{
+#if KERNEL_VERSION(5, 17, 11) <= _LINUX_VERSION_CODE_
+	return single_open(file, memx_proc_startup_usage, pde_data(inode));
+#else
+	return single_open(file, memx_proc_startup_usage, PDE_DATA(inode));
+#endif
+}
+
 ssize_t memx_proc_write(struct file *file, const char __user *user_input_buf, size_t user_input_buf_size, loff_t *off);
 ssize_t memx_proc_write(struct file *file, const char __user *user_input_buf, size_t user_input_buf_size, loff_t *off)
 {
@@ -468,6 +514,44 @@ ssize_t memx_proc_write_thermal(struct file *file, const char __user *user_input
 	return user_input_buf_size;
 }
 
+ssize_t memx_proc_write_dfp_download(struct file *file, const char __user *user_input_buf, size_t user_input_buf_size, loff_t *off);
+ssize_t memx_proc_write_dfp_download(struct file *file, const char __user *user_input_buf, size_t user_input_buf_size, loff_t *off)
+{
+	s32 ret = -EINVAL;
+	struct memx_pcie_dev *memx_dev = NULL;
+	char *input_parser_buffer_ptr = NULL;
+
+	if (!file || !file->private_data) {
+		pr_err("memryx: %s: file or file->private_data is NULL!\n", __func__);
+		return ret;
+	}
+	memx_dev = ((struct seq_file *)file->private_data)->private;
+	if (!memx_dev) {
+		pr_err("memryx: %s: memx_dev is NULL!\n", __func__);
+		return ret;
+	}
+	if (!user_input_buf || user_input_buf_size == 0) {
+		pr_err("memryx: Command length is invalid!\n");
+		return ret;
+	}
+
+	input_parser_buffer_ptr = memdup_user_nul(user_input_buf, user_input_buf_size);
+	if (IS_ERR(input_parser_buffer_ptr)) {
+		pr_err("memryx: %s: memdup_user_nul fail!\n", __func__);
+		return PTR_ERR(input_parser_buffer_ptr);
+	}
+
+	if (strncmp(input_parser_buffer_ptr, "reset", 5) == 0) {
+		memx_fs_dfp_download_reset(memx_dev);
+		ret = user_input_buf_size;
+	} else {
+		pr_err("memryx: unsupported cmd:  %s(Only \"reset\" is valid)\n", input_parser_buffer_ptr);
+	}
+
+	kfree(input_parser_buffer_ptr);
+	return ret;
+}
+
 ssize_t memx_proc_write_i2ctrl(struct file *file, const char __user *user_input_buf, size_t user_input_buf_size, loff_t *off);
 ssize_t memx_proc_write_i2ctrl(struct file *file, const char __user *user_input_buf, size_t user_input_buf_size, loff_t *off)
 {
@@ -600,6 +684,19 @@ static const struct proc_ops proc_throughput_fops = {
 	.proc_lseek   = seq_lseek,
 	.proc_release = single_release,
 };
+static const struct proc_ops proc_dfp_download_fops = {
+	.proc_open	= memx_proc_open_dfp_download,
+	.proc_read	= seq_read,
+	.proc_lseek   = seq_lseek,
+	.proc_release = single_release,
+	.proc_write   = memx_proc_write_dfp_download
+};
+static const struct proc_ops proc_startup_fops = {
+	.proc_open	= memx_proc_open_startup,
+	.proc_read	= seq_read,
+	.proc_lseek   = seq_lseek,
+	.proc_release = single_release,
+};
 #else
 static struct file_operations proc_cmd_fops = {
 	.owner   = THIS_MODULE,
@@ -676,6 +773,21 @@ static struct file_operations throughput_fops = {
 	.llseek  = seq_lseek,
 	.release = single_release,
 };
+static struct file_operations proc_dfp_download_fops = {
+	.owner   = THIS_MODULE,
+	.open	= memx_proc_open_dfp_download,
+	.read	= seq_read,
+	.llseek  = seq_lseek,
+	.release = single_release,
+	.write   = memx_proc_write_dfp_download
+};
+static struct file_operations proc_startup_fops = {
+	.owner   = THIS_MODULE,
+	.open	= memx_proc_open_startup,
+	.read	= seq_read,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
 #endif
 
 s32 memx_fs_proc_init(struct memx_pcie_dev *memx_dev);
@@ -840,6 +952,39 @@ s32 memx_fs_proc_init(struct memx_pcie_dev *memx_dev)
 			proc_remove(memx_dev->fs.hif.proc.root_dir);
 			return -EINVAL;
 		}
+		memx_dev->fs.hif.proc.dfp_download_entry = proc_create_data("dfp_download", 0644, memx_dev->fs.hif.proc.root_dir, &proc_dfp_download_fops, memx_dev);
+		if (!memx_dev->fs.hif.proc.dfp_download_entry) {
+			pr_err("memryx: failed to create proc file for dfp_download_entry!\n");
+			proc_remove(memx_dev->fs.hif.proc.throughput_entry);
+			proc_remove(memx_dev->fs.hif.proc.mpu_uti_entry);
+			proc_remove(memx_dev->fs.hif.proc.verinfo_entry);
+			if (memx_dev->fs.debug_en) {
+				proc_remove(memx_dev->fs.hif.proc.debug_entry);
+				proc_remove(memx_dev->fs.hif.proc.gpio_entry);
+				proc_remove(memx_dev->fs.hif.proc.i2ctrl_entry);
+				proc_remove(memx_dev->fs.hif.proc.qspi_entry);
+			}
+			proc_remove(memx_dev->fs.hif.proc.cmd_entry);
+			proc_remove(memx_dev->fs.hif.proc.root_dir);
+			return -EINVAL;
+		}
+		memx_dev->fs.hif.proc.startup_entry = proc_create_data("startup", 0444, memx_dev->fs.hif.proc.root_dir, &proc_startup_fops, memx_dev);
+		if (!memx_dev->fs.hif.proc.startup_entry) {
+			pr_err("memryx: failed to create proc file for startup_entry!\n");
+			proc_remove(memx_dev->fs.hif.proc.dfp_download_entry);
+			proc_remove(memx_dev->fs.hif.proc.throughput_entry);
+			proc_remove(memx_dev->fs.hif.proc.mpu_uti_entry);
+			proc_remove(memx_dev->fs.hif.proc.verinfo_entry);
+			if (memx_dev->fs.debug_en) {
+				proc_remove(memx_dev->fs.hif.proc.debug_entry);
+				proc_remove(memx_dev->fs.hif.proc.gpio_entry);
+				proc_remove(memx_dev->fs.hif.proc.i2ctrl_entry);
+				proc_remove(memx_dev->fs.hif.proc.qspi_entry);
+			}
+			proc_remove(memx_dev->fs.hif.proc.cmd_entry);
+			proc_remove(memx_dev->fs.hif.proc.root_dir);
+			return -EINVAL;
+		}
 	}
 
 	return 0;
@@ -15,16 +15,8 @@ struct kobj_memx_dev_entry {
 	struct memx_pcie_dev *memx_dev;
 };
 
-static struct kobj_memx_dev_entry g_kobj_memx_dev_map[8] = {
-	{NULL, NULL},
-	{NULL, NULL},
-	{NULL, NULL},
-	{NULL, NULL},
-	{NULL, NULL},
-	{NULL, NULL},
-	{NULL, NULL},
-	{NULL, NULL}
-};
+// indexed by minor_index, one entry per possible device node
+static struct kobj_memx_dev_entry g_kobj_memx_dev_map[MAX_CHIP_NUM];
 
 static char *g_usage[19] = {
 	"Usage: echo \"fwlog chip_id[0-7] [hex_addr] [hex_val]\" > /sys/memx[dev_id 0-3]/cmd\n",
@@ -637,6 +629,100 @@ static ssize_t thermalthrottling_store(struct kobject *kobj, struct kobj_attribu
 }
 
 
+static ssize_t dfp_download_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	s32 res = 0, len;
+	char *to_user_buf_pos = buf;
+	struct memx_pcie_dev *memx_dev = NULL;
+	struct memx_dfp_download_info *info = NULL;
+	u8 idx = 0;
+
+	for (idx = 0; idx < MAX_CHIP_NUM; idx++) {
+		if (g_kobj_memx_dev_map[idx].sys_kobj && g_kobj_memx_dev_map[idx].sys_kobj == kobj) {
+			memx_dev = g_kobj_memx_dev_map[idx].memx_dev;
+			break;
+		}
+	}
+	if (!memx_dev)
+		return -ENODEV;
+	info = &memx_dev->dfp_download;
+
+	len = sprintf(to_user_buf_pos, "  Item  |    Count     |  Period(us)\n");
+	to_user_buf_pos += len;
+	res += len;
+	len = sprintf(to_user_buf_pos, "--------+--------------+--------------\n");
+	to_user_buf_pos += len;
+	res += len;
+	len = sprintf(to_user_buf_pos, " WtMem  |  %10u  |  %10llu\n", atomic_read(&info->wtmem_cnt), (u64)atomic64_read(&info->wtmem_us));
+	to_user_buf_pos += len;
+	res += len;
+	len = sprintf(to_user_buf_pos, " RgCfg  |  %10u  |  %10llu\n", atomic_read(&info->rgcfg_cnt), (u64)atomic64_read(&info->rgcfg_us));
+	to_user_buf_pos += len;
+	res += len;
+	len = sprintf(to_user_buf_pos, " Admin  |  %10u  |  %10llu\n", atomic_read(&info->admin_cnt), (u64)atomic64_read(&info->admin_us));
+	to_user_buf_pos += len;
+	res += len;
+
+	return res;
+}
+
+static ssize_t dfp_download_store(struct kobject *kobj, struct kobj_attribute *attr, const char *user_input_buf, size_t user_input_buf_size)
+{
+	struct memx_pcie_dev *memx_dev = NULL;
+	u8 idx = 0;
+
+	for (idx = 0; idx < MAX_CHIP_NUM; idx++) {
+		if (g_kobj_memx_dev_map[idx].sys_kobj && g_kobj_memx_dev_map[idx].sys_kobj == kobj) {
+			memx_dev = g_kobj_memx_dev_map[idx].memx_dev;
+			break;
+		}
+	}
+	if (!memx_dev)
+		return -ENODEV;
+
+	if (!user_input_buf || strncmp(user_input_buf, "reset", 5) != 0) {
+		pr_err("memryx: unsupported cmd(Only \"reset\" is valid)\n");
+		return -EINVAL;
+	}
+	memx_fs_dfp_download_reset(memx_dev);
+
+	return user_input_buf_size;
+}
+
+static ssize_t startup_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	s32 res = 0, len;
+	char *to_user_buf_pos = buf;
+	struct memx_pcie_dev *memx_dev = NULL;
+	u8 idx = 0;
+
+	for (idx = 0; idx < MAX_CHIP_NUM; idx++) {
+		if (g_kobj_memx_dev_map[idx].sys_kobj && g_kobj_memx_dev_map[idx].sys_kobj == kobj) {
+			memx_dev = g_kobj_memx_dev_map[idx].memx_dev;
+			break;
+		}
+	}
+	if (!memx_dev)
+		return -ENODEV;
+
+	len = sprintf(to_user_buf_pos, "    Phase     |  Monotonic(ns)\n");
+	to_user_buf_pos += len;
+	res += len;
+	len = sprintf(to_user_buf_pos, "--------------+---------------------\n");
+	to_user_buf_pos += len;
+	res += len;
+	len = sprintf(to_user_buf_pos, " %-12s |  %lld\n", "module_init", ktime_to_ns(memx_module_init_time));
+	to_user_buf_pos += len;
+	res += len;
+	for (idx = 0; idx < MEMX_STARTUP_PHASE_MAX; idx++) {
+		len = sprintf(to_user_buf_pos, " %-12s |  %lld\n", memx_startup_phase_name[idx], ktime_to_ns(memx_dev->startup_time[idx]));
+		to_user_buf_pos += len;
+		res += len;
+	}
+
+	return res;
+}
+
 static struct kobj_attribute g_memx_sysfs_attr		 = __ATTR_RW(cmd);
 static struct kobj_attribute g_memx_sysfs_debug_attr   = __ATTR_RW(debug);
 static struct kobj_attribute g_memx_sysfs_i2ctrl_attr   = __ATTR_RW(i2ctrl);
@@ -647,6 +733,8 @@ static struct kobj_attribute g_memx_sysfs_mpuuti_attr  = __ATTR_RO(utilization);
 static struct kobj_attribute g_memx_sysfs_temper_attr  = __ATTR_RO(temperature);
 static struct kobj_attribute g_memx_sysfs_thermalthrottling_attr = __ATTR_RW(thermalthrottling);
 static struct kobj_attribute g_memx_sysfs_throughput_attr = __ATTR_RO(throughput);
+static struct kobj_attribute g_memx_sysfs_dfp_download_attr = __ATTR_RW(dfp_download);
+static struct kobj_attribute g_memx_sysfs_startup_attr = __ATTR_RO(startup);
 
 
 s32 memx_fs_sys_init(struct memx_pcie_dev *memx_dev)
@@ -728,6 +816,14 @@ s32 memx_fs_sys_init(struct memx_pcie_dev *memx_dev)
 			pr_err("memryx: memx_fs_sysfs_init: create sysfs attr file failed\n");
 			return -ENOMEM;
 		}
+		if (sysfs_create_file(memx_dev->fs.hif.sys.root_dir, &g_memx_sysfs_dfp_download_attr.attr)) {
+			pr_err("memryx: memx_fs_sysfs_init: create sysfs attr file failed\n");
+			return -ENOMEM;
+		}
+		if (sysfs_create_file(memx_dev->fs.hif.sys.root_dir, &g_memx_sysfs_startup_attr.attr)) {
+			pr_err("memryx: memx_fs_sysfs_init: create sysfs attr file failed\n");
+			return -ENOMEM;
+		}
 	}
 
 	g_kobj_memx_dev_map[memx_dev->minor_index].sys_kobj = memx_dev->fs.hif.sys.root_dir;
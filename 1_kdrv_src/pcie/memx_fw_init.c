@@ -280,6 +280,13 @@ s32 memx_get_hw_info(struct memx_pcie_dev *memx_dev)
 
 	return 0;
 }
+// startup phases are stamped on the probe path only: resume runs firmware init again after MEMX_STARTUP_DONE
+static void memx_startup_stamp(struct memx_pcie_dev *memx_dev, enum memx_startup_phase phase)
+{
+	if (!memx_dev->startup_time[MEMX_STARTUP_DONE])
+		memx_dev->startup_time[phase] = ktime_get();
+}
+
 s32 memx_firmware_init(struct memx_pcie_dev *memx_dev, struct memx_firmware_bin *memx_bin);
 s32 memx_firmware_init(struct memx_pcie_dev *memx_dev, struct memx_firmware_bin *memx_bin)
 {
@@ -296,6 +303,7 @@ s32 memx_firmware_init(struct memx_pcie_dev *memx_dev, struct memx_firmware_bin
 		pr_err("memryx: firmware_init probing: download firmware image failed\n");
 		return ret;
 	}
+	memx_startup_stamp(memx_dev, MEMX_STARTUP_FW_DOWNLOAD);
 
 	// wait for chip boot complete ack only when we first download firmware bin file.
 	if (ret == 0) // PCIe boot
@@ -321,6 +329,7 @@ s32 memx_firmware_init(struct memx_pcie_dev *memx_dev, struct memx_firmware_bin
 			elapsed_ms += sleep_ms;
 		}
 	}
+	memx_startup_stamp(memx_dev, MEMX_STARTUP_FW_BOOT);
 
 	// provide dvfs info change buffer for chips communications
 	memx_sram_write(memx_dev, (MEMX_DBGLOG_CONTROL_BASE+MEMX_DVFS_MPU_UTI_ADDR), MEMX_GET_DVFS_UTIL_BUS_ADDR);
@@ -331,6 +340,7 @@ s32 memx_firmware_init(struct memx_pcie_dev *memx_dev, struct memx_firmware_bin
 		pr_err("memryx: firmware_init probing: get hardware info failed\n");
 		return ret;
 	}
+	memx_startup_stamp(memx_dev, MEMX_STARTUP_HW_INFO);
 
 #ifdef DEBUG
 	dump_firmware_info(memx_dev);
@@ -115,6 +115,29 @@ struct memx_runtime_cfg {
 	enum fw_log_dump_ctrl fw_log_ctrl;
 };
 
+/* end of each probe phase (ktime_get, CLOCK_MONOTONIC) in probe order, shown by fs "startup" */
+enum memx_startup_phase {
+	MEMX_STARTUP_PROBE = 0,
+	MEMX_STARTUP_DEVICE_NODE,
+	MEMX_STARTUP_FS,
+	MEMX_STARTUP_FW_DOWNLOAD,
+	MEMX_STARTUP_FW_BOOT,
+	MEMX_STARTUP_HW_INFO,
+	MEMX_STARTUP_FW_LOG,
+	MEMX_STARTUP_DONE,
+	MEMX_STARTUP_PHASE_MAX,
+};
+
+/* DFP download time spent in the kernel (firmware round trips), shown by fs "dfp_download", cleared by writing "reset" to it */
+struct memx_dfp_download_info {
+	atomic_t wtmem_cnt;
+	atomic_t rgcfg_cnt;
+	atomic_t admin_cnt;
+	atomic64_t wtmem_us;
+	atomic64_t rgcfg_us;
+	atomic64_t admin_us;
+};
+
 struct memx_pcie_dev {
 	struct list_head device_list;
 	struct pci_dev *pDev;
@@ -136,6 +159,9 @@ struct memx_pcie_dev {
 
 	struct memx_file_sys fs;
 
+	ktime_t startup_time[MEMX_STARTUP_PHASE_MAX];
+	struct memx_dfp_download_info dfp_download;
+
 	struct kfifo rx_msix_fifo;
 
 	char devname[16];
@@ -159,6 +185,9 @@ extern u32 tx_size;
 extern u32 rx_size;
 extern struct memx_throughput_info udrv_throughput_info;
 
+extern ktime_t memx_module_init_time;
+extern const char * const memx_startup_phase_name[MEMX_STARTUP_PHASE_MAX];
+
 void memx_pcie_trigger_device_irq(struct memx_pcie_dev *memx_dev, u8 chip_id, enum xflow_mpu_sw_irq_idx sw_irq_idx);
 
 #endif
@@ -0,0 +1,989 @@
+// Copyright (c) 2025 MemryX
+// SPDX-License-Identifier: MIT
+
+// Standalone benchmark and bit-exactness check of the feature map conversions
+// in convert.h. Needs no device and no driver library: build with
+// 'make bench' and run bin/convert_bench on any Linux box.
+//
+//   check: every kernel set, single threaded and split over 1, 4 and the
+//          given thread counts, is compared bit for bit against the baseline
+//          converters kept below as an independent reference, on fuzzed
+//          inputs (NaN, Inf, denormals, rounding ties, tiny block exponents,
+//          random bytes on the wire side) and odd shapes. Special values are
+//          also checked against their exact expected encodings, and the RNE
+//          BF16 encode against the reference for all 2^32 float bit
+//          patterns. Exits with 1 on any mismatch.
+//   bench: times each conversion per kernel set, shape and thread count and
+//          reports ns per float element and GB/s (bytes read + written).
+//
+// usage: convert_bench [-c | -b] [-k kernel] [-t threads,...] [-m min_ms] [-s seed]
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "convert.h"
+
+#define BENCH_FILL     (0xA5) // output prefill, so untouched padding compares equal
+#define BENCH_MAX_HPOC (8)
+#define BENCH_U8_SHIFT (-127.5f)
+#define BENCH_U8_SCALE (1.0f / 127.5f)
+
+typedef struct {
+    int h, w, z, ch;
+    int hpoc; // dummy channels on the GBF side of the hpoc/gather conversions
+} Shape;
+
+enum { IN_F32, IN_U8, IN_WIRE };
+
+typedef struct {
+    const char* name;
+    int in_kind;
+    size_t (*in_bytes)(const Shape*);
+    size_t (*out_bytes)(const Shape*);
+    void (*run)(const Shape*, void* in, void* out);
+    void (*ref)(const Shape*, void* in, void* out); // may modify in
+} Op;
+
+
+//===========================================================================
+// SIZES
+static inline size_t shape_elems(const Shape* s)
+{
+    return (size_t)s->h * s->w * s->z * s->ch;
+}
+
+static inline size_t gbf_bytes(const Shape* s, int num_ch, int row_pad)
+{
+    size_t row = (size_t)s->w * s->z * (((num_ch + 7) / 8) * 10);
+    if (row_pad)
+        row = (row + 3) & ~(size_t)3;
+    return row * s->h;
+}
+
+static size_t f32_bytes(const Shape* s)       { return shape_elems(s) * 4; }
+static size_t u8_bytes(const Shape* s)        { return shape_elems(s); }
+static size_t bf16_bytes(const Shape* s)      { return shape_elems(s) * 2; }
+static size_t gbf_bytes_flat(const Shape* s)  { return gbf_bytes(s, s->ch, 0); }
+static size_t gbf_bytes_pad(const Shape* s)   { return gbf_bytes(s, s->ch, 1); }
+static size_t gbf_bytes_hpoc(const Shape* s)  { return gbf_bytes(s, s->ch + s->hpoc, 1); }
+
+// ascending dummy channel positions spread over the GBF channels
+static void hpoc_indexes(const Shape* s, int* idx)
+{
+    int num_gbf_ch = s->ch + s->hpoc;
+    for (int k = 0; k < s->hpoc; k++)
+        idx[k] = (k * num_gbf_ch) / s->hpoc + 1;
+}
+
+//===========================================================================
+// REFERENCE
+//
+// The scalar converters of the baseline convert.h, from before the kernel
+// sets, so a bug in the shared scalar code of convert.h cannot hide in its
+// own reference. Kept as they were except:
+// - a block shift of 8 or more flushes to zero; the baseline shifted by up to
+//   255, which is undefined and wraps the count on x86,
+// - the HPOC dummy index stops at hpoc_size instead of reading past the table.
+// ref_gbf_encode() rounds its input in place, callers pass a copy.
+static void ref_gbf_encode(uint32_t* __restrict flt32_buffer, uint8_t* __restrict gbf80_buffer, int length)
+{
+    MemxGbfGbf80Map* gbf80_map;
+    MemxGbfFloat32Map* flt32_map;
+    uint8_t* gbf80;
+    uint32_t* flt32;
+    int gbf80_offset = 0;
+    int flt32_offset = 0;
+
+    unsigned char exp;
+    unsigned char man;
+#define _MX_MAX(x, y) (((x) > (y)) ? (x) : (y))
+#define _SET_MANTISSA_SHIFT_WITH_ROUNDING(_exp_shift_)                                                                       \
+    do                                                                                                                       \
+    {                                                                                                                        \
+        if ((_exp_shift_) >= 8)                                                                                              \
+        {                                                                                                                    \
+            man = 0;                                                                                                         \
+        }                                                                                                                    \
+        else if ((_exp_shift_) == 0)                                                                                         \
+        {                                                                                                                    \
+            man = (flt32_map->man == 0x7f) ? (unsigned char)(0x80 | flt32_map->man)                                          \
+                  : (unsigned char)(0x80 | flt32_map->man) + ((flt32_map->zero >> 15) & 0x1);                                \
+        }                                                                                                                    \
+        else                                                                                                                 \
+        {                                                                                                                    \
+            man = (unsigned char)((0x80 | flt32_map->man) >> (_exp_shift_)) + ((flt32_map->man >> ((_exp_shift_)-1)) & 0x1); \
+        }                                                                                                                    \
+    } while (0)
+#define _SET_LANE(_i_, _set_)                                                                                                \
+    do                                                                                                                       \
+    {                                                                                                                        \
+        if (flt32_offset + (_i_) < length) {                                                                                 \
+            flt32_map = (MemxGbfFloat32Map*)(flt32 + (_i_));                                                                 \
+            _SET_MANTISSA_SHIFT_WITH_ROUNDING(exp - flt32_map->exp);                                                         \
+        } else {                                                                                                             \
+            man = 0;                                                                                                         \
+        }                                                                                                                    \
+        _set_;                                                                                                               \
+    } while (0)
+
+    while ((flt32_offset < length)) {
+        gbf80 = gbf80_buffer + gbf80_offset;
+        flt32 = flt32_buffer + flt32_offset;
+
+        // performs float32 to float16 rounding, based on IEEE floating point design
+        for (int i = 0; i < 8; ++i) {
+            if (flt32_offset + i < length) {
+                *(uint32_t*)(flt32 + i) += 0x00008000;
+                *(uint32_t*)(flt32 + i) &= 0xffff0000;
+            }
+        }
+
+        // gets maximum exponent among 8 floating points
+        exp = 0;
+        for (int i = 0; i < 8; ++i) {
+            if (flt32_offset + i < length) {
+                flt32_map = (MemxGbfFloat32Map*)(flt32 + i);
+                exp = _MX_MAX(exp, (unsigned char)flt32_map->exp);
+            }
+        }
+
+        // combines 8 floating points to gbf80
+        gbf80_map = (MemxGbfGbf80Map*)gbf80;
+        gbf80_map->exp = exp;
+        _SET_LANE(0, { gbf80_map->man_0 = man & 0xff; gbf80_map->sign_0 = man ? flt32_map->sign : 0; });
+        _SET_LANE(1, { gbf80_map->man_1 = man & 0xff; gbf80_map->sign_1 = man ? flt32_map->sign : 0; });
+        _SET_LANE(2, { gbf80_map->man_2 = man & 0xff; gbf80_map->sign_2 = man ? flt32_map->sign : 0; });
+        _SET_LANE(3, { gbf80_map->man_3_0 = man & 0x1f; gbf80_map->man_3_1 = (man >> 5) & 0x7;
+                       gbf80_map->sign_3 = man ? flt32_map->sign : 0; });
+        _SET_LANE(4, { gbf80_map->man_4 = man & 0xff; gbf80_map->sign_4 = man ? flt32_map->sign : 0; });
+        _SET_LANE(5, { gbf80_map->man_5 = man & 0xff; gbf80_map->sign_5 = man ? flt32_map->sign : 0; });
+        _SET_LANE(6, { gbf80_map->man_6 = man & 0xff; gbf80_map->sign_6 = man ? flt32_map->sign : 0; });
+        _SET_LANE(7, { gbf80_map->man_7_0 = man & 0x1; gbf80_map->man_7_1 = (man >> 1) & 0x7f;
+                       gbf80_map->sign_7 = man ? flt32_map->sign : 0; });
+
+        gbf80_offset += 10;
+        flt32_offset += 8;
+    }
+#undef _SET_LANE
+#undef _SET_MANTISSA_SHIFT_WITH_ROUNDING
+#undef _MX_MAX
+}
+
+static void ref_gbf_decode(const uint8_t* __restrict gbf80_buffer, uint32_t* __restrict flt32_buffer, unsigned int length)
+{
+    size_t off_f = 0, off_g = 0;
+
+    while (off_f < length) {
+        const uint8_t* in = gbf80_buffer + off_g;
+        uint32_t out[8];
+
+        uint64_t lo = 0;
+        uint16_t hi = 0;
+        memcpy(&lo, in, 8);
+        memcpy(&hi, in+8, 2);
+
+        uint8_t exp = (uint8_t)(hi >> 8);
+
+        for (int k = 0; k < 8; k++) {
+            // sign and 8b 1.m mantissa of lane k, lane 7 spans lo bit 63 and hi[6:0]
+            uint32_t sign = (k < 7) ? (uint32_t)((lo >> (9 * k + 8)) & 1u) : (uint32_t)((hi >> 7) & 1u);
+            uint8_t t = (k < 7) ? (uint8_t)((lo >> (9 * k)) & 0xFF)
+                                : (uint8_t)((((hi & 0x007F) << 1) | ((lo >> 63) & 1u)) & 0xFF);
+            // d = leading zeros in 8 bits (t==0 -> 8), e = sat_sub(exp, d), 0 if t==0
+            int d = t ? __builtin_clz(t) - 24 : 8;
+            uint32_t e = (d < 8 && exp > d) ? (uint32_t)(exp - d) : 0;
+            uint32_t m = ((uint32_t)t << d) & 0x7F;
+            out[k] = (sign << 31) | (e << 23) | (m << 16);
+        }
+        for (unsigned r = 0; r < 8 && off_f + r < length; ++r)
+            flt32_buffer[off_f + r] = out[r];
+
+        off_f += 8;
+        off_g += 10;
+    }
+}
+
+static void ref_convert_gbf(uint32_t* __restrict src, uint8_t* __restrict dst, int tensor_size, int num_ch){
+    int  num_xyz_pixels = (tensor_size / num_ch);
+    int  num_gbf_per_pixel = (num_ch / 8) + ( ((num_ch%8)!=0) ? 1 : 0);
+
+    for(int i = 0; i < num_xyz_pixels; i++){
+        uint8_t *gbf_base = &(dst[ (size_t)i * (num_gbf_per_pixel * 10) ]);
+        uint32_t   *flt_base = (uint32_t*) &(src[ (size_t)i * num_ch ]);
+
+        ref_gbf_encode(flt_base, gbf_base, num_ch);
+    }
+}
+
+static void ref_convert_gbf_row_pad(uint32_t* __restrict src, uint8_t* __restrict dst, int height, int width, int z, int num_ch){
+    int num_gbf_per_pixel = (num_ch / 8) + (((num_ch%8)!=0) ? 1 : 0);
+    int gbf80_pixel_size = num_gbf_per_pixel * 10;
+    int gbf80_row_size = ((width * z * gbf80_pixel_size) + 3) & ~0x3;
+    int flt32_row_size = width * z * num_ch;
+
+    for (int h_idx = 0; h_idx < height; h_idx++) {
+        for (int p = 0; p < width * z; p++) {
+            ref_gbf_encode(src + (size_t)h_idx * flt32_row_size + (size_t)p * num_ch,
+                           dst + (size_t)h_idx * gbf80_row_size + (size_t)p * gbf80_pixel_size, num_ch);
+        }
+    }
+}
+
+static void ref_unconvert_gbf(const uint8_t* __restrict src, uint32_t* __restrict dst, int tensor_size, int num_ch){
+    int num_xyz_pixels = (tensor_size / num_ch);
+    int num_gbf_per_pixel = (num_ch / 8) + ( ((num_ch%8)!=0) ? 1 : 0);
+
+    for(int i = 0; i < num_xyz_pixels; i++)
+        ref_gbf_decode(src + (size_t)i * (num_gbf_per_pixel * 10), dst + (size_t)i * num_ch, num_ch);
+}
+
+static void ref_unconvert_gbf_row_pad(const uint8_t* __restrict src, uint32_t* __restrict dst, int height, int width, int z, int num_ch) {
+    int num_gbf_per_pixel = (num_ch / 8) + (((num_ch%8)!=0) ? 1 : 0);
+    int gbf80_pixel_size = num_gbf_per_pixel * 10;
+    int gbf80_row_size = ((width * z * gbf80_pixel_size) + 3) & ~0x3;
+    int flt32_row_size = width * z * num_ch;
+
+    for (int h_idx = 0; h_idx < height; h_idx++) {
+        for (int p = 0; p < width * z; p++) {
+            ref_gbf_decode(src + (size_t)h_idx * gbf80_row_size + (size_t)p * gbf80_pixel_size,
+                           dst + (size_t)h_idx * flt32_row_size + (size_t)p * num_ch, num_ch);
+        }
+    }
+}
+
+static void ref_unconvert_gbf_hpoc(const uint8_t* __restrict src, uint32_t* __restrict dst, int height, int width, int z, int num_ch, int hpoc_size, const int *hpoc_indexes, int row_pad) {
+    int num_gbf_ch = num_ch + hpoc_size;
+    int num_gbf_per_pixel = (num_gbf_ch / 8) + (((num_gbf_ch%8)!=0) ? 1 : 0);
+    int gbf80_pixel_size = num_gbf_per_pixel * 10;
+    int gbf80_row_size = width * z * gbf80_pixel_size;
+    int flt32_row_size = width * z * num_ch;
+
+    if (row_pad) {
+       gbf80_row_size = (gbf80_row_size + 3) & ~0x3;
+    }
+
+    for (int h_idx = 0; h_idx < height; h_idx++) {
+        for (int p = 0; p < width * z; p++) {
+            const uint8_t *gbf80_pixel = src + (size_t)h_idx * gbf80_row_size + (size_t)p * gbf80_pixel_size;
+            uint32_t *flt32_pixel = dst + (size_t)h_idx * flt32_row_size + (size_t)p * num_ch;
+            int check_dummy_ch_idx = 0;
+            int flt32_buf_offset = 0;
+            // decode for each buf of GBF pixel
+            for (int gbf_ch_idx = 0; gbf_ch_idx < num_gbf_ch; gbf_ch_idx += 8) {
+                uint32_t decode_float_buf[8] = {0};
+                ref_gbf_decode(gbf80_pixel + (gbf_ch_idx / 8) * 10, decode_float_buf, 8);
+
+                for (int ch_offset = 0; ch_offset < 8 && gbf_ch_idx + ch_offset < num_gbf_ch; ++ch_offset) {
+                    // skip dummy channel
+                    if ((check_dummy_ch_idx < hpoc_size) && (gbf_ch_idx + ch_offset == hpoc_indexes[check_dummy_ch_idx])) {
+                        check_dummy_ch_idx++;
+                        continue;
+                    }
+                    flt32_pixel[flt32_buf_offset++] = decode_float_buf[ch_offset];
+                }
+            }
+        }
+    }
+}
+
+static void ref_convert_bf16(const uint32_t* __restrict src, uint8_t* __restrict dst, int tensor_size){
+    for (int i = 0; i < tensor_size; ++i) {
+        uint32_t v = src[i] + 0x00008000u;
+        ((uint16_t*)dst)[i] = (uint16_t)(v >> 16);
+    }
+}
+
+// round to nearest even from the dropped half directly, NaN -> quiet NaN
+static inline uint16_t ref_bf16_rne(uint32_t v)
+{
+    uint32_t hi = v >> 16;
+    uint32_t lo = v & 0xffff;
+
+    if ((v & 0x7f800000u) == 0x7f800000u && (v & 0x007fffffu) != 0)
+        return (uint16_t)(hi | 0x0040u);
+    if (lo > 0x8000u || (lo == 0x8000u && (hi & 1u)))
+        hi++;
+    return (uint16_t)hi;
+}
+
+static void ref_convert_bf16_rne(const uint32_t* __restrict src, uint8_t* __restrict dst, int tensor_size){
+    for (int i = 0; i < tensor_size; ++i)
+        ((uint16_t*)dst)[i] = ref_bf16_rne(src[i]);
+}
+
+static void ref_unconvert_bf16(const uint8_t* __restrict src, uint32_t* __restrict dst, int tensor_size){
+    for (int i = 0; i < tensor_size; ++i)
+        dst[i] = (uint32_t)(((const uint16_t*)src)[i]) << 16;
+}
+
+// interleaved float32 pixels to channel planes
+static void ref_hwc_to_chw(const uint32_t* __restrict src, uint32_t* __restrict dst, size_t num_pixels, int num_ch)
+{
+    for (size_t p = 0; p < num_pixels; p++)
+        for (int c = 0; c < num_ch; c++)
+            dst[(size_t)c * num_pixels + p] = src[p * num_ch + c];
+}
+
+// uint8 input expanded to float32 the way the u8 converters define it
+static uint32_t* ref_u8_to_flt32(const uint8_t* src, size_t count)
+{
+    uint32_t* dst = malloc(count * sizeof(uint32_t) + 1);
+    for (size_t i = 0; dst && i < count; i++) {
+        float f = ((float)src[i] + BENCH_U8_SHIFT) * BENCH_U8_SCALE;
+        memcpy(&dst[i], &f, sizeof(f));
+    }
+    return dst;
+}
+
+
+//===========================================================================
+// OPERATIONS
+static void run_convert_gbf(const Shape* s, void* in, void* out)
+{
+    convert_gbf(in, out, (int)shape_elems(s), s->ch);
+}
+
+static void run_convert_gbf_row_pad(const Shape* s, void* in, void* out)
+{
+    convert_gbf_row_pad(in, out, s->h, s->w, s->z, s->ch);
+}
+
+static void run_unconvert_gbf(const Shape* s, void* in, void* out)
+{
+    unconvert_gbf(in, out, (int)shape_elems(s), s->ch);
+}
+
+static void run_unconvert_gbf_row_pad(const Shape* s, void* in, void* out)
+{
+    unconvert_gbf_row_pad(in, out, s->h, s->w, s->z, s->ch);
+}
+
+static void run_unconvert_gbf_hpoc(const Shape* s, void* in, void* out)
+{
+    int idx[BENCH_MAX_HPOC];
+    hpoc_indexes(s, idx);
+    unconvert_gbf_hpoc(in, out, s->h, s->w, s->z, s->ch, s->hpoc, idx, 1);
+}
+
+static void run_unconvert_gbf_chw(const Shape* s, void* in, void* out)
+{
+    int idx[BENCH_MAX_HPOC];
+    int* gather = malloc((size_t)s->ch * sizeof(int));
+    if (gather == NULL)
+        return;
+    hpoc_indexes(s, idx);
+    gbf_hpoc_gather_table(s->ch, s->hpoc, idx, gather);
+    unconvert_gbf_gather(in, out, s->h, s->w, s->z, s->ch, s->ch + s->hpoc, gather, 1, CONVERT_LAYOUT_CHW);
+    free(gather);
+}
+
+static void run_convert_bf16(const Shape* s, void* in, void* out)
+{
+    convert_bf16(in, out, (int)shape_elems(s));
+}
+
+static void run_convert_bf16_rne(const Shape* s, void* in, void* out)
+{
+    convert_set_bf16_rounding(CONVERT_BF16_ROUND_NEAREST_EVEN);
+    convert_bf16(in, out, (int)shape_elems(s));
+    convert_set_bf16_rounding(CONVERT_BF16_ROUND_HALF_UP);
+}
+
+static void run_unconvert_bf16(const Shape* s, void* in, void* out)
+{
+    unconvert_bf16(in, out, (int)shape_elems(s));
+}
+
+static void run_unconvert_bf16_chw(const Shape* s, void* in, void* out)
+{
+    unconvert_bf16_chw(in, out, (int)shape_elems(s), s->ch);
+}
+
+static void run_convert_gbf_u8(const Shape* s, void* in, void* out)
+{
+    convert_gbf_u8(in, out, (int)shape_elems(s), s->ch, BENCH_U8_SHIFT, BENCH_U8_SCALE);
+}
+
+static void run_convert_gbf_row_pad_u8(const Shape* s, void* in, void* out)
+{
+    convert_gbf_row_pad_u8(in, out, s->h, s->w, s->z, s->ch, BENCH_U8_SHIFT, BENCH_U8_SCALE);
+}
+
+static void run_convert_bf16_u8(const Shape* s, void* in, void* out)
+{
+    convert_bf16_u8(in, out, (int)shape_elems(s), BENCH_U8_SHIFT, BENCH_U8_SCALE);
+}
+
+// reference of each operation, same arguments
+static void ref_run_convert_gbf(const Shape* s, void* in, void* out)
+{
+    ref_convert_gbf(in, out, (int)shape_elems(s), s->ch);
+}
+
+static void ref_run_convert_gbf_row_pad(const Shape* s, void* in, void* out)
+{
+    ref_convert_gbf_row_pad(in, out, s->h, s->w, s->z, s->ch);
+}
+
+static void ref_run_unconvert_gbf(const Shape* s, void* in, void* out)
+{
+    ref_unconvert_gbf(in, out, (int)shape_elems(s), s->ch);
+}
+
+static void ref_run_unconvert_gbf_row_pad(const Shape* s, void* in, void* out)
+{
+    ref_unconvert_gbf_row_pad(in, out, s->h, s->w, s->z, s->ch);
+}
+
+static void ref_run_unconvert_gbf_hpoc(const Shape* s, void* in, void* out)
+{
+    int idx[BENCH_MAX_HPOC];
+    hpoc_indexes(s, idx);
+    ref_unconvert_gbf_hpoc(in, out, s->h, s->w, s->z, s->ch, s->hpoc, idx, 1);
+}
+
+static void ref_run_unconvert_gbf_chw(const Shape* s, void* in, void* out)
+{
+    uint32_t* hwc = malloc(shape_elems(s) * sizeof(uint32_t) + 1);
+    if (hwc == NULL)
+        return;
+    ref_run_unconvert_gbf_hpoc(s, in, hwc);
+    ref_hwc_to_chw(hwc, out, shape_elems(s) / s->ch, s->ch);
+    free(hwc);
+}
+
+static void ref_run_convert_bf16(const Shape* s, void* in, void* out)
+{
+    ref_convert_bf16(in, out, (int)shape_elems(s));
+}
+
+static void ref_run_convert_bf16_rne(const Shape* s, void* in, void* out)
+{
+    ref_convert_bf16_rne(in, out, (int)shape_elems(s));
+}
+
+static void ref_run_unconvert_bf16(const Shape* s, void* in, void* out)
+{
+    ref_unconvert_bf16(in, out, (int)shape_elems(s));
+}
+
+static void ref_run_unconvert_bf16_chw(const Shape* s, void* in, void* out)
+{
+    uint32_t* hwc = malloc(shape_elems(s) * sizeof(uint32_t) + 1);
+    if (hwc == NULL)
+        return;
+    ref_unconvert_bf16(in, hwc, (int)shape_elems(s));
+    ref_hwc_to_chw(hwc, out, shape_elems(s) / s->ch, s->ch);
+    free(hwc);
+}
+
+static void ref_run_convert_gbf_u8(const Shape* s, void* in, void* out)
+{
+    uint32_t* f = ref_u8_to_flt32(in, shape_elems(s));
+    if (f == NULL)
+        return;
+    ref_convert_gbf(f, out, (int)shape_elems(s), s->ch);
+    free(f);
+}
+
+static void ref_run_convert_gbf_row_pad_u8(const Shape* s, void* in, void* out)
+{
+    uint32_t* f = ref_u8_to_flt32(in, shape_elems(s));
+    if (f == NULL)
+        return;
+    ref_convert_gbf_row_pad(f, out, s->h, s->w, s->z, s->ch);
+    free(f);
+}
+
+static void ref_run_convert_bf16_u8(const Shape* s, void* in, void* out)
+{
+    uint32_t* f = ref_u8_to_flt32(in, shape_elems(s));
+    if (f == NULL)
+        return;
+    ref_convert_bf16(f, out, (int)shape_elems(s));
+    free(f);
+}
+
+static const Op ops[] = {
+    { "convert_gbf",            IN_F32,  f32_bytes,      gbf_bytes_flat, run_convert_gbf,            ref_run_convert_gbf            },
+    { "convert_gbf_row_pad",    IN_F32,  f32_bytes,      gbf_bytes_pad,  run_convert_gbf_row_pad,    ref_run_convert_gbf_row_pad    },
+    { "unconvert_gbf",          IN_WIRE, gbf_bytes_flat, f32_bytes,      run_unconvert_gbf,          ref_run_unconvert_gbf          },
+    { "unconvert_gbf_row_pad",  IN_WIRE, gbf_bytes_pad,  f32_bytes,      run_unconvert_gbf_row_pad,  ref_run_unconvert_gbf_row_pad  },
+    { "unconvert_gbf_hpoc",     IN_WIRE, gbf_bytes_hpoc, f32_bytes,      run_unconvert_gbf_hpoc,     ref_run_unconvert_gbf_hpoc     },
+    { "unconvert_gbf_chw",      IN_WIRE, gbf_bytes_hpoc, f32_bytes,      run_unconvert_gbf_chw,      ref_run_unconvert_gbf_chw      },
+    { "convert_bf16",           IN_F32,  f32_bytes,      bf16_bytes,     run_convert_bf16,           ref_run_convert_bf16           },
+    { "convert_bf16_rne",       IN_F32,  f32_bytes,      bf16_bytes,     run_convert_bf16_rne,       ref_run_convert_bf16_rne       },
+    { "unconvert_bf16",         IN_WIRE, bf16_bytes,     f32_bytes,      run_unconvert_bf16,         ref_run_unconvert_bf16         },
+    { "unconvert_bf16_chw",     IN_WIRE, bf16_bytes,     f32_bytes,      run_unconvert_bf16_chw,     ref_run_unconvert_bf16_chw     },
+    { "convert_gbf_u8",         IN_U8,   u8_bytes,       gbf_bytes_flat, run_convert_gbf_u8,         ref_run_convert_gbf_u8         },
+    { "convert_gbf_row_pad_u8", IN_U8,   u8_bytes,       gbf_bytes_pad,  run_convert_gbf_row_pad_u8, ref_run_convert_gbf_row_pad_u8 },
+    { "convert_bf16_u8",        IN_U8,   u8_bytes,       bf16_bytes,     run_convert_bf16_u8,        ref_run_convert_bf16_u8        },
+};
+#define NUM_OPS ((int)(sizeof(ops) / sizeof(ops[0])))
+
+// odd channel counts, 3 channels, whole-block counts, wide pixels and z > 1
+static const Shape check_shapes[] = {
+    { 1, 1, 1, 1, 0 },    { 3, 5, 1, 3, 1 },    { 4, 7, 2, 3, 0 },   { 5, 3, 1, 5, 3 },
+    { 2, 9, 1, 8, 0 },    { 3, 4, 1, 11, 2 },   { 6, 5, 1, 16, 4 },  { 2, 3, 3, 24, 0 },
+    { 4, 4, 1, 32, 8 },   { 3, 3, 1, 64, 0 },   { 2, 2, 2, 128, 1 }, { 2, 3, 1, 200, 5 },
+    { 2, 2, 1, 1030, 2 }, { 1, 1, 1, 2500, 0 }, { 37, 41, 1, 3, 1 }, { 17, 13, 1, 16, 0 },
+};
+#define NUM_CHECK_SHAPES ((int)(sizeof(check_shapes) / sizeof(check_shapes[0])))
+
+static const Shape bench_shapes[] = {
+    { 224, 224, 1, 3, 1 },   // classifier input
+    { 1080, 1920, 1, 3, 1 }, // 1080p RGB frame
+    { 56, 56, 1, 64, 0 },
+    { 28, 28, 1, 128, 2 },
+    { 14, 14, 1, 512, 0 },
+    { 80, 80, 1, 85, 3 },    // detection head
+};
+#define NUM_BENCH_SHAPES ((int)(sizeof(bench_shapes) / sizeof(bench_shapes[0])))
+
+
+//===========================================================================
+// INPUTS
+static inline uint64_t rnd64(uint64_t* state)
+{
+    // xorshift64*
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1Dull;
+}
+
+static const uint32_t f32_specials[] = {
+    0x00000000, 0x80000000, // +-0
+    0x7f800000, 0xff800000, // +-Inf
+    0x7fc00000, 0xffc00000, // quiet NaN
+    0x7f800001, 0x7fffffff, // signaling NaN, NaN with all mantissa bits
+    0x00000001, 0x007fffff, 0x80400000, // denormals
+    0x7f7fffff, 0xff7fffff, // max finite, rounds up to Inf
+    0x3f7fffff, 0x3fffffff, // bfloat16 rounding carries into the exponent
+    0x3f808000, 0x3f818000, 0x3f807fff, // ties and just below
+};
+#define NUM_F32_SPECIALS ((int)(sizeof(f32_specials) / sizeof(f32_specials[0])))
+
+static uint32_t fuzz_f32(uint64_t* state)
+{
+    uint64_t r = rnd64(state);
+    uint32_t bits = (uint32_t)(r >> 32);
+
+    switch (r & 15) {
+    case 0:  // any bit pattern
+        return bits;
+    case 1:
+        return f32_specials[bits % NUM_F32_SPECIALS];
+    case 2:  // denormal
+        return bits & 0x807fffffu;
+    case 3:  // exponent 1..7, so the block exponent may be below 8
+        return (bits & 0x807fffffu) | ((1u + (bits >> 8) % 7u) << 23);
+    case 4:  // exactly halfway between two bfloat16 values
+        return (bits & 0xffff0000u) | 0x8000u;
+    default: // activations: exponents spread around 1.0
+        return (bits & 0x807fffffu) | ((112u + (bits >> 8) % 24u) << 23);
+    }
+}
+
+static void fill_input(int kind, void* buf, size_t bytes, uint64_t* state)
+{
+    if (kind == IN_F32) {
+        uint32_t* f = buf;
+        for (size_t i = 0; i < bytes / 4; i++)
+            f[i] = fuzz_f32(state);
+    } else {
+        uint8_t* b = buf;
+        for (size_t i = 0; i < bytes; i++)
+            b[i] = (uint8_t)(rnd64(state) >> 56);
+    }
+}
+
+static inline double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void* alloc_buf(size_t bytes)
+{
+    void* p = aligned_alloc(64, (bytes + 63) & ~(size_t)63);
+    if (p == NULL) {
+        fprintf(stderr, "out of memory (%zu bytes)\n", bytes);
+        exit(2);
+    }
+    return p;
+}
+
+
+//===========================================================================
+// CHECK
+static int check_shape(const Op* op, const Shape* s, const int* threads, int num_threads, uint64_t* state)
+{
+    size_t in_size = op->in_bytes(s);
+    size_t out_size = op->out_bytes(s);
+    uint8_t* in = alloc_buf(in_size);
+    uint8_t* ref_in = alloc_buf(in_size);
+    uint8_t* ref = alloc_buf(out_size + 16); // the reference encoder writes GBF80 blocks as 12 byte words
+    uint8_t* out = alloc_buf(out_size);
+    int failures = 0;
+
+    fill_input(op->in_kind, in, in_size, state);
+
+    memcpy(ref_in, in, in_size);
+    memset(ref, BENCH_FILL, out_size + 16);
+    op->ref(s, ref_in, ref);
+
+    for (int k = 0; k < CONVERT_KERNELS_NUM; k++) {
+        const ConvertKernels* kernels = &convert_kernels_table[k];
+        if (convert_kernels_select(kernels->name) != 0)
+            continue;
+        for (int t = 0; t < num_threads; t++) {
+            // threshold 0 splits even the smallest tensors
+            convert_set_threads(threads[t], 0);
+            memset(out, BENCH_FILL, out_size);
+            op->run(s, in, out);
+            if (memcmp(ref, out, out_size) == 0)
+                continue;
+
+            size_t i = 0;
+            while (ref[i] == out[i])
+                i++;
+            printf("MISMATCH %-22s %-6s threads %d  %dx%dx%dx%d hpoc %d  byte %zu: %02x != %02x\n",
+                   op->name, kernels->name, threads[t], s->h, s->w, s->z, s->ch, s->hpoc, i, out[i], ref[i]);
+            failures++;
+        }
+    }
+
+    free(out);
+    free(ref);
+    free(ref_in);
+    free(in);
+    return failures;
+}
+
+// exact BF16 encodings of the special values
+typedef struct {
+    uint32_t in;
+    uint16_t half_up; // default rounding
+    uint16_t rne;     // CONVERT_BF16_ROUND_NEAREST_EVEN
+} Bf16Special;
+
+static const Bf16Special bf16_specials[] = {
+    { 0x00000000, 0x0000, 0x0000 }, { 0x80000000, 0x8000, 0x8000 }, // +-0
+    { 0x7f800000, 0x7f80, 0x7f80 }, { 0xff800000, 0xff80, 0xff80 }, // +-Inf stays Inf
+    { 0x7fc00000, 0x7fc0, 0x7fc0 }, { 0xffc00000, 0xffc0, 0xffc0 }, // quiet NaN
+    { 0x7f800001, 0x7f80, 0x7fc0 }, // signaling NaN: truncates to Inf half up, quieted RNE
+    { 0xff808000, 0xff81, 0xffc0 }, // signaling NaN on a tie
+    { 0x7fffffff, 0x8000, 0x7fff }, // NaN with all mantissa bits: carries into the sign half up
+    { 0x00000001, 0x0000, 0x0000 }, { 0x00008000, 0x0001, 0x0000 }, // denormals flush or round
+    { 0x00018000, 0x0002, 0x0002 }, { 0x007fffff, 0x0080, 0x0080 }, // like any other value
+    { 0x80400000, 0x8040, 0x8040 },
+    { 0x7f7fffff, 0x7f80, 0x7f80 }, { 0xff7fffff, 0xff80, 0xff80 }, // max finite rounds to Inf
+    { 0x7f7f8000, 0x7f80, 0x7f80 }, // tie on an odd value, rounds up to Inf
+    { 0x3f808000, 0x3f81, 0x3f80 }, { 0x3f818000, 0x3f82, 0x3f82 }, // ties: up / to even
+    { 0xbf808000, 0xbf81, 0xbf80 }, { 0xbf818000, 0xbf82, 0xbf82 },
+    { 0x3f807fff, 0x3f80, 0x3f80 }, { 0x3f808001, 0x3f81, 0x3f81 }, // just below / above a tie
+    { 0x3f7fffff, 0x3f80, 0x3f80 }, // rounding carries into the exponent
+};
+#define NUM_BF16_SPECIALS ((int)(sizeof(bf16_specials) / sizeof(bf16_specials[0])))
+
+// GBF80 blocks of special values: the shared exponent and the floats read back
+typedef struct {
+    const char* what;
+    uint32_t in[8];
+    uint8_t exp;
+    uint32_t out[8];
+} GbfSpecial;
+
+static const GbfSpecial gbf_specials[] = {
+    { "NaN takes the block, the rest flushes",
+      { 0x3f800000, 0x7fc00000 }, 0xff, { 0x00000000, 0x7fc00000 } },
+    { "+-Inf stays Inf",
+      { 0x7f800000, 0xff800000 }, 0xff, { 0x7f800000, 0xff800000 } },
+    { "max finite rounds to Inf",
+      { 0x7f7fffff, 0xff7fffff }, 0xff, { 0x7f800000, 0xff800000 } },
+    { "NaN with all mantissa bits carries to -0 and flushes",
+      { 0x7fffffff, 0x3f800000 }, 0x7f, { 0x00000000, 0x3f800000 } },
+    { "denormals alone keep their top mantissa bits",
+      { 0x00000001, 0x007fffff, 0x80400000 }, 0x01, { 0x00000000, 0x00800000, 0x80400000 } },
+    { "denormals next to a normal flush to +0",
+      { 0x3f800000, 0x00400000, 0x80000001 }, 0x7f, { 0x3f800000, 0x00000000, 0x00000000 } },
+    { "bfloat16 and block shift round half up",
+      { 0x3f808000, 0x3f807fff, 0x3f7fffff, 0x40000000, 0x3f810000 }, 0x80,
+      { 0x3f820000, 0x3f800000, 0x3f800000, 0x40000000, 0x3f820000 } },
+    { "a flushed lane drops its sign",
+      { 0x43800000, 0xbf800000, 0xc3000000 }, 0x87, { 0x43800000, 0x00000000, 0xc3000000 } },
+};
+#define NUM_GBF_SPECIALS ((int)(sizeof(gbf_specials) / sizeof(gbf_specials[0])))
+
+// special values against their expected encodings, on every kernel set
+static int check_specials(void)
+{
+    // every value at every lane position of the vector bodies and the tails
+    const int n = NUM_BF16_SPECIALS * 17;
+    uint32_t in[NUM_BF16_SPECIALS * 17];
+    uint16_t out[NUM_BF16_SPECIALS * 17];
+    int failures = 0;
+    int cases = 0;
+
+    for (int i = 0; i < n; i++)
+        in[i] = bf16_specials[i % NUM_BF16_SPECIALS].in;
+
+    for (int k = 0; k < CONVERT_KERNELS_NUM; k++) {
+        const ConvertKernels* kernels = &convert_kernels_table[k];
+        if (convert_kernels_select(kernels->name) != 0)
+            continue;
+        convert_set_threads(1, 0);
+
+        for (int rne = 0; rne <= 1; rne++) {
+            convert_set_bf16_rounding(rne ? CONVERT_BF16_ROUND_NEAREST_EVEN : CONVERT_BF16_ROUND_HALF_UP);
+            convert_bf16(in, (uint8_t*)out, n);
+            convert_set_bf16_rounding(CONVERT_BF16_ROUND_HALF_UP);
+            for (int i = 0; i < n; i++) {
+                const Bf16Special* sp = &bf16_specials[i % NUM_BF16_SPECIALS];
+                uint16_t want = rne ? sp->rne : sp->half_up;
+                cases++;
+                if (out[i] == want)
+                    continue;
+                printf("SPECIAL  convert_bf16%-4s %-6s element %d: %08x -> %04x, expected %04x\n",
+                       rne ? "_rne" : "", kernels->name, i, sp->in, out[i], want);
+                failures++;
+            }
+        }
+
+        for (int b = 0; b < NUM_GBF_SPECIALS; b++) {
+            const GbfSpecial* sp = &gbf_specials[b];
+            uint8_t gbf[10];
+            uint32_t back[8];
+
+            convert_gbf(sp->in, gbf, 8, 8);
+            unconvert_gbf(gbf, back, 8, 8);
+            cases++;
+            if (gbf[9] == sp->exp && memcmp(back, sp->out, sizeof(back)) == 0)
+                continue;
+            printf("SPECIAL  gbf80 %-6s %s: exponent %02x (expected %02x), read back", kernels->name, sp->what, gbf[9], sp->exp);
+            for (int i = 0; i < 8; i++)
+                printf(" %08x%s", back[i], (back[i] == sp->out[i]) ? "" : "!");
+            printf("\n");
+            failures++;
+        }
+    }
+    printf("specials: %d cases, %d mismatches\n", cases, failures);
+    return failures;
+}
+
+// RNE encode of all 2^32 float bit patterns against the reference, on every kernel set
+static int check_bf16_rne_exhaustive(void)
+{
+    const int chunk = 1 << 20;
+    uint32_t* in = alloc_buf((size_t)chunk * 4);
+    uint16_t* ref = alloc_buf((size_t)chunk * 2);
+    uint16_t* out = alloc_buf((size_t)chunk * 2);
+    int failures = 0;
+    double start = now_sec();
+
+    convert_set_threads(1, 0);
+    convert_set_bf16_rounding(CONVERT_BF16_ROUND_NEAREST_EVEN);
+    for (uint64_t base = 0; base < (1ull << 32); base += chunk) {
+        for (int i = 0; i < chunk; i++)
+            in[i] = (uint32_t)(base + i);
+        ref_convert_bf16_rne(in, (uint8_t*)ref, chunk);
+
+        for (int k = 0; k < CONVERT_KERNELS_NUM; k++) {
+            const ConvertKernels* kernels = &convert_kernels_table[k];
+            if (convert_kernels_select(kernels->name) != 0)
+                continue;
+            convert_bf16(in, (uint8_t*)out, chunk);
+            if (memcmp(ref, out, (size_t)chunk * 2) == 0)
+                continue;
+
+            int i = 0;
+            while (ref[i] == out[i])
+                i++;
+            if (failures++ < 16)
+                printf("MISMATCH convert_bf16_rne %-6s %08x -> %04x, expected %04x\n", kernels->name, in[i], out[i], ref[i]);
+        }
+    }
+    convert_set_bf16_rounding(CONVERT_BF16_ROUND_HALF_UP);
+    printf("bf16 rne: all 2^32 inputs, %d mismatching chunks (%.1f s)\n", failures, now_sec() - start);
+
+    free(out);
+    free(ref);
+    free(in);
+    return failures;
+}
+
+static int run_check(const int* threads, int num_threads, int rounds, uint64_t seed)
+{
+    uint64_t state = seed;
+    int failures = check_specials() + check_bf16_rne_exhaustive();
+    int cases = 0;
+
+    for (int r = 0; r < rounds; r++) {
+        for (int o = 0; o < NUM_OPS; o++) {
+            for (int i = 0; i < NUM_CHECK_SHAPES; i++) {
+                failures += check_shape(&ops[o], &check_shapes[i], threads, num_threads, &state);
+                cases++;
+            }
+        }
+    }
+    printf("check: %d cases, %d mismatches\n", cases, failures);
+    return failures;
+}
+
+
+//===========================================================================
+// BENCHMARK
+static void run_bench(const char* kernel, const int* threads, int num_threads, double min_sec, uint64_t seed)
+{
+    uint64_t state = seed;
+
+    printf("%-7s %4s  %-22s %-16s %10s %9s\n", "kernel", "thr", "conversion", "shape", "ns/elem", "GB/s");
+    for (int k = 0; k < CONVERT_KERNELS_NUM; k++) {
+        const ConvertKernels* kernels = &convert_kernels_table[k];
+        if (kernel && strcmp(kernel, kernels->name) != 0)
+            continue;
+        if (convert_kernels_select(kernels->name) != 0)
+            continue;
+
+        for (int i = 0; i < NUM_BENCH_SHAPES; i++) {
+            const Shape* s = &bench_shapes[i];
+            char shape_name[32];
+            snprintf(shape_name, sizeof(shape_name), "%dx%dx%d", s->h, s->w, s->ch);
+
+            for (int o = 0; o < NUM_OPS; o++) {
+                const Op* op = &ops[o];
+                size_t in_size = op->in_bytes(s);
+                size_t out_size = op->out_bytes(s);
+                uint8_t* in = alloc_buf(in_size);
+                uint8_t* out = alloc_buf(out_size);
+
+                fill_input(op->in_kind, in, in_size, &state);
+                memset(out, 0, out_size);
+
+                for (int t = 0; t < num_threads; t++) {
+                    convert_set_threads(threads[t], 0);
+                    op->run(s, in, out); // warm up caches and the thread pool
+
+                    long iters = 0;
+                    double start = now_sec();
+                    double elapsed;
+                    do {
+                        op->run(s, in, out);
+                        iters++;
+                        elapsed = now_sec() - start;
+                    } while (elapsed < min_sec);
+
+                    double per_call = elapsed / (double)iters;
+                    printf("%-7s %4d  %-22s %-16s %10.3f %9.2f\n", kernels->name, threads[t], op->name, shape_name,
+                           per_call * 1e9 / (double)shape_elems(s), (double)(in_size + out_size) / per_call * 1e-9);
+                }
+                free(out);
+                free(in);
+            }
+        }
+    }
+}
+
+
+//===========================================================================
+// MAIN
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "usage: %s [-c | -b] [-k kernel] [-t threads,...] [-m min_ms] [-r rounds] [-s seed]\n"
+            "  -c  bit-exactness check only\n"
+            "  -b  benchmark only (default runs the check, then the benchmark)\n"
+            "  -k  benchmark one kernel set: avx512, avx2, neon or scalar (default all supported)\n"
+            "  -t  comma separated thread counts (default 1 and the OpenMP maximum),\n"
+            "      the check adds 1 and 4\n"
+            "  -m  minimum time per measurement in ms (default 200)\n"
+            "  -r  check rounds with fresh fuzzed inputs (default 4)\n"
+            "  -s  random seed\n",
+            prog);
+}
+
+int main(int argc, char** argv)
+{
+    int do_check = 1;
+    int do_bench = 1;
+    const char* kernel = NULL;
+    int threads[16];
+    int num_threads = 0;
+    double min_sec = 0.2;
+    int rounds = 4;
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "cbk:t:m:r:s:h")) != -1) {
+        switch (opt) {
+        case 'c':
+            do_bench = 0;
+            break;
+        case 'b':
+            do_check = 0;
+            break;
+        case 'k':
+            kernel = optarg;
+            break;
+        case 't':
+            for (char* tok = strtok(optarg, ","); tok && num_threads < 16; tok = strtok(NULL, ",")) {
+                int n = atoi(tok);
+                if (n > 0)
+                    threads[num_threads++] = n;
+            }
+            break;
+        case 'm':
+            min_sec = atof(optarg) * 1e-3;
+            break;
+        case 'r':
+            rounds = atoi(optarg);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 0) | 1; // xorshift state must be non-zero
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    if (num_threads == 0) {
+        threads[num_threads++] = 1;
+     #ifdef _OPENMP
+        if (omp_get_max_threads() > 1)
+            threads[num_threads++] = omp_get_max_threads();
+     #endif
+    }
+    if (kernel && convert_kernels_select(kernel) != 0) {
+        fprintf(stderr, "kernel set '%s' is unknown or not supported on this CPU\n", kernel);
+        return 2;
+    }
+
+    printf("kernel sets:");
+    for (int k = 0; k < CONVERT_KERNELS_NUM; k++) {
+        if (convert_kernels_supported(&convert_kernels_table[k]))
+            printf(" %s", convert_kernels_table[k].name);
+    }
+    printf("\n");
+
+    // the check always splits over 1 and 4 threads, whatever the core count
+    int check_threads[18] = { 1, 4 };
+    int num_check_threads = 2;
+    for (int t = 0; t < num_threads; t++) {
+        if (threads[t] != 1 && threads[t] != 4)
+            check_threads[num_check_threads++] = threads[t];
+    }
+
+    if (do_check && run_check(check_threads, num_check_threads, rounds, seed) != 0)
+        return 1;
+    if (do_bench)
+        run_bench(kernel, threads, num_threads, min_sec, seed);
+    return 0;
+}
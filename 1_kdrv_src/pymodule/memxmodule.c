@@ -22,6 +22,8 @@
 // has all the gbf convert stuff
 #include "convert.h"
 
+#include <time.h>
+
 /***************************************************************************//**
  * constant wrapper
  ******************************************************************************/
@@ -29,6 +31,12 @@ const int _wrap_memx_fmap_format_float32 = MEMX_FMAP_FORMAT_FLOAT32;
 const int _wrap_memx_fmap_format_raw = MEMX_FMAP_FORMAT_RAW;
 const int _wrap_memx_fmap_format_gbf80 = MEMX_FMAP_FORMAT_GBF80;
 
+const int _wrap_memx_fmap_layout_hwc = CONVERT_LAYOUT_HWC;
+const int _wrap_memx_fmap_layout_chw = CONVERT_LAYOUT_CHW;
+
+const int _wrap_memx_bf16_round_half_up = CONVERT_BF16_ROUND_HALF_UP;
+const int _wrap_memx_bf16_round_nearest_even = CONVERT_BF16_ROUND_NEAREST_EVEN;
+
 const int _wrap_memx_download_type_from_buffer = MEMX_DOWNLOAD_TYPE_FROM_BUFFER;
 const int _wrap_memx_download_type_wtmem_legacy = MEMX_DOWNLOAD_TYPE_WTMEM_LEGACY;
 const int _wrap_memx_download_type_wtmem = MEMX_DOWNLOAD_TYPE_WTMEM;
@@ -65,6 +73,281 @@ const int _wrap_memx_boot_mode_uart   = MXMX_BOOT_MODE_UART;
 const int _wrap_memx_chip_version_a0    = MXMX_CHIP_VERSION_A0;
 const int _wrap_memx_chip_version_a1    = MXMX_CHIP_VERSION_A1;
 
+/***************************************************************************//**
+ * per-flow cache
+ *  - shape/format/hpoc of each (model, flow, direction) is queried from the
+ *    library once and kept until the model is closed or re-downloaded
+ *  - each flow owns a cache-line aligned staging buffer for the formatted
+ *    (GBF80/BF16) data, reused across frames instead of malloc/free per call
+ *  - lookup/release/invalidate/config run under _flow_lock, only ever taken
+ *    with the GIL released and never held across a library call: a stale
+ *    entry is claimed under the lock, refilled outside it and installed
+ *    back; a flow already busy in another thread gets a private uncached entry
+ *  - every invalidate or config change bumps the model generation, which
+ *    mxa.Model flow entries (see model object) compare against
+ *  - uint8 frames on GBF80/BF16 input flows are encoded directly, expanded as
+ *    (x + shift) * scale with the flow's transform (identity unless set)
+ *  - output flows with hpoc channels or a CHW layout decode through a gather
+ *    table built once here
+ ******************************************************************************/
+#define MXA_FLOW_CACHE_MAX_FLOW (32)
+#define MXA_FLOW_IFMAP (0)
+#define MXA_FLOW_OFMAP (1)
+#define MXA_STAGING_ALIGN (64)
+
+typedef struct _MxaFlowCache {
+  int valid; // metadata below is up to date
+  int busy; // staging buffer in use by a stream call with GIL released
+  uint8_t chip_gen;
+  int height, width, z, num_ch, format, tensor_size;
+  int hpoc_size;
+  int num_gbf_ch; // num_ch + hpoc_size
+  int layout; // CONVERT_LAYOUT_HWC/CHW of the host ofmap
+  int* gather; // GBF80 channel of each of the num_ch output channels, NULL if identity HWC
+  int fmt_size; // formatted bytes per frame, 0 if no conversion
+  int data_size; // bytes written by the encoder, fmt_size minus alignment padding
+  uint8_t* staging; // MXA_STAGING_ALIGN aligned, zero-initialized once
+  float u8_shift, u8_scale; // transform of uint8 input frames
+} MxaFlowCache;
+
+// user settings of a flow
+typedef struct _MxaFlowConfig {
+  int u8_set; // uint8 input transform, identity unless set
+  float u8_shift, u8_scale;
+  int layout; // CONVERT_LAYOUT_HWC (0) unless set
+} MxaFlowConfig;
+
+static MxaFlowCache _flow_cache[MEMX_MODEL_MAX_NUMBER][MXA_FLOW_CACHE_MAX_FLOW][2];
+// kept across re-downloads, cleared on open/close
+static MxaFlowConfig _flow_config[MEMX_MODEL_MAX_NUMBER][MXA_FLOW_CACHE_MAX_FLOW];
+static unsigned int _flow_cache_gen[MEMX_MODEL_MAX_NUMBER];
+static PyThread_type_lock _flow_lock; // allocated at module init
+
+static void _flow_cache_bump(uint8_t model_id)
+{
+  __atomic_add_fetch(&_flow_cache_gen[model_id], 1, __ATOMIC_RELEASE);
+}
+
+static void _flow_cache_free(MxaFlowCache* flow)
+{
+  free(flow->staging);
+  free(flow->gather);
+  flow->staging = NULL;
+  flow->gather = NULL;
+}
+
+// queries the library into 'flow'; called without GIL and without _flow_lock
+static memx_status _flow_cache_fill(MxaFlowCache* flow, uint8_t model_id, uint8_t flow_id, int dir)
+{
+  memx_status status;
+  int num_gbf_ch, num_gbf_per_pixel;
+
+  memset(flow, 0, sizeof(*flow));
+  flow->u8_scale = 1.0f;
+  if(model_id < MEMX_MODEL_MAX_NUMBER && flow_id < MXA_FLOW_CACHE_MAX_FLOW) {
+    MxaFlowConfig config;
+    PyThread_acquire_lock(_flow_lock, WAIT_LOCK);
+    config = _flow_config[model_id][flow_id];
+    PyThread_release_lock(_flow_lock);
+    if(dir == MXA_FLOW_IFMAP && config.u8_set) {
+      flow->u8_shift = config.u8_shift;
+      flow->u8_scale = config.u8_scale;
+    }
+    if(dir == MXA_FLOW_OFMAP)
+      flow->layout = config.layout;
+  }
+  status = memx_get_chip_gen(model_id, &flow->chip_gen);
+  if(status != MEMX_STATUS_OK)
+    return status;
+  // no conversion on cascade
+  if(flow->chip_gen != MEMX_DEVICE_CASCADE_PLUS)
+    return MEMX_STATUS_OK;
+
+  if(dir == MXA_FLOW_IFMAP)
+    status = memx_get_ifmap_size(model_id, flow_id, &flow->height, &flow->width, &flow->z, &flow->num_ch, &flow->format);
+  else
+    status = memx_get_ofmap_size(model_id, flow_id, &flow->height, &flow->width, &flow->z, &flow->num_ch, &flow->format);
+  if(memx_status_error(status))
+    return status;
+  flow->tensor_size = flow->height*flow->width*flow->z*flow->num_ch;
+
+  // output ports may carry dummy (hpoc) channels inside the gbf data
+  num_gbf_ch = flow->num_ch;
+  if(dir == MXA_FLOW_OFMAP && (flow->format == MEMX_FMAP_FORMAT_GBF80 || flow->format == MEMX_FMAP_FORMAT_GBF80_ROW_PAD)) {
+    int hpoc_size = 0;
+    int* hpoc_indexes = NULL;
+    status = memx_get_ofmap_hpoc(model_id, flow_id, &hpoc_size, &hpoc_indexes);
+    if(memx_status_no_error(status) && hpoc_size > 0 && hpoc_indexes) {
+      num_gbf_ch += hpoc_size;
+      flow->hpoc_size = hpoc_size;
+    }
+    status = MEMX_STATUS_OK;
+
+    if(flow->hpoc_size > 0 || flow->layout == CONVERT_LAYOUT_CHW) {
+      flow->gather = malloc(flow->num_ch * sizeof(int));
+      if(flow->gather == NULL)
+        return MEMX_STATUS_OTHERS;
+      gbf_hpoc_gather_table(flow->num_ch, flow->hpoc_size, hpoc_indexes, flow->gather);
+    }
+  }
+  flow->num_gbf_ch = num_gbf_ch;
+
+  num_gbf_per_pixel = (num_gbf_ch/8) + (((num_gbf_ch%8)!=0) ? 1 : 0);
+  if(flow->format == MEMX_FMAP_FORMAT_BF16) {
+    flow->data_size = flow->tensor_size * 2;
+    flow->fmt_size = flow->data_size;
+    if(flow->tensor_size % 2)
+      flow->fmt_size += 2;
+  } else if(flow->format == MEMX_FMAP_FORMAT_GBF80) {
+    flow->data_size = (flow->tensor_size / flow->num_ch) * num_gbf_per_pixel * 10;
+    flow->fmt_size = flow->data_size + (4 - (flow->data_size % 4));
+  } else if(flow->format == MEMX_FMAP_FORMAT_GBF80_ROW_PAD) {
+    flow->data_size = flow->height*(flow->width * flow->z * num_gbf_per_pixel * 10);
+    flow->fmt_size = flow->height*((flow->width * flow->z * num_gbf_per_pixel * 10 + 3) &~0x3);
+  }
+
+  if(flow->fmt_size > 0) {
+    size_t alloc_size = ((size_t)flow->fmt_size + MXA_STAGING_ALIGN - 1) & ~(size_t)(MXA_STAGING_ALIGN - 1);
+    flow->staging = aligned_alloc(MXA_STAGING_ALIGN, alloc_size);
+    if(flow->staging == NULL) {
+      _flow_cache_free(flow);
+      return MEMX_STATUS_OTHERS;
+    }
+    // padding bytes are never written by the converters, so clearing once is enough
+    memset(flow->staging, 0, alloc_size);
+  }
+
+  flow->valid = 1;
+  return MEMX_STATUS_OK;
+}
+
+// returns the cached entry, or 'local' filled for this call only; NULL on error; called without GIL
+static MxaFlowCache* _flow_cache_acquire(uint8_t model_id, uint8_t flow_id, int dir, MxaFlowCache* local, memx_status* status)
+{
+  MxaFlowCache* flow = NULL;
+  unsigned int gen = 0;
+  int fill = 1;
+
+  if(model_id < MEMX_MODEL_MAX_NUMBER && flow_id < MXA_FLOW_CACHE_MAX_FLOW)
+    flow = &_flow_cache[model_id][flow_id][dir];
+
+  PyThread_acquire_lock(_flow_lock, WAIT_LOCK);
+  if(flow && !flow->busy) {
+    flow->busy = 1;
+    fill = !flow->valid;
+    gen = __atomic_load_n(&_flow_cache_gen[model_id], __ATOMIC_ACQUIRE);
+  } else {
+    flow = NULL;
+  }
+  PyThread_release_lock(_flow_lock);
+  if(!fill) {
+    *status = MEMX_STATUS_OK;
+    return flow;
+  }
+
+  // busy keeps other threads off the entry while the library is queried
+  *status = _flow_cache_fill(local, model_id, flow_id, dir);
+  if(memx_status_error(*status))
+    _flow_cache_free(local);
+  if(flow == NULL)
+    return memx_status_error(*status) ? NULL : local;
+
+  PyThread_acquire_lock(_flow_lock, WAIT_LOCK);
+  _flow_cache_free(flow);
+  if(memx_status_error(*status)) {
+    flow->valid = 0;
+    flow->busy = 0;
+    PyThread_release_lock(_flow_lock);
+    return NULL;
+  }
+  *flow = *local;
+  flow->busy = 1;
+  // invalidated or reconfigured meanwhile: good for this call, refilled on the next
+  if(__atomic_load_n(&_flow_cache_gen[model_id], __ATOMIC_ACQUIRE) != gen)
+    flow->valid = 0;
+  PyThread_release_lock(_flow_lock);
+  return flow;
+}
+
+// called without GIL
+static void _flow_cache_release(MxaFlowCache* flow, MxaFlowCache* local)
+{
+  if(flow == local) {
+    _flow_cache_free(local);
+    return;
+  }
+  PyThread_acquire_lock(_flow_lock, WAIT_LOCK);
+  flow->busy = 0;
+  // invalidated while in use
+  if(!flow->valid)
+    _flow_cache_free(flow);
+  PyThread_release_lock(_flow_lock);
+}
+
+// drops cached metadata and staging buffers of one model; called without GIL
+static void _flow_cache_invalidate(uint8_t model_id)
+{
+  if(model_id >= MEMX_MODEL_MAX_NUMBER)
+    return;
+  PyThread_acquire_lock(_flow_lock, WAIT_LOCK);
+  for(int flow_id = 0; flow_id < MXA_FLOW_CACHE_MAX_FLOW; ++flow_id) {
+    for(int dir = 0; dir < 2; ++dir) {
+      MxaFlowCache* flow = &_flow_cache[model_id][flow_id][dir];
+      flow->valid = 0;
+      if(!flow->busy)
+        _flow_cache_free(flow);
+    }
+  }
+  _flow_cache_bump(model_id);
+  PyThread_release_lock(_flow_lock);
+}
+
+// sets the uint8 input transform of one input flow; its cached entry is refilled on next use, a stream
+// call holding it keeps the old transform until it returns; called without GIL
+static void _flow_config_set_transform(uint8_t model_id, uint8_t flow_id, float shift, float scale)
+{
+  MxaFlowCache* flow;
+  if(model_id >= MEMX_MODEL_MAX_NUMBER || flow_id >= MXA_FLOW_CACHE_MAX_FLOW)
+    return;
+  flow = &_flow_cache[model_id][flow_id][MXA_FLOW_IFMAP];
+  PyThread_acquire_lock(_flow_lock, WAIT_LOCK);
+  _flow_config[model_id][flow_id].u8_set = 1;
+  _flow_config[model_id][flow_id].u8_shift = shift;
+  _flow_config[model_id][flow_id].u8_scale = scale;
+  flow->valid = 0;
+  if(!flow->busy)
+    _flow_cache_free(flow);
+  _flow_cache_bump(model_id);
+  PyThread_release_lock(_flow_lock);
+}
+
+// sets the host layout of one output flow; its cached entry is rebuilt (gather table) on next use; called without GIL
+static void _flow_config_set_layout(uint8_t model_id, uint8_t flow_id, int layout)
+{
+  MxaFlowCache* flow;
+  if(model_id >= MEMX_MODEL_MAX_NUMBER || flow_id >= MXA_FLOW_CACHE_MAX_FLOW)
+    return;
+  flow = &_flow_cache[model_id][flow_id][MXA_FLOW_OFMAP];
+  PyThread_acquire_lock(_flow_lock, WAIT_LOCK);
+  _flow_config[model_id][flow_id].layout = layout;
+  flow->valid = 0;
+  if(!flow->busy)
+    _flow_cache_free(flow);
+  _flow_cache_bump(model_id);
+  PyThread_release_lock(_flow_lock);
+}
+
+// back to defaults; cached entries pick them up on refill, so call after _flow_cache_invalidate(); called without GIL
+static void _flow_config_reset(uint8_t model_id)
+{
+  if(model_id >= MEMX_MODEL_MAX_NUMBER)
+    return;
+  PyThread_acquire_lock(_flow_lock, WAIT_LOCK);
+  memset(_flow_config[model_id], 0, sizeof(_flow_config[model_id]));
+  _flow_cache_bump(model_id);
+  PyThread_release_lock(_flow_lock);
+}
+
 /***************************************************************************//**
  * function wrapper
  ******************************************************************************/
@@ -139,6 +422,8 @@ static PyObject* _wrap_memx_open(PyObject* self, PyObject* args)
   {
     Py_BEGIN_ALLOW_THREADS
     status = memx_open(model_id, group_id, chip_gen);
+    _flow_cache_invalidate(model_id);
+    _flow_config_reset(model_id);
     Py_END_ALLOW_THREADS
   }
 
@@ -158,6 +443,8 @@ static PyObject* _wrap_memx_close(PyObject* self, PyObject* args)
   {
     Py_BEGIN_ALLOW_THREADS
     status = memx_close(model_id);
+    _flow_cache_invalidate(model_id);
+    _flow_config_reset(model_id);
     Py_END_ALLOW_THREADS
   }
 
@@ -844,6 +1131,7 @@ static PyObject* _wrap_memx_download_model_config(PyObject* self, PyObject* args
   {
     Py_BEGIN_ALLOW_THREADS
     status = memx_download_model_config(model_id, file_path, model_idx);
+    _flow_cache_invalidate(model_id);
     Py_END_ALLOW_THREADS
   }
 
@@ -864,6 +1152,7 @@ static PyObject* _wrap_memx_download_model_wtmem(PyObject* self, PyObject* args)
   {
     Py_BEGIN_ALLOW_THREADS
     status = memx_download_model_wtmem(model_id, file_path);
+    _flow_cache_invalidate(model_id);
     Py_END_ALLOW_THREADS
   }
 
@@ -886,6 +1175,7 @@ static PyObject* _wrap_memx_download_model(PyObject* self, PyObject* args)
   {
     Py_BEGIN_ALLOW_THREADS
     status = memx_download_model(model_id, file_path, model_idx, type);
+    _flow_cache_invalidate(model_id);
     Py_END_ALLOW_THREADS
   }
 
@@ -908,6 +1198,7 @@ static PyObject* _wrap_memx_download_model_buffer(PyObject* self, PyObject* args
     Py_INCREF(bytes_array);
     Py_BEGIN_ALLOW_THREADS
     status = memx_download_model(model_id, (const char*)PyBytes_AS_STRING(bytes_array), 0, type);
+    _flow_cache_invalidate(model_id);
     Py_END_ALLOW_THREADS
     Py_DECREF(bytes_array);
   }
@@ -1128,6 +1419,268 @@ static PyObject* _wrap_memx_get_ofmap_hpoc(PyObject* self, PyObject* args)
   return (PyObject*)hpoc_indexes;
 }
 
+/***************************************************************************//**
+ * stream stats
+ *  - wall time the calling thread spends converting frames and inside driver
+ *    library stream calls (copies, syscalls and queue waits), read and cleared
+ *    by get_stream_stats() to split the host cost of a frame
+ *  - CLOCK_MONOTONIC span of the last conversion, placed on timelines
+ *    with the driver tracepoints
+ ******************************************************************************/
+#if defined(_MSC_VER)
+#define MXA_THREAD_LOCAL __declspec(thread)
+#else
+#define MXA_THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct {
+  uint64_t convert_ns;
+  uint64_t convert_frames;
+  uint64_t driver_ns;
+  uint64_t driver_calls;
+  uint64_t convert_start;
+  uint64_t convert_end;
+} MxaStreamStats;
+
+static MXA_THREAD_LOCAL MxaStreamStats _stream_stats;
+
+static inline uint64_t _stream_stats_now(void)
+{
+  struct timespec ts;
+#if defined(_WIN32)
+  timespec_get(&ts, TIME_UTC);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline void _stream_stats_convert(uint64_t start)
+{
+  uint64_t end = _stream_stats_now();
+  _stream_stats.convert_ns += end - start;
+  _stream_stats.convert_frames++;
+  _stream_stats.convert_start = start;
+  _stream_stats.convert_end = end;
+}
+
+static inline void _stream_stats_driver(uint64_t start)
+{
+  _stream_stats.driver_ns += _stream_stats_now() - start;
+  _stream_stats.driver_calls++;
+}
+
+// encodes one host frame (float32, or uint8 if u8) into formatted (GBF80/BF16) data at dst; called without GIL
+static void _flow_encode(MxaFlowCache* flow, const void* ifmap, uint8_t* dst, int u8)
+{
+  uint64_t start = _stream_stats_now();
+
+  if (u8) {
+    if (flow->format == MEMX_FMAP_FORMAT_BF16) {
+      convert_bf16_u8(ifmap, dst, flow->tensor_size, flow->u8_shift, flow->u8_scale);
+    } else if (flow->format == MEMX_FMAP_FORMAT_GBF80) {
+      convert_gbf_u8(ifmap, dst, flow->tensor_size, flow->num_ch, flow->u8_shift, flow->u8_scale);
+    } else if (flow->format == MEMX_FMAP_FORMAT_GBF80_ROW_PAD) {
+      convert_gbf_row_pad_u8(ifmap, dst, flow->height, flow->width, flow->z, flow->num_ch, flow->u8_shift, flow->u8_scale);
+    }
+  } else if (flow->format == MEMX_FMAP_FORMAT_BF16) {
+    // BF convert
+    convert_bf16(ifmap, dst, flow->tensor_size);
+  } else if (flow->format == MEMX_FMAP_FORMAT_GBF80) {
+    // GBF convert
+    convert_gbf(ifmap, dst, flow->tensor_size, flow->num_ch);
+  } else if (flow->format == MEMX_FMAP_FORMAT_GBF80_ROW_PAD) {
+    // GBF row pad convert
+    convert_gbf_row_pad(ifmap, dst, flow->height, flow->width, flow->z, flow->num_ch);
+  }
+  _stream_stats_convert(start);
+}
+
+// decodes formatted (GBF80/BF16) data at src into one host frame; called without GIL
+static void _flow_decode(MxaFlowCache* flow, uint8_t* src, void* ofmap)
+{
+  uint64_t start = _stream_stats_now();
+
+  if (flow->format == MEMX_FMAP_FORMAT_BF16) {
+    // BF unconvert
+    if (flow->layout == CONVERT_LAYOUT_CHW) {
+      unconvert_bf16_chw(src, ofmap, flow->tensor_size, flow->num_ch);
+    } else {
+      unconvert_bf16(src, ofmap, flow->tensor_size);
+    }
+  } else if (flow->format == MEMX_FMAP_FORMAT_GBF80) {
+    // GBF unconvert
+    if (flow->gather != NULL) {
+      unconvert_gbf_gather(src, ofmap, flow->height, flow->width, flow->z, flow->num_ch, flow->num_gbf_ch, flow->gather, 0, flow->layout);
+    } else {
+      unconvert_gbf(src, ofmap, flow->tensor_size, flow->num_ch);
+    }
+  } else if (flow->format == MEMX_FMAP_FORMAT_GBF80_ROW_PAD) {
+    // GBF unconvert
+    if (flow->gather != NULL) {
+      unconvert_gbf_gather(src, ofmap, flow->height, flow->width, flow->z, flow->num_ch, flow->num_gbf_ch, flow->gather, 1, flow->layout);
+    } else {
+      unconvert_gbf_row_pad(src, ofmap, flow->height, flow->width, flow->z, flow->num_ch);
+    }
+  }
+  _stream_stats_convert(start);
+}
+
+// clears the alignment bytes the encoders skip, for buffers not zeroed up front
+static void _flow_clear_padding(MxaFlowCache* flow, uint8_t* dst, size_t size)
+{
+  if (flow->format == MEMX_FMAP_FORMAT_GBF80_ROW_PAD) {
+    size_t row_size = (size_t)flow->fmt_size / flow->height;
+    size_t row_data = (size_t)flow->data_size / flow->height;
+    for (int h_idx = 0; h_idx < flow->height; h_idx++)
+      memset(dst + h_idx * row_size + row_data, 0, row_size - row_data);
+  } else if (size > (size_t)flow->data_size) {
+    memset(dst + flow->data_size, 0, size - flow->data_size);
+  }
+}
+
+// bytes of a formatted frame the encoders/decoders touch
+static size_t _flow_extent(MxaFlowCache* flow)
+{
+  return (flow->format == MEMX_FMAP_FORMAT_GBF80_ROW_PAD) ? (size_t)flow->fmt_size : (size_t)flow->data_size;
+}
+
+// sends one frame of flow, converting into the flow staging buffer if needed; called without GIL
+static memx_status _stream_ifmap_frame(MxaFlowCache* flow, uint8_t model_id, uint8_t flow_id, void* ifmap, int u8, int timeout)
+{
+  memx_status status;
+  uint64_t start;
+
+  if (flow->chip_gen != MEMX_DEVICE_CASCADE && flow->chip_gen != MEMX_DEVICE_CASCADE_PLUS)
+    return MEMX_STATUS_OTHERS; //unexpected chip_gen case
+  // no convert on cascade, nor for formats other than GBF80/BF16
+  if (flow->fmt_size == 0) {
+    start = _stream_stats_now();
+    status = memx_stream_ifmap(model_id, flow_id, ifmap, timeout);
+    _stream_stats_driver(start);
+    return status;
+  }
+
+  _flow_encode(flow, ifmap, flow->staging, u8);
+  start = _stream_stats_now();
+  status = memx_stream_ifmap(model_id, flow_id, flow->staging, timeout);
+  _stream_stats_driver(start);
+  return status;
+}
+
+// receives one frame of flow, converting out of the flow staging buffer if needed; called without GIL
+static memx_status _stream_ofmap_frame(MxaFlowCache* flow, uint8_t model_id, uint8_t flow_id, void* ofmap, int timeout)
+{
+  memx_status status;
+  uint64_t start;
+
+  if (flow->chip_gen != MEMX_DEVICE_CASCADE && flow->chip_gen != MEMX_DEVICE_CASCADE_PLUS)
+    return MEMX_STATUS_OTHERS; //unexpected chip_gen case
+  // no convert on cascade, nor for formats other than GBF80/BF16
+  start = _stream_stats_now();
+  if (flow->fmt_size == 0) {
+    status = memx_stream_ofmap(model_id, flow_id, ofmap, timeout);
+    _stream_stats_driver(start);
+    return status;
+  }
+
+  status = memx_stream_ofmap(model_id, flow_id, flow->staging, timeout);
+  _stream_stats_driver(start);
+  _flow_decode(flow, flow->staging, ofmap);
+  return status;
+}
+
+// sends one frame of flow, encoding straight into a dequeued driver ifmap buffer; called without GIL
+static memx_status _enqueue_ifmap_frame(MxaFlowCache* flow, uint8_t model_id, uint8_t flow_id, void* ifmap, int u8, int timeout)
+{
+  memx_status status;
+  memx_fmap_buf_t fmap_buf;
+  uint64_t start;
+
+  if (flow->fmt_size == 0)
+    return _stream_ifmap_frame(flow, model_id, flow_id, ifmap, u8, timeout);
+
+  start = _stream_stats_now();
+  status = memx_dequeue_ifmap_buf(model_id, flow_id, &fmap_buf, timeout);
+  _stream_stats_driver(start);
+  if (memx_status_error(status))
+    return status;
+
+  if (fmap_buf.size >= _flow_extent(flow)) {
+    _flow_encode(flow, ifmap, fmap_buf.data, u8);
+    _flow_clear_padding(flow, fmap_buf.data, fmap_buf.size);
+  } else {
+    // driver buffer smaller than expected, send what fits like memx_stream_ifmap does
+    _flow_encode(flow, ifmap, flow->staging, u8);
+    memcpy(fmap_buf.data, flow->staging, fmap_buf.size);
+  }
+  start = _stream_stats_now();
+  status = memx_enqueue_ifmap_buf(model_id, flow_id, &fmap_buf, timeout);
+  _stream_stats_driver(start);
+  return status;
+}
+
+// receives one frame of flow, decoding straight out of a dequeued driver ofmap buffer; called without GIL
+static memx_status _dequeue_ofmap_frame(MxaFlowCache* flow, uint8_t model_id, uint8_t flow_id, void* ofmap, int timeout)
+{
+  memx_status status;
+  memx_fmap_buf_t fmap_buf;
+  uint64_t start;
+
+  if (flow->fmt_size == 0)
+    return _stream_ofmap_frame(flow, model_id, flow_id, ofmap, timeout);
+
+  start = _stream_stats_now();
+  status = memx_dequeue_ofmap_buf(model_id, flow_id, &fmap_buf, timeout);
+  _stream_stats_driver(start);
+  if (memx_status_error(status))
+    return status;
+
+  if (fmap_buf.size >= _flow_extent(flow)) {
+    _flow_decode(flow, fmap_buf.data, ofmap);
+  } else {
+    memcpy(flow->staging, fmap_buf.data, fmap_buf.size);
+    _flow_decode(flow, flow->staging, ofmap);
+  }
+  // hand the buffer back to the driver ring
+  start = _stream_stats_now();
+  status = memx_enqueue_ofmap_buf(model_id, flow_id, &fmap_buf, timeout);
+  _stream_stats_driver(start);
+  return status;
+}
+
+// uint8 frames are encoded as is on flows that convert, other flows take them raw
+static int _flow_takes_u8(MxaFlowCache* flow, int type_num)
+{
+  return (flow->fmt_size > 0) && (type_num == NPY_UINT8);
+}
+
+// flows whose frames are float32 on the host side
+static int _flow_is_float(MxaFlowCache* flow)
+{
+  return (flow->chip_gen == MEMX_DEVICE_CASCADE_PLUS) &&
+    ((flow->format == MEMX_FMAP_FORMAT_BF16) || (flow->format == MEMX_FMAP_FORMAT_GBF80) ||
+     (flow->format == MEMX_FMAP_FORMAT_GBF80_ROW_PAD) || (flow->format == MEMX_FMAP_FORMAT_FLOAT32));
+}
+
+// host bytes of one frame of a flow passed through unconverted (Cascade, RAW ports): uint8 for RAW, float32 otherwise,
+// 0 if the port is not configured; Cascade entries carry no shape, so the port is queried; called without GIL
+static size_t _flow_raw_frame_bytes(MxaFlowCache* flow, uint8_t model_id, uint8_t flow_id, int dir)
+{
+  memx_status status = MEMX_STATUS_OK;
+  int height = flow->height, width = flow->width, z = flow->z, num_ch = flow->num_ch, format = flow->format;
+
+  if(flow->tensor_size == 0) {
+    if(dir == MXA_FLOW_IFMAP)
+      status = memx_get_ifmap_size(model_id, flow_id, &height, &width, &z, &num_ch, &format);
+    else
+      status = memx_get_ofmap_size(model_id, flow_id, &height, &width, &z, &num_ch, &format);
+  }
+  if(memx_status_error(status) || height <= 0 || width <= 0 || z <= 0 || num_ch <= 0)
+    return 0;
+  return (size_t)height * width * z * num_ch * ((format == MEMX_FMAP_FORMAT_RAW) ? sizeof(uint8_t) : sizeof(float));
+}
+
 static PyObject* _wrap_memx_stream_ifmap(PyObject* self, PyObject* args, PyObject *kwargs)
 {
   memx_status status;
@@ -1135,6 +1688,9 @@ static PyObject* _wrap_memx_stream_ifmap(PyObject* self, PyObject* args, PyObjec
   uint8_t flow_id; // mandatory
   PyArrayObject* ifmap; // mandatory
   int timeout = 0; // optional = 0 (infinite)
+  int type_num;
+  MxaFlowCache local;
+  MxaFlowCache* flow;
 
   static char *kwlist[] = {"model_id","flow_id","ifmap","timeout",NULL};
   if(!PyArg_ParseTupleAndKeywords(args, kwargs, "bbO!|i", kwlist, &model_id, &flow_id, &PyArray_Type, &ifmap, &timeout)) {
@@ -1142,105 +1698,17 @@ static PyObject* _wrap_memx_stream_ifmap(PyObject* self, PyObject* args, PyObjec
     return NULL;
   }
 
-  uint8_t chip_gen = 0;
-  status = memx_get_chip_gen(model_id, &chip_gen);
-  if(status != MEMX_STATUS_OK){ return Py_BuildValue("i", status); }
-
-  uint8_t *formatted_data = NULL;
-
+  type_num = PyArray_TYPE(ifmap);
   {
-    if (chip_gen == MEMX_DEVICE_CASCADE){
-        // no convert
-        Py_INCREF(ifmap);
-        Py_BEGIN_ALLOW_THREADS
-        status = memx_stream_ifmap(model_id, flow_id, (void*)PyArray_DATA(ifmap), timeout);
-        Py_END_ALLOW_THREADS
-        Py_DECREF(ifmap);
-    }
-    else if (chip_gen == MEMX_DEVICE_CASCADE_PLUS) {
-
-
-        // get the info
-        int height, width, z, num_ch, format, tensor_size;
-        status = memx_get_ifmap_size(model_id, flow_id, &height, &width, &z, &num_ch, &format);
-        tensor_size = height*width*z*num_ch;
-
-        if(format == MEMX_FMAP_FORMAT_BF16){
-            // BF convert
-            int fmt_size = tensor_size * 2;
-            if(tensor_size % 2)
-                fmt_size += 2;
-
-            Py_INCREF(ifmap);
-            Py_BEGIN_ALLOW_THREADS
-            formatted_data = malloc(fmt_size);
-            memset(formatted_data, 0, fmt_size);
-            convert_bf16( (void*)PyArray_DATA(ifmap), formatted_data, tensor_size );
-
-            // send
-            status = memx_stream_ifmap(model_id, flow_id, formatted_data, timeout);
-
-            // free
-            free(formatted_data);
-            formatted_data = NULL;
-
-            Py_END_ALLOW_THREADS
-            Py_DECREF(ifmap);
-        } else if (format == MEMX_FMAP_FORMAT_GBF80) {
-            // GBF convert
-            int num_xyz_pixels = (tensor_size / num_ch);
-            int num_gbf_per_pixel = (num_ch / 8) + ( ((num_ch%8)!=0) ? 1 : 0);
-            int fmt_size = num_xyz_pixels * num_gbf_per_pixel * 10;
-            fmt_size += (4 - (fmt_size % 4));
-
-            Py_INCREF(ifmap);
-            Py_BEGIN_ALLOW_THREADS
-
-            formatted_data = malloc(fmt_size);
-            memset(formatted_data, 0, fmt_size);
-            convert_gbf( (void*)PyArray_DATA(ifmap), formatted_data, tensor_size, num_ch );
-
-            // send
-            status = memx_stream_ifmap(model_id, flow_id, formatted_data, timeout);
-
-            // free
-            free(formatted_data);
-            formatted_data = NULL;
-
-            Py_END_ALLOW_THREADS
-            Py_DECREF(ifmap);
-        } else if (format == MEMX_FMAP_FORMAT_GBF80_ROW_PAD) {
-            // GBF row pad alloc
-            int num_gbf_per_pixel = (num_ch / 8) + ( ((num_ch%8)!=0) ? 1 : 0);
-            int fmt_size = height*((width * z * num_gbf_per_pixel * 10 + 3) &~0x3);
-            Py_INCREF(ifmap);
-            Py_BEGIN_ALLOW_THREADS
-            formatted_data = malloc(fmt_size);
-            memset(formatted_data, 0, fmt_size);
-            convert_gbf_row_pad( (void*)PyArray_DATA(ifmap), formatted_data, height, width, z, num_ch);
-
-            // send
-            status = memx_stream_ifmap(model_id, flow_id, formatted_data, timeout);
-
-            // free
-            free(formatted_data);
-            formatted_data = NULL;
-
-            Py_END_ALLOW_THREADS
-            Py_DECREF(ifmap);
-        } else {
-            // don't convert anything else
-            Py_INCREF(ifmap);
-            Py_BEGIN_ALLOW_THREADS
-            status = memx_stream_ifmap(model_id, flow_id, (void*)PyArray_DATA(ifmap), timeout);
-            Py_END_ALLOW_THREADS
-            Py_DECREF(ifmap);
-        }
-    }
-    else //unexpected chip_gen case
-    {
-        status = MEMX_STATUS_OTHERS;
+    Py_INCREF(ifmap);
+    Py_BEGIN_ALLOW_THREADS
+    flow = _flow_cache_acquire(model_id, flow_id, MXA_FLOW_IFMAP, &local, &status);
+    if(flow != NULL) {
+      status = _stream_ifmap_frame(flow, model_id, flow_id, (void*)PyArray_DATA(ifmap), _flow_takes_u8(flow, type_num), timeout);
+      _flow_cache_release(flow, &local);
     }
+    Py_END_ALLOW_THREADS
+    Py_DECREF(ifmap);
   }
 
   unused(self);
@@ -1259,8 +1727,74 @@ static PyObject* _wrap_memx_stream_ofmap(PyObject* self, PyObject* args, PyObjec
   uint8_t flow_id; // mandatory
   PyArrayObject* ofmap; // mandatory
   int timeout = 0; // optional = 0 (infinite)
-  int hpoc_size = 0;
-  int* hpoc_indexes = NULL;
+  MxaFlowCache local;
+  MxaFlowCache* flow;
+
+  static char *kwlist[] = {"model_id","flow_id","ofmap","timeout",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "bbO!|i", kwlist, &model_id, &flow_id, &PyArray_Type, &ofmap, &timeout)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+
+  {
+    Py_INCREF(ofmap);
+    Py_BEGIN_ALLOW_THREADS
+    flow = _flow_cache_acquire(model_id, flow_id, MXA_FLOW_OFMAP, &local, &status);
+    if(flow != NULL) {
+      status = _stream_ofmap_frame(flow, model_id, flow_id, (void*)PyArray_DATA(ofmap), timeout);
+      _flow_cache_release(flow, &local);
+    }
+    Py_END_ALLOW_THREADS
+    Py_DECREF(ofmap);
+  }
+
+  unused(self);
+  return Py_BuildValue("i", status);
+}
+
+static PyObject* _wrap_memx_enqueue_ifmap_buf(PyObject* self, PyObject* args, PyObject *kwargs)
+{
+  memx_status status;
+  uint8_t model_id; // mandatory
+  uint8_t flow_id; // mandatory
+  PyArrayObject* ifmap; // mandatory
+  int timeout = 0; // optional = 0 (infinite)
+  int type_num;
+  MxaFlowCache local;
+  MxaFlowCache* flow;
+
+  static char *kwlist[] = {"model_id","flow_id","ifmap","timeout",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "bbO!|i", kwlist, &model_id, &flow_id, &PyArray_Type, &ifmap, &timeout)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+
+  type_num = PyArray_TYPE(ifmap);
+  {
+    Py_INCREF(ifmap);
+    Py_BEGIN_ALLOW_THREADS
+    flow = _flow_cache_acquire(model_id, flow_id, MXA_FLOW_IFMAP, &local, &status);
+    if(flow != NULL) {
+      status = _enqueue_ifmap_frame(flow, model_id, flow_id, (void*)PyArray_DATA(ifmap), _flow_takes_u8(flow, type_num), timeout);
+      _flow_cache_release(flow, &local);
+    }
+    Py_END_ALLOW_THREADS
+    Py_DECREF(ifmap);
+  }
+
+  unused(self);
+  return Py_BuildValue("i", status);
+}
+
+static PyObject* _wrap_memx_dequeue_ofmap_buf(PyObject* self, PyObject* args, PyObject *kwargs)
+{
+  memx_status status;
+  uint8_t model_id; // mandatory
+  uint8_t flow_id; // mandatory
+  PyArrayObject* ofmap; // mandatory
+  int timeout = 0; // optional = 0 (infinite)
+  MxaFlowCache local;
+  MxaFlowCache* flow;
 
   static char *kwlist[] = {"model_id","flow_id","ofmap","timeout",NULL};
   if(!PyArg_ParseTupleAndKeywords(args, kwargs, "bbO!|i", kwlist, &model_id, &flow_id, &PyArray_Type, &ofmap, &timeout)) {
@@ -1268,136 +1802,185 @@ static PyObject* _wrap_memx_stream_ofmap(PyObject* self, PyObject* args, PyObjec
     return NULL;
   }
 
-  uint8_t chip_gen = 0;
-  status = memx_get_chip_gen(model_id, &chip_gen);
-  if(status != MEMX_STATUS_OK){ return Py_BuildValue("i", status); }
+  {
+    Py_INCREF(ofmap);
+    Py_BEGIN_ALLOW_THREADS
+    flow = _flow_cache_acquire(model_id, flow_id, MXA_FLOW_OFMAP, &local, &status);
+    if(flow != NULL) {
+      status = _dequeue_ofmap_frame(flow, model_id, flow_id, (void*)PyArray_DATA(ofmap), timeout);
+      _flow_cache_release(flow, &local);
+    }
+    Py_END_ALLOW_THREADS
+    Py_DECREF(ofmap);
+  }
+
+  unused(self);
+  return Py_BuildValue("i", status);
+}
+
+// sends a batch of frames through an acquired flow, GIL released while streaming; NULL with an exception set on bad input
+static PyObject* _stream_ifmap_batch(MxaFlowCache* flow, uint8_t model_id, uint8_t flow_id, PyObject* ifmaps_obj, int timeout, int frames, int fmap_buf)
+{
+  memx_status status;
+  int sent = 0;
+  int u8;
+  PyArrayObject* ifmaps;
+
+  // one dtype conversion / contiguous copy for the whole batch, none for uint8 frames on converting flows
+  u8 = PyArray_Check(ifmaps_obj) && _flow_takes_u8(flow, PyArray_TYPE((PyArrayObject*)ifmaps_obj));
+  if(u8)
+    ifmaps = (PyArrayObject*)PyArray_FROM_OF(ifmaps_obj, NPY_ARRAY_IN_ARRAY);
+  else if(_flow_is_float(flow))
+    ifmaps = (PyArrayObject*)PyArray_FROM_OTF(ifmaps_obj, NPY_FLOAT32, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+  else
+    ifmaps = (PyArrayObject*)PyArray_FROM_OF(ifmaps_obj, NPY_ARRAY_IN_ARRAY);
+  if(ifmaps == NULL)
+    return NULL;
 
-  uint8_t *formatted_data = NULL;
+  npy_intp n = (PyArray_NDIM(ifmaps) > 0) ? PyArray_DIM(ifmaps, 0) : 0;
+  size_t frame_bytes = (n > 0) ? (size_t)PyArray_NBYTES(ifmaps) / n : 0;
+  if(n == 0 || (_flow_is_float(flow) && frame_bytes != (size_t)flow->tensor_size * PyArray_ITEMSIZE(ifmaps))) {
+    PyErr_Format(PyExc_ValueError, "ifmaps must be [N, ...] with %d float32 (or uint8) elements per frame", flow->tensor_size);
+    Py_DECREF(ifmaps);
+    return NULL;
+  }
+  if(!_flow_is_float(flow)) {
+    size_t raw_bytes;
+    Py_BEGIN_ALLOW_THREADS
+    raw_bytes = _flow_raw_frame_bytes(flow, model_id, flow_id, MXA_FLOW_IFMAP);
+    Py_END_ALLOW_THREADS
+    if(frame_bytes != raw_bytes) {
+      PyErr_Format(PyExc_ValueError, "ifmaps must be [N, ...] with %zu bytes per frame, got %zu", raw_bytes, frame_bytes);
+      Py_DECREF(ifmaps);
+      return NULL;
+    }
+  }
+  if(frames < 0)
+    frames = (int)n;
 
   {
-    if (chip_gen == MEMX_DEVICE_CASCADE) {
-        // no convert
-        Py_INCREF(ofmap);
-        Py_BEGIN_ALLOW_THREADS
-        status = memx_stream_ofmap(model_id, flow_id, (void*)PyArray_DATA(ofmap), timeout);
-        Py_END_ALLOW_THREADS
-        Py_DECREF(ofmap);
+    const uint8_t* data = (const uint8_t*)PyArray_DATA(ifmaps);
+    memx_status (*frame_fn)(MxaFlowCache*, uint8_t, uint8_t, void*, int, int) = fmap_buf ? _enqueue_ifmap_frame : _stream_ifmap_frame;
+    Py_BEGIN_ALLOW_THREADS
+    status = MEMX_STATUS_OK;
+    for(; sent < frames; ++sent) {
+      status = frame_fn(flow, model_id, flow_id, (void*)(data + (size_t)(sent % n) * frame_bytes), u8, timeout);
+      if(memx_status_error(status))
+        break;
     }
-    else if (chip_gen == MEMX_DEVICE_CASCADE_PLUS) {
-
-        // get the info
-        int height, width, z, num_ch, format, tensor_size;
-        status = memx_get_ofmap_size(model_id, flow_id, &height, &width, &z, &num_ch, &format);
-        tensor_size = height*width*z*num_ch;
-
-        if(format == MEMX_FMAP_FORMAT_BF16){
-            // BF alloc
-            int fmt_size = tensor_size * 2;
-            if(tensor_size % 2)
-                fmt_size += 2;
-            formatted_data = malloc(fmt_size);
-            memset(formatted_data, 0, fmt_size);
-
-            // recv
-            Py_INCREF(ofmap);
-            Py_BEGIN_ALLOW_THREADS
-            status = memx_stream_ofmap(model_id, flow_id, formatted_data, 0);
-
-            // BF unconvert
-            unconvert_bf16(formatted_data, (void*)PyArray_DATA(ofmap), tensor_size);
-
-            // free
-            free(formatted_data);
-            formatted_data = NULL;
-
-            Py_END_ALLOW_THREADS
-            Py_DECREF(ofmap);
-
-        } else if(format == MEMX_FMAP_FORMAT_GBF80){
-            int num_gbf_ch = num_ch;
-            status = memx_get_ofmap_hpoc(model_id, flow_id, &hpoc_size, &hpoc_indexes);
-            // adjust gbf size for hpoc
-            if(memx_status_no_error(status) && hpoc_size != 0) {
-              num_gbf_ch += hpoc_size;
-            }
-
-            // GBF alloc
-            int num_xyz_pixels = (tensor_size / num_ch);
-            int num_gbf_per_pixel = (num_gbf_ch/8) + (((num_gbf_ch%8)!=0) ? 1 : 0);
-            int fmt_size = num_xyz_pixels * num_gbf_per_pixel * 10;
-            fmt_size += (4 - (fmt_size % 4));
-
-            // recv
-            Py_INCREF(ofmap);
-            Py_BEGIN_ALLOW_THREADS
-
-            formatted_data = malloc(fmt_size);
-            memset(formatted_data, 0, fmt_size);
-            status = memx_stream_ofmap(model_id, flow_id, formatted_data, timeout);
-
-            // GBF unconvert
-            if (hpoc_size != 0 && hpoc_indexes) {
-              unconvert_gbf_hpoc(formatted_data, (void*)PyArray_DATA(ofmap), height, width, z, num_ch, hpoc_size, hpoc_indexes, 0);
-            } else {
-              unconvert_gbf(formatted_data, (void*)PyArray_DATA(ofmap), tensor_size, num_ch);
-            }
-
-            // free
-            free(formatted_data);
-            formatted_data = NULL;
-
-            Py_END_ALLOW_THREADS
-            Py_DECREF(ofmap);
-
-        } else if(format == MEMX_FMAP_FORMAT_GBF80_ROW_PAD){
-            int num_gbf_ch = num_ch;
-            status = memx_get_ofmap_hpoc(model_id, flow_id, &hpoc_size, &hpoc_indexes);
-            // adjust gbf size for hpoc
-            if(memx_status_no_error(status) && hpoc_size != 0) {
-              num_gbf_ch += hpoc_size;
-            }
-
-            // GBF row pad alloc
-            int num_gbf_per_pixel = (num_gbf_ch/8) + (((num_gbf_ch%8)!=0) ? 1 : 0);
-            int fmt_size = height*((width * z * num_gbf_per_pixel * 10 + 3) &~0x3);
-            formatted_data = malloc(fmt_size);
-            memset(formatted_data, 0, fmt_size);
-
-            // recv
-            Py_INCREF(ofmap);
-            Py_BEGIN_ALLOW_THREADS
-            status = memx_stream_ofmap(model_id, flow_id, formatted_data, timeout);
-            // GBF unconvert
-            if (hpoc_size != 0 && hpoc_indexes) {
-              unconvert_gbf_hpoc(formatted_data, (void*)PyArray_DATA(ofmap), height, width, z, num_ch, hpoc_size, hpoc_indexes, 1);
-            } else {
-              unconvert_gbf_row_pad(formatted_data, (void*)PyArray_DATA(ofmap), height, width, z, num_ch);
-            }
-
-            // free
-            free(formatted_data);
-            formatted_data = NULL;
-
-            Py_END_ALLOW_THREADS
-            Py_DECREF(ofmap);
-
-        } else {
-            // don't convert anything else
-            Py_INCREF(ofmap);
-            Py_BEGIN_ALLOW_THREADS
-            status = memx_stream_ofmap(model_id, flow_id, (void*)PyArray_DATA(ofmap), timeout);
-            Py_END_ALLOW_THREADS
-            Py_DECREF(ofmap);
-       }
+    Py_END_ALLOW_THREADS
+  }
+  Py_DECREF(ifmaps);
+
+  return Py_BuildValue("(ii)", status, sent);
+}
+
+// receives a batch of frames through an acquired flow, GIL released while streaming; NULL with an exception set on bad input
+static PyObject* _stream_ofmap_batch(MxaFlowCache* flow, uint8_t model_id, uint8_t flow_id, PyArrayObject* ofmaps, int timeout, int frames, int fmap_buf)
+{
+  memx_status status;
+  int received = 0;
+
+  npy_intp n = (PyArray_NDIM(ofmaps) > 0) ? PyArray_DIM(ofmaps, 0) : 0;
+  size_t frame_bytes = (n > 0) ? (size_t)PyArray_NBYTES(ofmaps) / n : 0;
+  if(!PyArray_ISCARRAY(ofmaps) || n == 0 ||
+     (_flow_is_float(flow) && (PyArray_TYPE(ofmaps) != NPY_FLOAT32 || frame_bytes != (size_t)flow->tensor_size * sizeof(float)))) {
+    PyErr_Format(PyExc_ValueError, "ofmaps must be a writable C-contiguous [N, ...] array with %d float32 elements per frame", flow->tensor_size);
+    return NULL;
+  }
+  if(!_flow_is_float(flow)) {
+    size_t raw_bytes;
+    Py_BEGIN_ALLOW_THREADS
+    raw_bytes = _flow_raw_frame_bytes(flow, model_id, flow_id, MXA_FLOW_OFMAP);
+    Py_END_ALLOW_THREADS
+    if(frame_bytes != raw_bytes) {
+      PyErr_Format(PyExc_ValueError, "ofmaps must be a writable C-contiguous [N, ...] array with %zu bytes per frame, got %zu", raw_bytes, frame_bytes);
+      return NULL;
     }
-    else //unexpected chip_gen case
-    {
-        status = MEMX_STATUS_OTHERS;
+  }
+  if(frames < 0)
+    frames = (int)n;
+
+  {
+    uint8_t* data = (uint8_t*)PyArray_DATA(ofmaps);
+    memx_status (*frame_fn)(MxaFlowCache*, uint8_t, uint8_t, void*, int) = fmap_buf ? _dequeue_ofmap_frame : _stream_ofmap_frame;
+    Py_INCREF(ofmaps);
+    Py_BEGIN_ALLOW_THREADS
+    status = MEMX_STATUS_OK;
+    for(; received < frames; ++received) {
+      status = frame_fn(flow, model_id, flow_id, (void*)(data + (size_t)(received % n) * frame_bytes), timeout);
+      if(memx_status_error(status))
+        break;
     }
+    Py_END_ALLOW_THREADS
+    Py_DECREF(ofmaps);
+  }
+
+  return Py_BuildValue("(ii)", status, received);
+}
+
+static PyObject* _wrap_memx_stream_ifmap_batch(PyObject* self, PyObject* args, PyObject *kwargs)
+{
+  memx_status status;
+  uint8_t model_id; // mandatory
+  uint8_t flow_id; // mandatory
+  PyObject* ifmaps_obj; // mandatory, [N, ...]
+  int timeout = 0; // optional = 0 (infinite)
+  int frames = -1; // optional = -1 (N), cycles through the N frames if larger
+  int fmap_buf = 0; // optional = 0, 1 converts in place in driver fmap buffers
+  MxaFlowCache local;
+  MxaFlowCache* flow;
+  PyObject* result;
+
+  static char *kwlist[] = {"model_id","flow_id","ifmaps","timeout","frames","fmap_buf",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "bbO|iii", kwlist, &model_id, &flow_id, &ifmaps_obj, &timeout, &frames, &fmap_buf)) {
+    PyErr_BadArgument();
+    return NULL;
   }
 
+  Py_BEGIN_ALLOW_THREADS
+  flow = _flow_cache_acquire(model_id, flow_id, MXA_FLOW_IFMAP, &local, &status);
+  Py_END_ALLOW_THREADS
+  if(flow == NULL){ return Py_BuildValue("(ii)", status, 0); }
+  result = _stream_ifmap_batch(flow, model_id, flow_id, ifmaps_obj, timeout, frames, fmap_buf);
+  Py_BEGIN_ALLOW_THREADS
+  _flow_cache_release(flow, &local);
+  Py_END_ALLOW_THREADS
+
   unused(self);
-  return Py_BuildValue("i", status);
+  return result;
+}
+
+static PyObject* _wrap_memx_stream_ofmap_batch(PyObject* self, PyObject* args, PyObject *kwargs)
+{
+  memx_status status;
+  uint8_t model_id; // mandatory
+  uint8_t flow_id; // mandatory
+  PyArrayObject* ofmaps; // mandatory, [N, ...] writable and C-contiguous
+  int timeout = 0; // optional = 0 (infinite)
+  int frames = -1; // optional = -1 (N), cycles through the N frames if larger
+  int fmap_buf = 0; // optional = 0, 1 converts in place in driver fmap buffers
+  MxaFlowCache local;
+  MxaFlowCache* flow;
+  PyObject* result;
+
+  static char *kwlist[] = {"model_id","flow_id","ofmaps","timeout","frames","fmap_buf",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "bbO!|iii", kwlist, &model_id, &flow_id, &PyArray_Type, &ofmaps, &timeout, &frames, &fmap_buf)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+  flow = _flow_cache_acquire(model_id, flow_id, MXA_FLOW_OFMAP, &local, &status);
+  Py_END_ALLOW_THREADS
+  if(flow == NULL){ return Py_BuildValue("(ii)", status, 0); }
+  result = _stream_ofmap_batch(flow, model_id, flow_id, ofmaps, timeout, frames, fmap_buf);
+  Py_BEGIN_ALLOW_THREADS
+  _flow_cache_release(flow, &local);
+  Py_END_ALLOW_THREADS
+
+  unused(self);
+  return result;
 }
 
 static PyObject* _wrap_memx_stream_ofmap_pop(PyObject* self, PyObject* args, PyObject *kwargs)
@@ -1690,27 +2273,720 @@ static PyObject* _wrap_memx_devioctrl_gpiorw(PyObject* self, PyObject* args)
   return result;
 }
 
-/***************************************************************************//**
- * module method
- ******************************************************************************/
-static PyMethodDef MemxMethods[] = {
-  // { name, callback, options, description }
-  {"lock", (PyCFunction)_wrap_memx_lock, METH_VARARGS, NULL},
-  {"trylock", (PyCFunction)_wrap_memx_trylock, METH_VARARGS, NULL},
-  {"unlock", (PyCFunction)_wrap_memx_unlock, METH_VARARGS, NULL},
-  {"open", (PyCFunction)_wrap_memx_open, METH_VARARGS, NULL},
-  {"close", (PyCFunction)_wrap_memx_close, METH_VARARGS, NULL},
-  {"abort", (PyCFunction)_wrap_memx_abort, METH_VARARGS, NULL},
-  {"operation", (PyCFunction)_wrap_memx_operation, METH_VARARGS, NULL},
-  {"chip_count", (PyCFunction)_wrap_memx_chip_count, METH_VARARGS, NULL},
-  {"config_mpu_group", (PyCFunction)_wrap_memx_config_mpu_group, METH_VARARGS, NULL},
-  {"download_model_config", (PyCFunction)_wrap_memx_download_model_config, METH_VARARGS, NULL},
-  {"download_model_wtmem", (PyCFunction)_wrap_memx_download_model_wtmem, METH_VARARGS, NULL},
-  {"download", (PyCFunction)_wrap_memx_download_model, METH_VARARGS, NULL},
-  {"download_buffer", (PyCFunction)_wrap_memx_download_model_buffer, METH_VARARGS, NULL},
-  {"update_firmware", (PyCFunction)_wrap_memx_download_firmware, METH_VARARGS, NULL},
-  {"set_stream_enable", (PyCFunction)_wrap_memx_set_stream_enable, METH_VARARGS, NULL},
-  {"set_stream_disable", (PyCFunction)_wrap_memx_set_stream_disable, METH_VARARGS, NULL},
+static PyObject* _wrap_memx_set_ifmap_transform(PyObject* self, PyObject* args, PyObject *kwargs)
+{
+  uint8_t model_id; // mandatory
+  uint8_t flow_id; // mandatory
+  float shift = 0.0f; // optional = 0
+  float scale = 1.0f; // optional = 1
+
+  static char *kwlist[] = {"model_id","flow_id","shift","scale",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "bb|ff", kwlist, &model_id, &flow_id, &shift, &scale)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  if(model_id >= MEMX_MODEL_MAX_NUMBER || flow_id >= MXA_FLOW_CACHE_MAX_FLOW)
+    return Py_BuildValue("i", MEMX_STATUS_OTHERS);
+
+  Py_BEGIN_ALLOW_THREADS
+  _flow_config_set_transform(model_id, flow_id, shift, scale);
+  Py_END_ALLOW_THREADS
+
+  unused(self);
+  return Py_BuildValue("i", MEMX_STATUS_OK);
+}
+
+static PyObject* _wrap_memx_set_ofmap_layout(PyObject* self, PyObject* args, PyObject *kwargs)
+{
+  uint8_t model_id; // mandatory
+  uint8_t flow_id; // mandatory
+  int layout; // mandatory
+
+  static char *kwlist[] = {"model_id","flow_id","layout",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "bbi", kwlist, &model_id, &flow_id, &layout)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  if(layout != CONVERT_LAYOUT_HWC && layout != CONVERT_LAYOUT_CHW) {
+    PyErr_SetString(PyExc_ValueError, "layout must be mxa.fmap_layout_hwc or mxa.fmap_layout_chw");
+    return NULL;
+  }
+  if(model_id >= MEMX_MODEL_MAX_NUMBER || flow_id >= MXA_FLOW_CACHE_MAX_FLOW)
+    return Py_BuildValue("i", MEMX_STATUS_OTHERS);
+
+  Py_BEGIN_ALLOW_THREADS
+  _flow_config_set_layout(model_id, flow_id, layout);
+  Py_END_ALLOW_THREADS
+
+  unused(self);
+  return Py_BuildValue("i", MEMX_STATUS_OK);
+}
+
+static PyObject* _wrap_convert_kernel(PyObject* self, PyObject* args)
+{
+  const char* name = convert_kernel_name();
+
+  unused(self);
+  unused(args);
+  return Py_BuildValue("s", name);
+}
+
+static PyObject* _wrap_convert_set_threads(PyObject* self, PyObject* args, PyObject *kwargs)
+{
+  int num_threads; // mandatory, 0 = OpenMP default
+  int threshold = -1; // optional, -1 = keep current
+
+  static char *kwlist[] = {"num_threads","threshold",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "i|i", kwlist, &num_threads, &threshold)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  if(num_threads < 0) {
+    PyErr_SetString(PyExc_ValueError, "num_threads must be >= 0");
+    return NULL;
+  }
+  convert_set_threads(num_threads, threshold);
+
+  unused(self);
+  return Py_BuildValue("i", MEMX_STATUS_OK);
+}
+
+static PyObject* _wrap_convert_get_threads(PyObject* self, PyObject* args)
+{
+  int num_threads;
+  int threshold;
+
+  convert_get_threads(&num_threads, &threshold);
+
+  unused(self);
+  unused(args);
+  return Py_BuildValue("(ii)", num_threads, threshold);
+}
+
+static PyObject* _wrap_convert_set_bf16_rounding(PyObject* self, PyObject* args, PyObject *kwargs)
+{
+  int rounding; // mandatory
+
+  static char *kwlist[] = {"rounding",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "i", kwlist, &rounding)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  if(convert_set_bf16_rounding(rounding) != 0) {
+    PyErr_SetString(PyExc_ValueError, "rounding must be mxa.bf16_round_half_up or mxa.bf16_round_nearest_even");
+    return NULL;
+  }
+
+  unused(self);
+  return Py_BuildValue("i", MEMX_STATUS_OK);
+}
+
+static PyObject* _wrap_convert_get_bf16_rounding(PyObject* self, PyObject* args)
+{
+  unused(self);
+  unused(args);
+  return Py_BuildValue("i", convert_get_bf16_rounding());
+}
+
+static PyObject* _wrap_get_stream_stats(PyObject* self, PyObject* args, PyObject *kwargs)
+{
+  int reset = 1; // optional = 1, clear after reading
+  MxaStreamStats stats;
+
+  static char *kwlist[] = {"reset",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "|i", kwlist, &reset)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  stats = _stream_stats;
+  if(reset)
+    memset(&_stream_stats, 0, sizeof(_stream_stats));
+
+  unused(self);
+  return Py_BuildValue("{s:K,s:K,s:K,s:K,s:K,s:K}",
+    "convert_ns", (unsigned long long)stats.convert_ns, "convert_frames", (unsigned long long)stats.convert_frames,
+    "driver_ns", (unsigned long long)stats.driver_ns, "driver_calls", (unsigned long long)stats.driver_calls,
+    "convert_start", (unsigned long long)stats.convert_start, "convert_end", (unsigned long long)stats.convert_end);
+}
+
+/***************************************************************************//**
+ * model object
+ *  - mxa.Model opens one model_id and owns the flow entries (metadata and
+ *    staging buffers) of it, instead of sharing the module-wide flow cache
+ *  - each flow entry has its own lock, only ever taken with the GIL released,
+ *    so threads driving different flows or models never contend, and threads
+ *    sharing a flow queue up on it rather than fall back to uncached entries
+ *  - entries are refilled when the model generation moved (re-download,
+ *    transform or layout change through either API)
+ ******************************************************************************/
+typedef struct _MxaModelFlow {
+  PyThread_type_lock lock;
+  unsigned int gen; // _flow_cache_gen of the model when filled
+  MxaFlowCache cache;
+} MxaModelFlow;
+
+typedef struct _MxaModelObject {
+  PyObject_HEAD
+  uint8_t model_id;
+  uint8_t group_id;
+  int opened; // cleared by close() with every flow lock held
+  MxaModelFlow flows[MXA_FLOW_CACHE_MAX_FLOW][2];
+} MxaModelObject;
+
+// locks one flow of the model and refreshes its entry if stale, flows beyond the table get 'local'; called without GIL
+static MxaFlowCache* _model_flow_acquire(MxaModelObject* model, uint8_t flow_id, int dir, MxaFlowCache* local, memx_status* status)
+{
+  MxaModelFlow* entry;
+  unsigned int gen;
+
+  if(flow_id >= MXA_FLOW_CACHE_MAX_FLOW) {
+    *status = _flow_cache_fill(local, model->model_id, flow_id, dir);
+    if(memx_status_error(*status)) {
+      _flow_cache_free(local);
+      return NULL;
+    }
+    return local;
+  }
+
+  entry = &model->flows[flow_id][dir];
+  PyThread_acquire_lock(entry->lock, WAIT_LOCK);
+  if(!model->opened) {
+    PyThread_release_lock(entry->lock);
+    *status = MEMX_STATUS_OTHERS;
+    return NULL;
+  }
+  gen = __atomic_load_n(&_flow_cache_gen[model->model_id], __ATOMIC_ACQUIRE);
+  if(!entry->cache.valid || entry->gen != gen) {
+    _flow_cache_free(&entry->cache);
+    *status = _flow_cache_fill(&entry->cache, model->model_id, flow_id, dir);
+    if(memx_status_error(*status)) {
+      _flow_cache_free(&entry->cache);
+      entry->cache.valid = 0;
+      PyThread_release_lock(entry->lock);
+      return NULL;
+    }
+    entry->gen = gen;
+  }
+  *status = MEMX_STATUS_OK;
+  return &entry->cache;
+}
+
+static void _model_flow_release(MxaModelObject* model, uint8_t flow_id, int dir, MxaFlowCache* flow, MxaFlowCache* local)
+{
+  if(flow == local) {
+    _flow_cache_free(local);
+    return;
+  }
+  PyThread_release_lock(model->flows[flow_id][dir].lock);
+}
+
+// waits for every flow in use, then closes the model and drops its entries; called without GIL
+static memx_status _model_close(MxaModelObject* model)
+{
+  memx_status status = MEMX_STATUS_OK;
+
+  for(int flow_id = 0; flow_id < MXA_FLOW_CACHE_MAX_FLOW; ++flow_id)
+    for(int dir = 0; dir < 2; ++dir)
+      PyThread_acquire_lock(model->flows[flow_id][dir].lock, WAIT_LOCK);
+
+  if(model->opened) {
+    status = memx_close(model->model_id);
+    _flow_cache_invalidate(model->model_id);
+    _flow_config_reset(model->model_id);
+    model->opened = 0;
+  }
+  for(int flow_id = 0; flow_id < MXA_FLOW_CACHE_MAX_FLOW; ++flow_id) {
+    for(int dir = 0; dir < 2; ++dir) {
+      _flow_cache_free(&model->flows[flow_id][dir].cache);
+      model->flows[flow_id][dir].cache.valid = 0;
+      PyThread_release_lock(model->flows[flow_id][dir].lock);
+    }
+  }
+  return status;
+}
+
+static int _model_check_open(MxaModelObject* model)
+{
+  if(!model->opened) {
+    PyErr_SetString(PyExc_ValueError, "operation on closed mxa.Model");
+    return -1;
+  }
+  return 0;
+}
+
+static PyObject* _model_new(PyTypeObject* type, PyObject* args, PyObject* kwargs)
+{
+  MxaModelObject* model = (MxaModelObject*)type->tp_alloc(type, 0);
+  if(model == NULL)
+    return NULL;
+
+  for(int flow_id = 0; flow_id < MXA_FLOW_CACHE_MAX_FLOW; ++flow_id) {
+    for(int dir = 0; dir < 2; ++dir) {
+      model->flows[flow_id][dir].lock = PyThread_allocate_lock();
+      if(model->flows[flow_id][dir].lock == NULL) {
+        Py_DECREF(model);
+        return PyErr_NoMemory();
+      }
+    }
+  }
+
+  unused(args);
+  unused(kwargs);
+  return (PyObject*)model;
+}
+
+static int _model_init(MxaModelObject* model, PyObject* args, PyObject* kwargs)
+{
+  memx_status status;
+  uint8_t model_id; // mandatory
+  uint8_t group_id; // mandatory
+  float chip_gen; // mandatory
+
+  static char *kwlist[] = {"model_id","group_id","chip_gen",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "bbf", kwlist, &model_id, &group_id, &chip_gen)) {
+    PyErr_BadArgument();
+    return -1;
+  }
+  if(model_id >= MEMX_MODEL_MAX_NUMBER) {
+    PyErr_Format(PyExc_ValueError, "model_id must be below %d", MEMX_MODEL_MAX_NUMBER);
+    return -1;
+  }
+  if(model->opened) {
+    PyErr_SetString(PyExc_ValueError, "mxa.Model already opened");
+    return -1;
+  }
+  {
+    Py_BEGIN_ALLOW_THREADS
+    status = memx_open(model_id, group_id, chip_gen);
+    if(memx_status_no_error(status)) {
+      _flow_cache_invalidate(model_id);
+      _flow_config_reset(model_id);
+    }
+    Py_END_ALLOW_THREADS
+  }
+  if(memx_status_error(status)) {
+    PyErr_Format(PyExc_RuntimeError, "memx_open(%d, %d) failed, status %d", model_id, group_id, status);
+    return -1;
+  }
+  model->model_id = model_id;
+  model->group_id = group_id;
+  model->opened = 1;
+  return 0;
+}
+
+static void _model_dealloc(MxaModelObject* model)
+{
+  // no other reference left, so no flow can be in use
+  if(model->opened) {
+    Py_BEGIN_ALLOW_THREADS
+    _model_close(model);
+    Py_END_ALLOW_THREADS
+  }
+  for(int flow_id = 0; flow_id < MXA_FLOW_CACHE_MAX_FLOW; ++flow_id) {
+    for(int dir = 0; dir < 2; ++dir) {
+      if(model->flows[flow_id][dir].lock)
+        PyThread_free_lock(model->flows[flow_id][dir].lock);
+    }
+  }
+  Py_TYPE(model)->tp_free((PyObject*)model);
+}
+
+static PyObject* _model_close_method(MxaModelObject* model, PyObject* args)
+{
+  memx_status status;
+
+  Py_BEGIN_ALLOW_THREADS
+  status = _model_close(model);
+  Py_END_ALLOW_THREADS
+
+  unused(args);
+  return Py_BuildValue("i", status);
+}
+
+static PyObject* _model_enter(MxaModelObject* model, PyObject* args)
+{
+  unused(args);
+  if(_model_check_open(model))
+    return NULL;
+  Py_INCREF(model);
+  return (PyObject*)model;
+}
+
+static PyObject* _model_exit(MxaModelObject* model, PyObject* args)
+{
+  memx_status status;
+  uint8_t model_id = model->model_id;
+  PyObject *exc_type = Py_None, *exc_value = Py_None, *traceback = Py_None;
+
+  if(!PyArg_ParseTuple(args, "|OOO", &exc_type, &exc_value, &traceback)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  Py_BEGIN_ALLOW_THREADS
+  status = _model_close(model);
+  Py_END_ALLOW_THREADS
+
+  // an exception leaving the with block wins over a failed close
+  if(memx_status_error(status) && exc_type == Py_None) {
+    PyErr_Format(PyExc_RuntimeError, "memx_close(%d) failed, status %d", model_id, status);
+    return NULL;
+  }
+  Py_RETURN_FALSE;
+}
+
+static PyObject* _model_download(MxaModelObject* model, PyObject* args, PyObject *kwargs)
+{
+  memx_status status;
+  const char* file_path; // mandatory
+  uint8_t model_idx = 0; // optional = 0
+  int type = MEMX_DOWNLOAD_TYPE_WTMEM_AND_MODEL; // optional
+
+  static char *kwlist[] = {"file_path","model_idx","type",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "s|bi", kwlist, &file_path, &model_idx, &type)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  if(_model_check_open(model))
+    return NULL;
+  {
+    Py_BEGIN_ALLOW_THREADS
+    status = memx_download_model(model->model_id, file_path, model_idx, type);
+    _flow_cache_invalidate(model->model_id);
+    Py_END_ALLOW_THREADS
+  }
+
+  return Py_BuildValue("i", status);
+}
+
+static PyObject* _model_set_stream(MxaModelObject* model, PyObject* args, PyObject *kwargs, int enable)
+{
+  memx_status status;
+  int wait = 1; // optional = 1
+
+  static char *kwlist[] = {"wait",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "|i", kwlist, &wait)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  if(_model_check_open(model))
+    return NULL;
+  {
+    Py_BEGIN_ALLOW_THREADS
+    if(enable)
+      status = memx_set_stream_enable(model->model_id, wait);
+    else
+      status = memx_set_stream_disable(model->model_id, wait);
+    Py_END_ALLOW_THREADS
+  }
+
+  return Py_BuildValue("i", status);
+}
+
+static PyObject* _model_set_stream_enable(MxaModelObject* model, PyObject* args, PyObject *kwargs)
+{
+  return _model_set_stream(model, args, kwargs, 1);
+}
+
+static PyObject* _model_set_stream_disable(MxaModelObject* model, PyObject* args, PyObject *kwargs)
+{
+  return _model_set_stream(model, args, kwargs, 0);
+}
+
+static PyObject* _model_get_fmap_size(MxaModelObject* model, PyObject* args, int dir)
+{
+  memx_status status;
+  uint8_t flow_id;
+  int height = 0, width = 0, z = 0, channel_number = 0, format = 0;
+
+  if(!PyArg_ParseTuple(args, "b", &flow_id)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  if(_model_check_open(model))
+    return NULL;
+  {
+    Py_BEGIN_ALLOW_THREADS
+    if(dir == MXA_FLOW_IFMAP)
+      status = memx_get_ifmap_size(model->model_id, flow_id, &height, &width, &z, &channel_number, &format);
+    else
+      status = memx_get_ofmap_size(model->model_id, flow_id, &height, &width, &z, &channel_number, &format);
+    Py_END_ALLOW_THREADS
+  }
+  if(memx_status_error(status)) {
+    PyErr_Format(PyExc_RuntimeError, "memx_get_%s_size(%d, %d) failed, status %d",
+                 (dir == MXA_FLOW_IFMAP) ? "ifmap" : "ofmap", model->model_id, flow_id, status);
+    return NULL;
+  }
+
+  return Py_BuildValue("(iiii)", height, width, z, channel_number);
+}
+
+static PyObject* _model_get_ifmap_size(MxaModelObject* model, PyObject* args)
+{
+  return _model_get_fmap_size(model, args, MXA_FLOW_IFMAP);
+}
+
+static PyObject* _model_get_ofmap_size(MxaModelObject* model, PyObject* args)
+{
+  return _model_get_fmap_size(model, args, MXA_FLOW_OFMAP);
+}
+
+// one frame in or out, fmap_buf picks the driver fmap buffer path
+static PyObject* _model_stream_frame(MxaModelObject* model, PyObject* args, PyObject *kwargs, int dir, int fmap_buf)
+{
+  memx_status status;
+  uint8_t flow_id; // mandatory
+  PyArrayObject* fmap; // mandatory
+  int timeout = 0; // optional = 0 (infinite)
+  int is_u8;
+  MxaFlowCache local;
+  MxaFlowCache* flow;
+
+  static char *kwlist_ifmap[] = {"flow_id","ifmap","timeout",NULL};
+  static char *kwlist_ofmap[] = {"flow_id","ofmap","timeout",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "bO!|i", (dir == MXA_FLOW_IFMAP) ? kwlist_ifmap : kwlist_ofmap,
+                                  &flow_id, &PyArray_Type, &fmap, &timeout)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  if(_model_check_open(model))
+    return NULL;
+
+  is_u8 = (PyArray_TYPE(fmap) == NPY_UINT8);
+  {
+    Py_INCREF(fmap);
+    Py_BEGIN_ALLOW_THREADS
+    flow = _model_flow_acquire(model, flow_id, dir, &local, &status);
+    if(flow != NULL) {
+      void* data = (void*)PyArray_DATA(fmap);
+      int u8 = is_u8 && (flow->fmt_size > 0);
+      if(dir == MXA_FLOW_IFMAP)
+        status = fmap_buf ? _enqueue_ifmap_frame(flow, model->model_id, flow_id, data, u8, timeout)
+                          : _stream_ifmap_frame(flow, model->model_id, flow_id, data, u8, timeout);
+      else
+        status = fmap_buf ? _dequeue_ofmap_frame(flow, model->model_id, flow_id, data, timeout)
+                          : _stream_ofmap_frame(flow, model->model_id, flow_id, data, timeout);
+      _model_flow_release(model, flow_id, dir, flow, &local);
+    }
+    Py_END_ALLOW_THREADS
+    Py_DECREF(fmap);
+  }
+
+  return Py_BuildValue("i", status);
+}
+
+static PyObject* _model_stream_ifmap(MxaModelObject* model, PyObject* args, PyObject *kwargs)
+{
+  return _model_stream_frame(model, args, kwargs, MXA_FLOW_IFMAP, 0);
+}
+
+static PyObject* _model_stream_ofmap(MxaModelObject* model, PyObject* args, PyObject *kwargs)
+{
+  return _model_stream_frame(model, args, kwargs, MXA_FLOW_OFMAP, 0);
+}
+
+static PyObject* _model_enqueue_ifmap_buf(MxaModelObject* model, PyObject* args, PyObject *kwargs)
+{
+  return _model_stream_frame(model, args, kwargs, MXA_FLOW_IFMAP, 1);
+}
+
+static PyObject* _model_dequeue_ofmap_buf(MxaModelObject* model, PyObject* args, PyObject *kwargs)
+{
+  return _model_stream_frame(model, args, kwargs, MXA_FLOW_OFMAP, 1);
+}
+
+// batches hold the flow lock across the (GIL held) array checks and the streaming
+static PyObject* _model_stream_batch(MxaModelObject* model, PyObject* args, PyObject *kwargs, int dir)
+{
+  memx_status status;
+  uint8_t flow_id; // mandatory
+  PyObject* fmaps_obj; // mandatory, [N, ...]
+  int timeout = 0; // optional = 0 (infinite)
+  int frames = -1; // optional = -1 (N), cycles through the N frames if larger
+  int fmap_buf = 0; // optional = 0, 1 converts in place in driver fmap buffers
+  MxaFlowCache local;
+  MxaFlowCache* flow;
+  PyObject* result;
+
+  static char *kwlist_ifmap[] = {"flow_id","ifmaps","timeout","frames","fmap_buf",NULL};
+  static char *kwlist_ofmap[] = {"flow_id","ofmaps","timeout","frames","fmap_buf",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "bO|iii", (dir == MXA_FLOW_IFMAP) ? kwlist_ifmap : kwlist_ofmap,
+                                  &flow_id, &fmaps_obj, &timeout, &frames, &fmap_buf)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  if(dir == MXA_FLOW_OFMAP && !PyArray_Check(fmaps_obj)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  if(_model_check_open(model))
+    return NULL;
+
+  Py_BEGIN_ALLOW_THREADS
+  flow = _model_flow_acquire(model, flow_id, dir, &local, &status);
+  Py_END_ALLOW_THREADS
+  if(flow == NULL){ return Py_BuildValue("(ii)", status, 0); }
+  if(dir == MXA_FLOW_IFMAP)
+    result = _stream_ifmap_batch(flow, model->model_id, flow_id, fmaps_obj, timeout, frames, fmap_buf);
+  else
+    result = _stream_ofmap_batch(flow, model->model_id, flow_id, (PyArrayObject*)fmaps_obj, timeout, frames, fmap_buf);
+  _model_flow_release(model, flow_id, dir, flow, &local);
+
+  return result;
+}
+
+static PyObject* _model_stream_ifmap_batch(MxaModelObject* model, PyObject* args, PyObject *kwargs)
+{
+  return _model_stream_batch(model, args, kwargs, MXA_FLOW_IFMAP);
+}
+
+static PyObject* _model_stream_ofmap_batch(MxaModelObject* model, PyObject* args, PyObject *kwargs)
+{
+  return _model_stream_batch(model, args, kwargs, MXA_FLOW_OFMAP);
+}
+
+static PyObject* _model_set_ifmap_transform(MxaModelObject* model, PyObject* args, PyObject *kwargs)
+{
+  uint8_t flow_id; // mandatory
+  float shift = 0.0f; // optional = 0
+  float scale = 1.0f; // optional = 1
+
+  static char *kwlist[] = {"flow_id","shift","scale",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "b|ff", kwlist, &flow_id, &shift, &scale)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  if(_model_check_open(model))
+    return NULL;
+  if(flow_id >= MXA_FLOW_CACHE_MAX_FLOW)
+    return Py_BuildValue("i", MEMX_STATUS_OTHERS);
+
+  Py_BEGIN_ALLOW_THREADS
+  _flow_config_set_transform(model->model_id, flow_id, shift, scale);
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("i", MEMX_STATUS_OK);
+}
+
+static PyObject* _model_set_ofmap_layout(MxaModelObject* model, PyObject* args, PyObject *kwargs)
+{
+  uint8_t flow_id; // mandatory
+  int layout; // mandatory
+
+  static char *kwlist[] = {"flow_id","layout",NULL};
+  if(!PyArg_ParseTupleAndKeywords(args, kwargs, "bi", kwlist, &flow_id, &layout)) {
+    PyErr_BadArgument();
+    return NULL;
+  }
+  if(layout != CONVERT_LAYOUT_HWC && layout != CONVERT_LAYOUT_CHW) {
+    PyErr_SetString(PyExc_ValueError, "layout must be mxa.fmap_layout_hwc or mxa.fmap_layout_chw");
+    return NULL;
+  }
+  if(_model_check_open(model))
+    return NULL;
+  if(flow_id >= MXA_FLOW_CACHE_MAX_FLOW)
+    return Py_BuildValue("i", MEMX_STATUS_OTHERS);
+
+  Py_BEGIN_ALLOW_THREADS
+  _flow_config_set_layout(model->model_id, flow_id, layout);
+  Py_END_ALLOW_THREADS
+
+  return Py_BuildValue("i", MEMX_STATUS_OK);
+}
+
+static PyObject* _model_get_model_id(MxaModelObject* model, void* closure)
+{
+  unused(closure);
+  return Py_BuildValue("i", model->model_id);
+}
+
+static PyObject* _model_get_group_id(MxaModelObject* model, void* closure)
+{
+  unused(closure);
+  return Py_BuildValue("i", model->group_id);
+}
+
+static PyObject* _model_get_closed(MxaModelObject* model, void* closure)
+{
+  unused(closure);
+  return PyBool_FromLong(!model->opened);
+}
+
+static PyMethodDef MxaModelMethods[] = {
+  // { name, callback, options, description }
+  {"close", (PyCFunction)_model_close_method, METH_NOARGS, NULL},
+  {"__enter__", (PyCFunction)_model_enter, METH_NOARGS, NULL},
+  {"__exit__", (PyCFunction)_model_exit, METH_VARARGS, NULL},
+  {"download", (PyCFunction)_model_download, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"set_stream_enable", (PyCFunction)_model_set_stream_enable, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"set_stream_disable", (PyCFunction)_model_set_stream_disable, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"get_ifmap_size", (PyCFunction)_model_get_ifmap_size, METH_VARARGS, NULL},
+  {"get_ofmap_size", (PyCFunction)_model_get_ofmap_size, METH_VARARGS, NULL},
+  {"stream_ifmap", (PyCFunction)_model_stream_ifmap, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"stream_ofmap", (PyCFunction)_model_stream_ofmap, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"stream_ifmap_batch", (PyCFunction)_model_stream_ifmap_batch, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"stream_ofmap_batch", (PyCFunction)_model_stream_ofmap_batch, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"enqueue_ifmap_buf", (PyCFunction)_model_enqueue_ifmap_buf, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"dequeue_ofmap_buf", (PyCFunction)_model_dequeue_ofmap_buf, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"set_ifmap_transform", (PyCFunction)_model_set_ifmap_transform, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"set_ofmap_layout", (PyCFunction)_model_set_ofmap_layout, METH_VARARGS|METH_KEYWORDS, NULL},
+
+  {NULL, NULL, 0, NULL} // Sentinel
+};
+
+static PyGetSetDef MxaModelGetSet[] = {
+  // { name, getter, setter, description, closure }
+  {"model_id", (getter)_model_get_model_id, NULL, NULL, NULL},
+  {"group_id", (getter)_model_get_group_id, NULL, NULL, NULL},
+  {"closed", (getter)_model_get_closed, NULL, NULL, NULL},
+
+  {NULL, NULL, NULL, NULL, NULL} // Sentinel
+};
+
+PyDoc_STRVAR(MxaModelDoc,
+"Model(model_id, group_id, chip_gen)\n"
+"--\n"
+"\n"
+"One opened model_id on an MPU group. Owns the flow entries (metadata and\n"
+"staging buffers) of the model, so threads streaming different flows never\n"
+"contend. Use as a context manager or call close(). Methods on a closed\n"
+"model raise ValueError; a failed open, size query or close on exit raises\n"
+"RuntimeError, the other methods return the memx status.");
+
+static PyTypeObject MxaModelType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+  .tp_name = "mxa.Model",
+  .tp_basicsize = sizeof(MxaModelObject),
+  .tp_flags = Py_TPFLAGS_DEFAULT,
+  .tp_doc = MxaModelDoc,
+  .tp_new = _model_new,
+  .tp_init = (initproc)_model_init,
+  .tp_dealloc = (destructor)_model_dealloc,
+  .tp_methods = MxaModelMethods,
+  .tp_getset = MxaModelGetSet,
+};
+
+/***************************************************************************//**
+ * module method
+ ******************************************************************************/
+static PyMethodDef MemxMethods[] = {
+  // { name, callback, options, description }
+  {"lock", (PyCFunction)_wrap_memx_lock, METH_VARARGS, NULL},
+  {"trylock", (PyCFunction)_wrap_memx_trylock, METH_VARARGS, NULL},
+  {"unlock", (PyCFunction)_wrap_memx_unlock, METH_VARARGS, NULL},
+  {"open", (PyCFunction)_wrap_memx_open, METH_VARARGS, NULL},
+  {"close", (PyCFunction)_wrap_memx_close, METH_VARARGS, NULL},
+  {"abort", (PyCFunction)_wrap_memx_abort, METH_VARARGS, NULL},
+  {"operation", (PyCFunction)_wrap_memx_operation, METH_VARARGS, NULL},
+  {"chip_count", (PyCFunction)_wrap_memx_chip_count, METH_VARARGS, NULL},
+  {"config_mpu_group", (PyCFunction)_wrap_memx_config_mpu_group, METH_VARARGS, NULL},
+  {"download_model_config", (PyCFunction)_wrap_memx_download_model_config, METH_VARARGS, NULL},
+  {"download_model_wtmem", (PyCFunction)_wrap_memx_download_model_wtmem, METH_VARARGS, NULL},
+  {"download", (PyCFunction)_wrap_memx_download_model, METH_VARARGS, NULL},
+  {"download_buffer", (PyCFunction)_wrap_memx_download_model_buffer, METH_VARARGS, NULL},
+  {"update_firmware", (PyCFunction)_wrap_memx_download_firmware, METH_VARARGS, NULL},
+  {"set_stream_enable", (PyCFunction)_wrap_memx_set_stream_enable, METH_VARARGS, NULL},
+  {"set_stream_disable", (PyCFunction)_wrap_memx_set_stream_disable, METH_VARARGS, NULL},
   {"set_ifmap_queue_size", (PyCFunction)_wrap_memx_set_ifmap_queue_size, METH_VARARGS, NULL},
   {"set_ofmap_queue_size", (PyCFunction)_wrap_memx_set_ofmap_queue_size, METH_VARARGS, NULL},
   {"get_ifmap_size", (PyCFunction)_wrap_memx_get_ifmap_size, METH_VARARGS, NULL},
@@ -1719,6 +2995,12 @@ static PyMethodDef MemxMethods[] = {
   {"get_ofmap_hpoc", (PyCFunction)_wrap_memx_get_ofmap_hpoc, METH_VARARGS, NULL},
   {"stream_ifmap", (PyCFunction)_wrap_memx_stream_ifmap, METH_VARARGS|METH_KEYWORDS, NULL},
   {"stream_ofmap", (PyCFunction)_wrap_memx_stream_ofmap, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"stream_ifmap_batch", (PyCFunction)_wrap_memx_stream_ifmap_batch, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"stream_ofmap_batch", (PyCFunction)_wrap_memx_stream_ofmap_batch, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"enqueue_ifmap_buf", (PyCFunction)_wrap_memx_enqueue_ifmap_buf, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"dequeue_ofmap_buf", (PyCFunction)_wrap_memx_dequeue_ofmap_buf, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"set_ifmap_transform", (PyCFunction)_wrap_memx_set_ifmap_transform, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"set_ofmap_layout", (PyCFunction)_wrap_memx_set_ofmap_layout, METH_VARARGS|METH_KEYWORDS, NULL},
   {"push", (PyCFunction)_wrap_memx_stream_ifmap_push, METH_VARARGS|METH_KEYWORDS, NULL},
   {"pop", (PyCFunction)_wrap_memx_stream_ofmap_pop, METH_VARARGS|METH_KEYWORDS, NULL},
   {"reset_device", (PyCFunction)_wrap_memx_reset_device, METH_VARARGS|METH_KEYWORDS, NULL},
@@ -1753,6 +3035,12 @@ static PyMethodDef MemxMethods[] = {
   {"get_device_count", (PyCFunction)_wrap_memx_get_device_count, METH_VARARGS|METH_KEYWORDS, NULL},
   {"devioctrl_i2crw", (PyCFunction)_wrap_memx_devioctrl_i2crw, METH_VARARGS, NULL},
   {"devioctrl_gpiorw", (PyCFunction)_wrap_memx_devioctrl_gpiorw, METH_VARARGS, NULL},
+  {"convert_kernel", (PyCFunction)_wrap_convert_kernel, METH_NOARGS, NULL},
+  {"set_convert_threads", (PyCFunction)_wrap_convert_set_threads, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"get_convert_threads", (PyCFunction)_wrap_convert_get_threads, METH_NOARGS, NULL},
+  {"set_bf16_rounding", (PyCFunction)_wrap_convert_set_bf16_rounding, METH_VARARGS|METH_KEYWORDS, NULL},
+  {"get_bf16_rounding", (PyCFunction)_wrap_convert_get_bf16_rounding, METH_NOARGS, NULL},
+  {"get_stream_stats", (PyCFunction)_wrap_get_stream_stats, METH_VARARGS|METH_KEYWORDS, NULL},
 
   {NULL, NULL, 0, NULL} // Sentinel
 };
@@ -1779,12 +3067,31 @@ PyInit_mxa(void)
   PyObject* module = PyModule_Create(&MemxModule);
   import_array(); // init. numpy array is required in the very beginning
 
+  // pick the fmap conversion kernels for this CPU once, before any stream call
+  convert_kernel_name();
+
+  _flow_lock = PyThread_allocate_lock();
+  if(_flow_lock == NULL || PyType_Ready(&MxaModelType) < 0)
+    return NULL;
+  Py_INCREF(&MxaModelType);
+  PyModule_AddObject(module, "Model", (PyObject*)&MxaModelType);
+#ifdef Py_GIL_DISABLED
+  // flow caches and configs are guarded by _flow_lock and the per-flow locks
+  PyUnstable_Module_SetGIL(module, Py_MOD_GIL_NOT_USED);
+#endif
+
   // wraps constant definition to module
   // renames constants here to make them short and easier to use within python
   PyModule_AddIntConstant(module, "float32", _wrap_memx_fmap_format_float32);
   PyModule_AddIntConstant(module, "uint8", _wrap_memx_fmap_format_raw);
   PyModule_AddIntConstant(module, "gbf80", _wrap_memx_fmap_format_gbf80);
 
+  PyModule_AddIntConstant(module, "fmap_layout_hwc", _wrap_memx_fmap_layout_hwc);
+  PyModule_AddIntConstant(module, "fmap_layout_chw", _wrap_memx_fmap_layout_chw);
+
+  PyModule_AddIntConstant(module, "bf16_round_half_up", _wrap_memx_bf16_round_half_up);
+  PyModule_AddIntConstant(module, "bf16_round_nearest_even", _wrap_memx_bf16_round_nearest_even);
+
   PyModule_AddIntConstant(module, "download_type_wtmem", _wrap_memx_download_type_wtmem);
   PyModule_AddIntConstant(module, "download_type_model", _wrap_memx_download_type_model);
   PyModule_AddIntConstant(module, "download_type_wtmem_and_model", _wrap_memx_download_type_wtmem_and_model);
@@ -79,6 +79,7 @@ class mxa:
                 * :code:`mxa.download_type_wtmem` / :code:`1`
                 * :code:`mxa.download_type_model` / :code:`2`
                 * :code:`mxa.download_type_wtmem_and_model` / :code:`3`
+                * :code:`mxa.download_type_wtmem_and_model_legacy` / :code:`67`
         """
         return
 
@@ -171,7 +172,7 @@ class mxa:
                 Input flow (port) ID
 
             ifmap : np.ndarray
-                Input feature map (frame)
+                Input feature map (frame). Float32, or uint8 on GBF80/BF16 ports which is encoded directly (see set_ifmap_transform())
 
             timeout : int
                 Milliseconds timeout, ‘0’ indicates infinite
@@ -197,3 +198,336 @@ class mxa:
                 Milliseconds timeout, ‘0’ indicates infinite
         """
         return
+
+    def stream_ifmap_batch(self, model_id:int, flow_id:int, ifmaps:np.ndarray, timeout:int=0, frames:int=-1, fmap_buf:int=0):
+        """
+        Stream a batch of frames into device with a single call. The batch is converted to float32 (if the port needs it) once, and all frames are sent without holding the GIL.
+
+        Parameters
+        ----------
+            model_id : int
+                Model ID
+
+            flow_id : int
+                Input flow (port) ID
+
+            ifmaps : np.ndarray
+                Input feature maps, first axis is the frame index [N, ...]. ValueError if a frame does not match the port size (one byte per element on RAW ports).
+
+            timeout : int
+                Milliseconds timeout, ‘0’ indicates infinite
+
+            frames : int
+                Number of frames to send, cycling through the N frames of 'ifmaps'. '-1' sends each frame once.
+
+            fmap_buf : int
+                '1' sends each frame like enqueue_ifmap_buf(), '0' like stream_ifmap().
+
+        Returns
+        -------
+            (status, sent) : tuple
+                Status of the last transfer and number of frames sent. Stops at the first failing frame.
+        """
+        return
+
+    def stream_ofmap_batch(self, model_id:int, flow_id:int, ofmaps:np.ndarray, timeout:int=0, frames:int=-1, fmap_buf:int=0):
+        """
+        Stream a batch of frames out from device with a single call, without holding the GIL.
+
+        Parameters
+        ----------
+            model_id : int
+                Model ID
+
+            flow_id : int
+                Output flow (port) ID
+
+            ofmaps : np.ndarray
+                Writable C-contiguous output feature maps, first axis is the frame index [N, ...]. Must be float32 for float ports. ValueError if a frame does not match the port size (one byte per element on RAW ports).
+
+            timeout : int
+                Milliseconds timeout, ‘0’ indicates infinite
+
+            frames : int
+                Number of frames to receive, cycling through the N slots of 'ofmaps'. '-1' fills each slot once.
+
+            fmap_buf : int
+                '1' receives each frame like dequeue_ofmap_buf(), '0' like stream_ofmap().
+
+        Returns
+        -------
+            (status, received) : tuple
+                Status of the last transfer and number of frames received. Stops at the first failing frame.
+        """
+        return
+
+    def enqueue_ifmap_buf(self, model_id:int, flow_id:int, ifmap:np.ndarray, timeout:int=0):
+        """
+        Stream data into device through the driver feature map buffers. A free input buffer is dequeued, the frame is converted (GBF80/BF16) directly into it and the buffer is enqueued for transfer, saving the copy stream_ifmap() makes from its own conversion buffer. Ports without conversion fall back to stream_ifmap(). Do not mix with stream_ifmap() on the same input flow.
+
+        Parameters
+        ----------
+            model_id : int
+                Model ID
+
+            flow_id : int
+                Input flow (port) ID
+
+            ifmap : np.ndarray
+                Input feature map (frame).
+
+            timeout : int
+                Milliseconds timeout, ‘0’ indicates infinite
+        """
+        return
+
+    def dequeue_ofmap_buf(self, model_id:int, flow_id:int, ofmap:np.ndarray, timeout:int=0):
+        """
+        Stream data out from device through the driver feature map buffers. The next received output buffer is dequeued, converted (GBF80/BF16) directly into 'ofmap' and handed back to the driver, saving the copy stream_ofmap() makes into its own conversion buffer. Ports without conversion fall back to stream_ofmap().
+
+        Parameters
+        ----------
+            model_id : int
+                Model ID
+
+            flow_id : int
+                Output flow (port) ID
+
+            ofmap : np.ndarray
+                Output feature map (frame).
+
+            timeout : int
+                Milliseconds timeout, ‘0’ indicates infinite
+        """
+        return
+
+    def set_ifmap_transform(self, model_id:int, flow_id:int, shift:float=0.0, scale:float=1.0):
+        """
+        Set the transform applied to uint8 frames streamed into a GBF80/BF16 input port. Each value is expanded as (x + shift) * scale while being encoded, so a normalization like (x - 127.5) / 127.5 costs no extra pass and no float32 copy of the frame. Float32 frames are not affected. Reset to identity by open() and close().
+
+        Parameters
+        ----------
+            model_id : int
+                Model ID
+
+            flow_id : int
+                Input flow (port) ID
+
+            shift : float
+                Added to each uint8 value first
+
+            scale : float
+                Multiplied after the shift
+        """
+        return
+
+    def set_ofmap_layout(self, model_id:int, flow_id:int, layout:int):
+        """
+        Set the layout GBF80/BF16 output frames are decoded into. HPOC dummy channels are always dropped during the decode, so the frame holds only the real channels in either layout. Reset to HWC by open() and close().
+
+        Parameters
+        ----------
+            model_id : int
+                Model ID
+
+            flow_id : int
+                Output flow (port) ID
+
+            layout : int
+                * :code:`mxa.fmap_layout_hwc` / :code:`0`: [height, width, z, channel], as sent by the device
+                * :code:`mxa.fmap_layout_chw` / :code:`1`: [channel, height, width, z], one plane per channel
+        """
+        return
+
+    def convert_kernel(self):
+        """
+        Name of the feature map conversion kernels (GBF80/BF16 encode and decode) selected for the host CPU at import time. Set environment variable MEMX_CONVERT_KERNEL before import to force a lower kernel set.
+
+        Returns
+        -------
+            name : str
+                'avx512', 'avx2', 'neon' or 'scalar'
+        """
+        return
+
+    def set_convert_threads(self, num_threads:int, threshold:int=-1):
+        """
+        Configure multithreaded feature map conversion. GBF80 encode/decode of tensors with at least 'threshold' float elements is split by rows (or pixels) across the OpenMP thread pool; smaller tensors convert on the calling thread.
+
+        Parameters
+        ----------
+            num_threads : int
+                Worker threads per conversion, '0' uses the OpenMP default (OMP_NUM_THREADS or all cores)
+
+            threshold : int
+                Minimum tensor size in elements to go parallel, '-1' keeps the current value (default 262144)
+        """
+        return
+
+    def get_convert_threads(self):
+        """
+        Current multithreaded conversion settings.
+
+        Returns
+        -------
+            (num_threads, threshold) : tuple
+                See set_convert_threads()
+        """
+        return
+
+    def set_bf16_rounding(self, rounding:int):
+        """
+        Select how float32 frames are rounded when encoded for BF16 ports (float32 and uint8 input). Applies process wide; GBF80 ports are not affected.
+
+        Parameters
+        ----------
+            rounding : int
+                * :code:`mxa.bf16_round_half_up` / :code:`0`: add half an ulp and truncate (default, matches GBF80 rounding)
+                * :code:`mxa.bf16_round_nearest_even` / :code:`1`: round to nearest even, NaN stays a (quiet) NaN. Costs about 2x the encode time on frames that stay in cache (AVX2 ~21 vs ~50 GB/s), little on frames streamed from memory
+        """
+        return
+
+    def get_bf16_rounding(self):
+        """
+        Current BF16 encode rounding, see set_bf16_rounding().
+
+        Returns
+        -------
+            rounding : int
+                :code:`mxa.bf16_round_half_up` or :code:`mxa.bf16_round_nearest_even`
+        """
+        return
+
+    def get_stream_stats(self, reset:int=1):
+        """
+        Wall time the calling thread spent in stream calls (stream/enqueue/dequeue, single and batch) since the last reset. Counters are per thread, so read them from the thread that streams.
+
+        Parameters
+        ----------
+            reset : int
+                '1' clears the counters of the calling thread after reading them (default), '0' keeps them
+
+        Returns
+        -------
+            stats : dict
+                * 'convert_ns', 'convert_frames': GBF80/BF16 encode and decode of frames
+                * 'driver_ns', 'driver_calls': driver library calls, i.e. copies, syscalls and queue waits
+                * 'convert_start', 'convert_end': CLOCK_MONOTONIC ns (time.monotonic_ns() on Linux) span of the last encode or decode, 0 if none
+        """
+        return
+
+    class Model:
+        """
+        Handle of one opened model. Owns the model ID, the cached port metadata and conversion staging buffers of its flows, and one lock per flow. All device calls run without the GIL, so threads driving different flows (or different Model objects) stream concurrently; threads sharing a flow take turns on its lock. Transforms, layouts and downloads are shared with the module-level functions of the same model ID.
+
+        Can be used as a context manager, which closes the model on exit.
+
+        Parameters
+        ----------
+            model_id : int
+                Model ID
+
+            group_id : int
+                MPU device group ID
+
+            chip_gen : int
+                Target system
+
+        Raises
+        ------
+            RuntimeError
+                The model could not be opened.
+        """
+
+        model_id : int
+        """Model ID (read-only)."""
+
+        group_id : int
+        """MPU device group ID (read-only)."""
+
+        closed : bool
+        """True once close() was called."""
+
+        def close(self):
+            """
+            Wait for streams in progress on every flow, then close the model. Further calls raise ValueError; closing again is a no-op.
+            """
+            return
+
+        def download(self, file_path:str, model_idx:int=0, type:int=3):
+            """
+            Download weight memory and/or model, see mxa.download().
+            """
+            return
+
+        def set_stream_enable(self, wait:int=1):
+            """
+            Enable all input and output data flows of this model, see mxa.set_stream_enable().
+            """
+            return
+
+        def set_stream_disable(self, wait:int=1):
+            """
+            Disable all input and output data flows of this model, see mxa.set_stream_disable().
+            """
+            return
+
+        def get_ifmap_size(self, flow_id:int):
+            """
+            Shape (height, width, z, channel) of an input flow.
+            """
+            return
+
+        def get_ofmap_size(self, flow_id:int):
+            """
+            Shape (height, width, z, channel) of an output flow.
+            """
+            return
+
+        def stream_ifmap(self, flow_id:int, ifmap:np.ndarray, timeout:int=0):
+            """
+            Same as mxa.stream_ifmap() on this model.
+            """
+            return
+
+        def stream_ofmap(self, flow_id:int, ofmap:np.ndarray, timeout:int=0):
+            """
+            Same as mxa.stream_ofmap() on this model.
+            """
+            return
+
+        def stream_ifmap_batch(self, flow_id:int, ifmaps:np.ndarray, timeout:int=0, frames:int=-1, fmap_buf:int=0):
+            """
+            Same as mxa.stream_ifmap_batch() on this model. The flow stays locked for the whole batch.
+            """
+            return
+
+        def stream_ofmap_batch(self, flow_id:int, ofmaps:np.ndarray, timeout:int=0, frames:int=-1, fmap_buf:int=0):
+            """
+            Same as mxa.stream_ofmap_batch() on this model. The flow stays locked for the whole batch.
+            """
+            return
+
+        def enqueue_ifmap_buf(self, flow_id:int, ifmap:np.ndarray, timeout:int=0):
+            """
+            Same as mxa.enqueue_ifmap_buf() on this model.
+            """
+            return
+
+        def dequeue_ofmap_buf(self, flow_id:int, ofmap:np.ndarray, timeout:int=0):
+            """
+            Same as mxa.dequeue_ofmap_buf() on this model.
+            """
+            return
+
+        def set_ifmap_transform(self, flow_id:int, shift:float=0.0, scale:float=1.0):
+            """
+            Same as mxa.set_ifmap_transform() on this model.
+            """
+            return
+
+        def set_ofmap_layout(self, flow_id:int, layout:int):
+            """
+            Same as mxa.set_ofmap_layout() on this model.
+            """
+            return
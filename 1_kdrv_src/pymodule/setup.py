@@ -41,16 +41,16 @@ sources = ['memxmodule.c']
 #  sources += [str(source) for source in pathlib.Path(source_dir).glob('*.c')]
 
 if sys.platform.startswith('linux'):
-  extra_link_args=['-lmemx']
+  extra_link_args=['-lmemx','-fopenmp']
   extra_compile_args=['-O3','-std=c17','-fno-math-errno','-funsafe-math-optimizations',
                       '-ffinite-math-only','-fno-signed-zeros',
                       '-fno-trapping-math','-fno-signaling-nans',
                       '-fcx-limited-range','-fopenmp']
 
-  # faster conversions with AVX on supported hosts
+  # conversion kernels in convert.h are built per ISA (AVX2/AVX-512) and picked
+  # at runtime, so keep the baseline generic to run on any x86_64 host
   if str(platform.machine()).lower() == 'x86_64':
-    extra_compile_args += ['-mpopcnt','-msse','-msse2','-msse3','-mssse3','-msse4.1','-msse4.2','-mavx','-mavx2','-mfma','-mbmi','-mbmi2','-maes','-mpclmul','-mcx16',
-                           '-mf16c','-mfsgsbase','-mlzcnt','-mmovbe','-mprfchw','-mxsave','-mxsavec','-mxsaves','-mxsaveopt','-msahf','-mclflushopt','-madx','-mtune=generic']
+    extra_compile_args += ['-mtune=generic']
 
   elif str(platform.machine()).lower() == 'aarch64' or str(platform.machine()).lower() == 'armv8l':
     extra_compile_args += ['-march=armv8-a+simd']
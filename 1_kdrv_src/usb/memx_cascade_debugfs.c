@@ -213,12 +213,28 @@ int memx_read_chip0(struct memx_data *data, uint32_t *buffer, uint32_t address,
 	}
 }
 
-int memx_get_logbuffer(struct memx_data *data, uint32_t chipid, u8 *buffer, uint32_t maxsize)
+static void memx_logrxcomplete(struct urb *urb)
+{
+	struct memx_data *data = urb->context;
+
+	complete(&data->logrx_comp);
+}
+
+/*
+ * DBGFS_ID_GETLOG round trip. The response lands in rxurb/rbuffer and is copied
+ * to buffer (if given) before cfglock is dropped. With nowait, returns -EBUSY
+ * instead of waiting for a cfglock holder (e.g. memx_write) to finish.
+ */
+static int memx_getlog_xfer(struct memx_data *data, uint32_t chipid, struct urb *rxurb, u8 *rbuffer,
+	usb_complete_t rxcomplete, struct completion *rxcomp, u8 *buffer, uint32_t maxsize, bool nowait)
 {
 	uint32_t cfg_header[5] = {0};
 	int ret = 0;
 
-	mutex_lock(&data->cfglock);
+	if (!nowait)
+		mutex_lock(&data->cfglock);
+	else if (!mutex_trylock(&data->cfglock))
+		return -EBUSY;
 
 	cfg_header[0] = DBGFS_ID_GETLOG;
 	cfg_header[1] = chipid;/* chip id */
@@ -246,30 +262,31 @@ int memx_get_logbuffer(struct memx_data *data, uint32_t chipid, u8 *buffer, uint
 		return ret;
 	}
 
-	usb_fill_bulk_urb(data->fw_rxurb, data->udev, usb_rcvbulkpipe(data->udev, MEMX_FW_IN_EP),
-		data->fw_rbuffer, maxsize, memx_fwrxcomplete, data);
+	usb_fill_bulk_urb(rxurb, data->udev, usb_rcvbulkpipe(data->udev, MEMX_FW_IN_EP),
+		rbuffer, maxsize, rxcomplete, data);
 
 	/* get the data in the bulk port */
-	if (usb_submit_urb(data->fw_rxurb, GFP_KERNEL) < 0) {
+	if (usb_submit_urb(rxurb, GFP_KERNEL) < 0) {
 		pr_err("Can't submit memxcmd read");
 		ret = -ENOMEM;
 		mutex_unlock(&data->cfglock);
 		return ret;
 	}
 
-	if (!wait_for_completion_timeout(&data->fwrx_comp, msecs_to_jiffies(500))) {
-		usb_kill_urb(data->fw_rxurb);
+	if (!wait_for_completion_timeout(rxcomp, msecs_to_jiffies(500))) {
+		usb_kill_urb(rxurb);
 		pr_info("Can't wait %s response\n", __func__);
 		ret = -ENOMEM;
 		mutex_unlock(&data->cfglock);
 		return ret;
 	}
 
-	if (data->fw_rxurb->actual_length > 0) {
-		memcpy(buffer, (uint32_t *)data->fw_rbuffer, data->fw_rxurb->actual_length);
-		//pr_err("GETLOG recv size %d\r\n", data->fw_rxurb->actual_length);
+	if (rxurb->actual_length > 0) {
+		if (buffer)
+			memcpy(buffer, rbuffer, rxurb->actual_length);
+		//pr_err("GETLOG recv size %d\r\n", rxurb->actual_length);
 		mutex_unlock(&data->cfglock);
-		return data->fw_rxurb->actual_length;
+		return rxurb->actual_length;
 
 	} else {
 		pr_err("%s response fail\r\n", __func__);
@@ -278,4 +295,16 @@ int memx_get_logbuffer(struct memx_data *data, uint32_t chipid, u8 *buffer, uint
 	}
 }
 
+int memx_get_logbuffer(struct memx_data *data, uint32_t chipid, u8 *buffer, uint32_t maxsize)
+{
+	return memx_getlog_xfer(data, chipid, data->fw_rxurb, data->fw_rbuffer, memx_fwrxcomplete, &data->fwrx_comp, buffer, maxsize, false);
+}
 
+/*
+ * same as memx_get_logbuffer but on the stream worker's own urb, result stays in data->log_rbuffer;
+ * never waits for cfglock, returns -EBUSY while it is held
+ */
+int memx_stream_logbuffer(struct memx_data *data, uint32_t chipid, uint32_t maxsize)
+{
+	return memx_getlog_xfer(data, chipid, data->log_rxurb, data->log_rbuffer, memx_logrxcomplete, &data->logrx_comp, NULL, maxsize, true);
+}
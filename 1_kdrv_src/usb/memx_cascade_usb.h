@@ -3,6 +3,9 @@
 #define _MEMX_CASCADE_USB_H_
 
 #include <linux/cdev.h>
+#include <linux/scatterlist.h>
+#include <linux/kfifo.h>
+#include <linux/workqueue.h>
 #include "memx_cascade_debugfs.h"
 #include "memx_fs.h"
 #include "memx_fs_proc.h"
@@ -50,6 +53,8 @@
 #define MEMX_HEADER_SIZE 64
 #define MAX_MPUIN_SIZE   18000
 #define MAX_MPUOUT_SIZE  54000
+#define MEMX_DL_URB_CNT  4
+#define MEMX_FWLOG_RING_SIZE (64*1024)
 
 #define FWCFG_ID_CLR            0x952700
 #define FWCFG_ID_FW             0x952701
@@ -155,6 +160,30 @@ struct memx_file_sys {
 	union memx_fs_hif		hif;
 };
 
+/* one in-flight chunk of a pipelined firmware/dfp download */
+struct memx_dl_slot {
+	struct urb           *urb;
+	unsigned char        *buffer;
+	struct page         **pages;
+	int                   nr_pages;
+	struct sg_table       sgt;
+	struct completion     comp;
+	bool                  busy;
+};
+
+/* per-chip ring filled by the fw log stream worker, read through debugfs memx%d/fwlog<chip> */
+struct memx_fwlog_chip {
+	struct memx_data     *memx_dev;
+	struct kfifo          ring;
+	struct mutex          readlock;
+	wait_queue_head_t     wq;
+	u32                   last_wp;
+	bool                  synced;
+	u64                   dropped;
+	u32                   interval_ms;
+	unsigned long         next_poll;
+};
+
 struct memx_data {
 	struct usb_interface *interface;
 	struct usb_device    *udev;
@@ -195,6 +224,17 @@ struct memx_data {
 	u32                   reference_count;
 
 	struct cdev           feature_cdev;
+
+	struct memx_dl_slot   dl_slot[MEMX_DL_URB_CNT];
+
+	struct delayed_work   fwlog_work;
+	u32                   fwlog_period_ms;
+	bool                  fwlog_stopped;
+	struct urb           *log_rxurb;
+	unsigned char        *log_rbuffer;
+	struct completion     logrx_comp;
+	struct dentry        *fwlog_dir;
+	struct memx_fwlog_chip fwlog_chip[MAX_CHIP_NUM];
 };
 
 extern struct file_operations memx_feature_fops;
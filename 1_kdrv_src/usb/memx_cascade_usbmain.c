@@ -10,8 +10,14 @@
 #include <linux/firmware.h>
 #include <linux/uaccess.h>
 #include <linux/time.h>
+#include <linux/mm.h>
+#include <linux/scatterlist.h>
 #include "../include/memx_ioctl.h"
 #include "memx_cascade_usb.h"
+#include "memx_fw_log.h"
+#define MEMX_TRACE_SYSTEM memx_usb
+#define CREATE_TRACE_POINTS
+#include "memx_trace.h"
 
 static unsigned int frame_size = 252;
 module_param(frame_size, uint, 0);
@@ -22,6 +28,7 @@ static u32 fs_debug_en;
 static u32 pcie_lane_no	= 2;
 static u32 pcie_lane_speed = 3;
 static u32 pcie_aspm;
+static u32 fw_log_stream_ms;
 static void *device_link[MAX_CHIP_NUM];
 static DEFINE_MUTEX(device_mutex);
 static struct class *memx_feature_class;
@@ -39,6 +46,8 @@ module_param(pcie_lane_speed, uint, 0);
 MODULE_PARM_DESC(pcie_lane_speed, "Internal chip2chip pcie link speed. ValidRange: 1/2/3. 3 is default means GEN3");
 module_param(pcie_aspm, uint, 0);
 MODULE_PARM_DESC(pcie_aspm, "Internal chip2chip pcie link aspm control:: 0-FW_default(default) 1-L0_only 2-L0sL1 3-L0sL1.1");
+module_param(fw_log_stream_ms, uint, 0);
+MODULE_PARM_DESC(fw_log_stream_ms, "Stream fw logs to debugfs memx%d/fwlog<chip>:: 0-Disable(default)  N-poll period in ms");
 
 ktime_t tx_start_time = 0, tx_end_time = 0;
 ktime_t rx_start_time = 0, rx_end_time = 0;
@@ -106,6 +115,26 @@ struct DFP_DATA {
 #define MEMX_XFER_STATE_NORMAL 0
 #define MEMX_XFER_STATE_ABORT  1
 
+#define MEMX_DL_MAX_PAGES	(MAX_OPS_SIZE / PAGE_SIZE + 1)
+
+#if  KERNEL_VERSION(5, 6, 0) > _LINUX_VERSION_CODE_
+#define memx_pin_user_pages_fast(start, nr, pages) get_user_pages_fast(start, nr, 0, pages)
+static inline void memx_unpin_user_pages(struct page **pages, int nr)
+{
+	while (nr-- > 0)
+		put_page(pages[nr]);
+}
+#else
+#define memx_pin_user_pages_fast(start, nr, pages) pin_user_pages_fast(start, nr, 0, pages)
+#define memx_unpin_user_pages(pages, nr) unpin_user_pages(pages, nr)
+#endif
+
+#if  KERNEL_VERSION(5, 0, 0) > _LINUX_VERSION_CODE_
+#define memx_access_ok(addr, size) access_ok(VERIFY_READ, addr, size)
+#else
+#define memx_access_ok(addr, size) access_ok(addr, size)
+#endif
+
 #if  KERNEL_VERSION(6, 2, 0) > _LINUX_VERSION_CODE_
 static char *memx_usb_devnode(struct device *dev, umode_t *mode)
 #else
@@ -395,10 +424,193 @@ static void set_wtmem_size(struct memx_data *data, uint32_t size)
 	}
 }
 
+static void memx_dl_complete(struct urb *urb)
+{
+	struct memx_dl_slot *slot = urb->context;
+
+	complete(&slot->comp);
+}
+
+static int memx_dl_slots_alloc(struct memx_data *data)
+{
+	int i;
+
+	for (i = 0; i < MEMX_DL_URB_CNT; i++) {
+		struct memx_dl_slot *slot = &data->dl_slot[i];
+
+		slot->urb = usb_alloc_urb(0, GFP_KERNEL);
+		slot->buffer = kzalloc(MAX_OPS_SIZE, GFP_KERNEL);
+		slot->pages = kcalloc(MEMX_DL_MAX_PAGES, sizeof(struct page *), GFP_KERNEL);
+		if (!slot->urb || !slot->buffer || !slot->pages)
+			return -ENOMEM;
+
+		/* keep the same transfer framing as txurb */
+		slot->urb->transfer_flags = URB_ZERO_PACKET;
+		init_completion(&slot->comp);
+	}
+
+	return 0;
+}
+
+static void memx_dl_slots_free(struct memx_data *data)
+{
+	int i;
+
+	for (i = 0; i < MEMX_DL_URB_CNT; i++) {
+		struct memx_dl_slot *slot = &data->dl_slot[i];
+
+		if (slot->urb) {
+			usb_kill_urb(slot->urb);
+			usb_free_urb(slot->urb);
+			slot->urb = NULL;
+		}
+		kfree(slot->buffer);
+		slot->buffer = NULL;
+		kfree(slot->pages);
+		slot->pages = NULL;
+	}
+}
+
+static bool memx_dl_can_pin(struct memx_data *data)
+{
+	/* pinned user pages go out as scatter-gather, which needs a controller without sg length rules (xHCI) */
+	return data->udev->bus->no_sg_constraint && (data->udev->bus->sg_tablesize >= MEMX_DL_MAX_PAGES);
+}
+
+static int memx_dl_slot_pin(struct memx_dl_slot *slot, const u8 __user *ubuf, u32 len)
+{
+	unsigned long start = (unsigned long)ubuf;
+	unsigned int offset = offset_in_page(start);
+	int nr_pages = DIV_ROUND_UP(offset + len, PAGE_SIZE);
+	int pinned;
+
+	pinned = memx_pin_user_pages_fast(start & PAGE_MASK, nr_pages, slot->pages);
+	if (pinned < nr_pages) {
+		if (pinned > 0)
+			memx_unpin_user_pages(slot->pages, pinned);
+		return -EFAULT;
+	}
+
+	if (sg_alloc_table_from_pages(&slot->sgt, slot->pages, pinned, offset, len, GFP_KERNEL)) {
+		memx_unpin_user_pages(slot->pages, pinned);
+		return -ENOMEM;
+	}
+
+	slot->nr_pages = pinned;
+	return 0;
+}
+
+static void memx_dl_slot_release(struct memx_dl_slot *slot)
+{
+	if (slot->nr_pages > 0) {
+		sg_free_table(&slot->sgt);
+		memx_unpin_user_pages(slot->pages, slot->nr_pages);
+		slot->nr_pages = 0;
+	}
+	slot->urb->sg = NULL;
+	slot->urb->num_sgs = 0;
+}
+
+static int memx_dl_slot_wait(struct memx_dl_slot *slot)
+{
+	int status;
+
+	if (!slot->busy)
+		return 0;
+
+	if (!wait_for_completion_timeout(&slot->comp, msecs_to_jiffies(MXCNST_TIMEOUT30S))) {
+		pr_err("wait dl chunk timeout\n");
+		usb_kill_urb(slot->urb);
+		status = -ETIMEDOUT;
+	} else {
+		status = slot->urb->status;
+	}
+
+	slot->busy = false;
+	memx_dl_slot_release(slot);
+	return status;
+}
+
+/*
+ * Send size bytes to MEMX_FW_OUT_EP in MAX_OPS_SIZE chunks with up to MEMX_DL_URB_CNT
+ * chunks in flight. Chunk boundaries match the old one-urb-at-a-time loop, so firmware
+ * sees the same transfers. A user source is pinned and sent as scatter-gather when the
+ * host controller allows it; otherwise the next chunk is copied into a slot buffer while
+ * the previous ones are still on the wire. Exactly one of kbuf/ubuf must be set; callers
+ * check a user range with memx_access_ok() before announcing it to firmware.
+ */
+static int memx_dl_pipelined_send(struct memx_data *data, const u8 *kbuf, const u8 __user *ubuf, u32 size)
+{
+	bool can_pin = (ubuf != NULL) && memx_dl_can_pin(data);
+	u32 offset = 0;
+	u32 n = 0;
+	int ret = 0;
+	int i;
+
+	while (offset < size) {
+		struct memx_dl_slot *slot = &data->dl_slot[n % MEMX_DL_URB_CNT];
+		u32 len = min_t(u32, size - offset, MAX_OPS_SIZE);
+
+		ret = memx_dl_slot_wait(slot);
+		if (ret) {
+			pr_err("dl chunk failed %d\n", ret);
+			break;
+		}
+
+		reinit_completion(&slot->comp);
+		if (can_pin && (len >= PAGE_SIZE) && !memx_dl_slot_pin(slot, ubuf + offset, len)) {
+			usb_fill_bulk_urb(slot->urb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
+				NULL, len, memx_dl_complete, slot);
+			slot->urb->sg = slot->sgt.sgl;
+			slot->urb->num_sgs = slot->sgt.nents;
+		} else {
+			if (ubuf) {
+				if (copy_from_user(slot->buffer, ubuf + offset, len)) {
+					pr_err("dl chunk copy_from_user fail %s:%d\n", __func__, __LINE__);
+					ret = -EFAULT;
+					break;
+				}
+			} else {
+				memcpy(slot->buffer, kbuf + offset, len);
+			}
+			usb_fill_bulk_urb(slot->urb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
+				slot->buffer, len, memx_dl_complete, slot);
+		}
+
+		/* send the data out the bulk port */
+		if (usb_submit_urb(slot->urb, GFP_KERNEL) < 0) {
+			pr_err("Can't submit dl chunk urb");
+			memx_dl_slot_release(slot);
+			ret = -ENODEV;
+			break;
+		}
+
+		slot->busy = true;
+		offset += len;
+		n++;
+	}
+
+	/* drain oldest first; on failure cancel whatever is still queued */
+	for (i = 0; i < MEMX_DL_URB_CNT; i++) {
+		struct memx_dl_slot *slot = &data->dl_slot[(n + i) % MEMX_DL_URB_CNT];
+		int status;
+
+		if (ret && slot->busy)
+			usb_kill_urb(slot->urb);
+
+		status = memx_dl_slot_wait(slot);
+		if (!ret && status) {
+			pr_err("dl chunk failed %d\n", status);
+			ret = status;
+		}
+	}
+
+	return ret;
+}
+
 static int memx_flash_download(struct memx_data *data, unsigned int cmd,
 										struct memx_firmware_bin *memx_bin)
 {
-	uint32_t remaining_size_need_to_send = 0;
 	uint32_t cfg_header[2] = {0};
 	const struct firmware *firmware;
 	uint32_t firmware_size = 0;
@@ -418,17 +630,12 @@ static int memx_flash_download(struct memx_data *data, unsigned int cmd,
 		firmware_buffer_pos = (uint8_t *)firmware->data;
 		firmware_size = firmware->size;
 	} else {
-		firmware_buffer_pos = kmalloc(memx_bin->size, GFP_KERNEL);
-		if (!firmware_buffer_pos) {
-			//pr_err("kmalloc for firmware failed\n");
-			return -ENOMEM;
-		}
-		if (copy_from_user(firmware_buffer_pos, memx_bin->buffer, memx_bin->size)) {
-			kfree(firmware_buffer_pos);
-			pr_err("cascade bin request failed\n");
-			return -ENOMEM;
-		}
+		/* sent straight from the user buffer, see memx_dl_pipelined_send */
 		firmware_size = memx_bin->size;
+		if (!memx_access_ok(memx_bin->buffer, firmware_size)) {
+			pr_err("firmware buffer not readable\n");
+			return -EFAULT;
+		}
 	}
 
 	cfg_header[0] = (cmd == MEMX_DOWNLOAD_FIRMWARE) ? FWCFG_ID_FW : FWCFG_ID_DFP;
@@ -449,76 +656,43 @@ static int memx_flash_download(struct memx_data *data, unsigned int cmd,
 		goto fail;
 	}
 
-	remaining_size_need_to_send = firmware_size;
-
-	while (remaining_size_need_to_send > 0) {
-		/* set up our urb */
-		uint32_t transfered_size = (remaining_size_need_to_send > MAX_OPS_SIZE) ?
-									MAX_OPS_SIZE : remaining_size_need_to_send;
-		memcpy(data->tbuffer, firmware_buffer_pos, transfered_size);
-
-		usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-														data->tbuffer, transfered_size, memx_complete, data);
-
-		/* send the data out the bulk port */
-		if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-			pr_err("Can't submit TX URB");
-			goto fail;
-		}
-		if (!wait_for_completion_timeout(&data->fw_comp, msecs_to_jiffies(MXCNST_TIMEOUT30S))) {
-			pr_err("wait tx timeout\n");
-			goto fail;
-		}
-
-		remaining_size_need_to_send -= transfered_size;
-		firmware_buffer_pos += transfered_size;
+	result = memx_dl_pipelined_send(data, firmware_buffer_pos, firmware_buffer_pos ? NULL : memx_bin->buffer, firmware_size);
+	if (result) {
+		pr_err("Can't send firmware data\n");
+		goto fail;
 	}
+	result = -ENOMEM;
 
-	if (remaining_size_need_to_send == 0) {
-		usb_fill_bulk_urb(data->fw_rxurb, data->udev, usb_rcvbulkpipe(data->udev, MEMX_FW_IN_EP),
-			data->fw_rbuffer, 4, memx_fwrxcomplete, data);
-
-		/* get the data in the bulk port */
-		if (usb_submit_urb(data->fw_rxurb, GFP_KERNEL) < 0) {
-			pr_err("Can't submit data read");
-			goto fail;
-		}
+	usb_fill_bulk_urb(data->fw_rxurb, data->udev, usb_rcvbulkpipe(data->udev, MEMX_FW_IN_EP),
+		data->fw_rbuffer, 4, memx_fwrxcomplete, data);
 
-		if (!wait_for_completion_timeout(&data->fwrx_comp, msecs_to_jiffies(MXCNST_TIMEOUT30S))) {
-			pr_err("wait data read timeout\n");
-			goto fail;
-		}
+	/* get the data in the bulk port */
+	if (usb_submit_urb(data->fw_rxurb, GFP_KERNEL) < 0) {
+		pr_err("Can't submit data read");
+		goto fail;
+	}
 
-		result = *((int32_t *)(data->fw_rbuffer));
-		if (result) {
-			pr_err("firmware download failed %d\n", result);
-			result = -ENOMEM;
-		} else {
-			result = 0;
-		}
+	if (!wait_for_completion_timeout(&data->fwrx_comp, msecs_to_jiffies(MXCNST_TIMEOUT30S))) {
+		pr_err("wait data read timeout\n");
+		goto fail;
 	}
 
+	result = *((int32_t *)(data->fw_rbuffer));
+	if (result) {
+		pr_err("firmware download failed %d\n", result);
+		result = -ENOMEM;
+	} else {
+		result = 0;
+	}
 
 fail:
 	clear_fw_id(data);
 	if (memx_bin->request_firmware_update_in_linux)
 		release_firmware(firmware);
-	else
-		kfree(firmware_buffer_pos);
-
 
 	return result;
 }
 
-static int checkpatch_avoid_leading_tabs(struct memx_data *data, uint8_t *dfp_wtmem_addr, uint32_t wtmem_sze)
-{
-	if (copy_from_user(data->tbuffer, dfp_wtmem_addr, wtmem_sze)) {
-		pr_err("MEMX_RUNTIMEDWN_DFP, copy_from_user fail %s:%d\n",  __func__, __LINE__);
-		return -ENOMEM;
-	}
-	return 0;
-}
-
 static int memx_seperate_dfp_download(struct memx_data *data, const unsigned char *buffer, uint32_t dfp_count, uint8_t dfp_src)
 {
 	uint32_t cfg_header[2] = {0};
@@ -560,6 +734,10 @@ static int memx_seperate_dfp_download(struct memx_data *data, const unsigned cha
 
 			cfg_size = total_length;
 			dfp_cfg_addr = dfp_len_buf + 4;
+			if (!memx_access_ok(dfp_cfg_addr, cfg_size)) {
+				pr_err("cfg data not readable\n");
+				return -EFAULT;
+			}
 
 			cfg_header[0] = FWCFG_ID_DFP_CFGSIZE;
 			cfg_header[1] = cfg_size;
@@ -580,40 +758,9 @@ static int memx_seperate_dfp_download(struct memx_data *data, const unsigned cha
 				return -ENODEV;
 			}
 
-			while (cfg_size > 0) {
-				if (cfg_size > MAX_CFG_SZ) {
-					if (copy_from_user(data->tbuffer, dfp_cfg_addr, MAX_CFG_SZ)) {
-						pr_err("MEMX_RUNTIMEDWN_DFP, copy_from_user fail %s:%d\n",  __func__, __LINE__);
-						return -ENOMEM;
-					}
-
-					usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-						data->tbuffer, MAX_CFG_SZ, memx_complete, data);
-
-					dfp_cfg_addr += MAX_CFG_SZ;
-					cfg_size -= MAX_CFG_SZ;
-				} else {
-					if (copy_from_user(data->tbuffer, dfp_cfg_addr, cfg_size)) {
-						pr_err("MEMX_RUNTIMEDWN_DFP, copy_from_user fail %s:%d\n",  __func__, __LINE__);
-						return -ENOMEM;
-					}
-
-					usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-						data->tbuffer, cfg_size, memx_complete, data);
-
-					cfg_size = 0;
-				}
-
-				/* send the data out the bulk port */
-				if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-					pr_err("Can't submit cfg data");
-					return -ENODEV;
-				}
-
-				if (!wait_for_completion_timeout(&data->fw_comp, msecs_to_jiffies(MXCNST_TIMEOUT30S))) {
-					pr_err("wait cfg data timeout\n");
-					return -ENODEV;
-				}
+			if (memx_dl_pipelined_send(data, NULL, dfp_cfg_addr, cfg_size)) {
+				pr_err("send cfg data failed\n");
+				return -ENODEV;
 			}
 
 			clear_fw_id(data);
@@ -644,44 +791,16 @@ static int memx_seperate_dfp_download(struct memx_data *data, const unsigned cha
 				wtmem_sze = wtmem_data[0] - 8;
 				reg_write_addr = wtmem_data[1];
 				dfp_wtmem_addr = dfp_wtmem_size_buf + 8;
+				if (!memx_access_ok(dfp_wtmem_addr, wtmem_sze)) {
+					pr_err("wtmem data not readable\n");
+					return -EFAULT;
+				}
 
 				set_wtmem_addr(data, FWCFG_ID_DFP_WMEMADR, reg_write_addr);
 				set_wtmem_size(data, wtmem_sze);
-				while (wtmem_sze > 0) {
-					int ret;
-
-					if (wtmem_sze > MAX_CFG_SZ)
-						ret = checkpatch_avoid_leading_tabs(data, dfp_wtmem_addr, MAX_CFG_SZ);
-					else
-						ret = checkpatch_avoid_leading_tabs(data, dfp_wtmem_addr, wtmem_sze);
-
-					if (ret < 0)
-						return -ENOMEM;
-
-					if (wtmem_sze > MAX_CFG_SZ) {
-						usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-							data->tbuffer, MAX_CFG_SZ, memx_complete, data);
-
-						dfp_wtmem_addr += MAX_CFG_SZ;
-
-						wtmem_sze -= MAX_CFG_SZ;
-					} else {
-						usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-							data->tbuffer, wtmem_sze, memx_complete, data);
-
-						wtmem_sze = 0;
-					}
-
-					/* send the data out the bulk port */
-					if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-						pr_err("Can't submit wtmem data");
-						return -ENODEV;
-					}
-
-					if (!wait_for_completion_timeout(&data->fw_comp, msecs_to_jiffies(MXCNST_TIMEOUT30S))) {
-						pr_err("wait wtmem data timeout\n");
-						return -ENODEV;
-					}
+				if (memx_dl_pipelined_send(data, NULL, dfp_wtmem_addr, wtmem_sze)) {
+					pr_err("send wtmem data failed\n");
+					return -ENODEV;
 				}
 				clear_fw_id(data);
 
@@ -1012,6 +1131,7 @@ static ssize_t memx_read(struct file *file, char __user *user_buffer, size_t cou
 	struct memx_data *data = file->private_data;
 	struct usb_interface *interface;
 	size_t xfer_size;
+	ssize_t ret_size = 0;
 	int ret = 0;
 
 	if (data == NULL)
@@ -1022,6 +1142,7 @@ static ssize_t memx_read(struct file *file, char __user *user_buffer, size_t cou
 
 	interface = data->interface;
 	rx_start_time = ktime_get();
+	trace_memx_read_start(data->minor_index, 0, count, 0);
 	mutex_lock(&data->readlock);
 
 	/* set up our urb */
@@ -1032,7 +1153,8 @@ static ssize_t memx_read(struct file *file, char __user *user_buffer, size_t cou
 	if (usb_submit_urb(data->rxurb, GFP_KERNEL) < 0) {
 		pr_err("Can't submit RX URB");
 		mutex_unlock(&data->readlock);
-		return -1;
+		ret_size = -1;
+		goto done;
 	}
 
 	/* Remove Timeout since there might be suspend in the middle*/
@@ -1043,7 +1165,8 @@ static ssize_t memx_read(struct file *file, char __user *user_buffer, size_t cou
 		usb_kill_urb(data->rxurb);
 		reinit_completion(&data->rx_comp);
 		mutex_unlock(&data->readlock);
-		return -EAGAIN;
+		ret_size = -EAGAIN;
+		goto done;
 	}
 
 	if (ret < 0) {
@@ -1051,7 +1174,7 @@ static ssize_t memx_read(struct file *file, char __user *user_buffer, size_t cou
 		usb_kill_urb(data->rxurb);
 		reinit_completion(&data->rx_comp);
 		mutex_unlock(&data->readlock);
-		return 0;
+		goto done;
 	}
 
 	xfer_size = data->rxurb->actual_length;
@@ -1059,7 +1182,8 @@ static ssize_t memx_read(struct file *file, char __user *user_buffer, size_t cou
 	if (xfer_size != 0) {
 		if (copy_to_user(user_buffer, data->rbuffer, xfer_size)) {
 			mutex_unlock(&data->readlock);
-			return -1;
+			ret_size = -1;
+			goto done;
 		}
 	}
 
@@ -1068,7 +1192,10 @@ static ssize_t memx_read(struct file *file, char __user *user_buffer, size_t cou
 	rx_end_time = ktime_get();
 	THROUGHPUT_ADD(rx_size, xfer_size);
 	THROUGHPUT_ADD(rx_time_us, ktime_us_delta(rx_end_time, rx_start_time));
-	return xfer_size;
+	ret_size = xfer_size;
+done:
+	trace_memx_read_done(data->minor_index, 0, ret_size > 0 ? ret_size : 0, ret_size);
+	return ret_size;
 }
 
 static ssize_t memx_dummy_read(struct memx_data *data)
@@ -1120,6 +1247,7 @@ static ssize_t memx_write(struct file *file, const char __user *user_buffer, siz
 	interface = data->interface;
 
 	tx_start_time = ktime_get();
+	trace_memx_write_start(data->minor_index, 0, n_bytes, 0);
 	mutex_lock(&data->cfglock);
 
 	/*Send the reset data*/
@@ -1164,6 +1292,7 @@ static ssize_t memx_write(struct file *file, const char __user *user_buffer, siz
 	tx_end_time = ktime_get();
 	THROUGHPUT_ADD(tx_size, ret_size);
 	THROUGHPUT_ADD(tx_time_us, ktime_us_delta(tx_end_time, tx_start_time));
+	trace_memx_write_done(data->minor_index, 0, n_bytes, ret_size);
 
 	return ret_size;
 }
@@ -1355,9 +1484,10 @@ static long memx_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 			ret = -ENOMEM;
 			break;
 		}
-		if (memx_flash_download(data, cmd, &memx_bin)) {
+		ret = memx_flash_download(data, cmd, &memx_bin);
+		if (ret) {
 			pr_err("download failed!\n");
-			ret = -ENODEV;
+			ret = (ret == -EFAULT) ? -EFAULT : -ENODEV;
 		}
 	}
 	break;
@@ -1369,9 +1499,10 @@ static long memx_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 			ret = -ENOMEM;
 			break;
 		}
-		if (memx_flash_download(data, cmd, &memx_bin)) {
+		ret = memx_flash_download(data, cmd, &memx_bin);
+		if (ret) {
 			pr_err("download failed!\n");
-			ret = -ENODEV;
+			ret = (ret == -EFAULT) ? -EFAULT : -ENODEV;
 		}
 	}
 	break;
@@ -1391,9 +1522,10 @@ static long memx_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 			else
 				pr_debug("DFP From SEPERATE CONFIG\n");
 
-			if (memx_seperate_dfp_download(data, memx_bin.buf + SEP_LEN_OFS, memx_bin.dfp_cnt, memx_bin.dfp_src)) {
+			ret = memx_seperate_dfp_download(data, memx_bin.buf + SEP_LEN_OFS, memx_bin.dfp_cnt, memx_bin.dfp_src);
+			if (ret) {
 				pr_err("runtime dfp download seperately failed!\n");
-				ret = -ENODEV;
+				ret = (ret == -EFAULT) ? -EFAULT : -ENODEV;
 			}
 		}
 	}
@@ -1676,6 +1808,11 @@ static int memx_probe(struct usb_interface *intf, const struct usb_device_id *id
 			return -ENOMEM;
 		}
 
+		if (memx_dl_slots_alloc(data)) {
+			memx_dl_slots_free(data);
+			return -ENOMEM;
+		}
+
 		init_completion(&data->rx_comp);
 		init_completion(&data->fwrx_comp);
 
@@ -1799,6 +1936,9 @@ static int memx_probe(struct usb_interface *intf, const struct usb_device_id *id
 				for (i = data->chipcnt-1; i >= 0; i--)
 					memx_send_memxcmd(data, i, MXCNST_MEMXW_CMD, MXCNST_ASPMCTRL, pcie_aspm&0xF);
 			}
+
+			if (fw_log_stream_ms && memx_fw_log_stream_init(data, fw_log_stream_ms))
+				pr_err("Probing: fw log stream init failed.\n");
 		}
 
 	} else {
@@ -1812,6 +1952,7 @@ static void memx_disconnect(struct usb_interface *intf)
 	struct memx_data *data = usb_get_intfdata(intf);
 
 	if (data->fs.dbgfs_en) {
+		memx_fw_log_stream_deinit(data);
 		memx_fs_deinit(data);
 		data->fs.dbgfs_en = 0;
 	}
@@ -1885,6 +2026,7 @@ static void memx_disconnect(struct usb_interface *intf)
 		kfree(data->fw_wbuffer);
 		kfree(data->fw_rbuffer);
 		kfree(data->rbuffer);
+		memx_dl_slots_free(data);
 		wake_up_interruptible(&data->read_wq);
 	}
 
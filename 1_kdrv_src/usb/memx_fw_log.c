@@ -2,6 +2,8 @@
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
 #include <linux/version.h>
+#include <linux/debugfs.h>
+#include <linux/poll.h>
 #include "../include/memx_ioctl.h"
 #include "memx_cascade_usb.h"
 #include "memx_fs.h"
@@ -9,6 +11,10 @@
 #include "memx_cascade_debugfs.h"
 
 #define MEMX_DBGLOG_CHIP_BUFFER_SIZE(chipid) (0x1000+(chipid*0))
+/* GETLOG answer: log ring followed by wp and rp */
+#define MEMX_DBGLOG_SNAPSHOT_SIZE (MEMX_DBGLOG_CHIP_BUFFER_SIZE(0) + 8)
+/* each idle chip is polled less often, up to period * this */
+#define MEMX_FWLOG_MAX_BACKOFF 8
 
 s32 memx_fw_log_dump(struct memx_data *memx_dev, u8 chip_id)
 {
@@ -75,3 +81,209 @@ s32 memx_fw_log_dump(struct memx_data *memx_dev, u8 chip_id)
 
 	return 0;
 }
+
+/*
+ * fw log streaming
+ *
+ * The firmware only answers DBGFS_ID_GETLOG with a snapshot of its 4KB log ring,
+ * so streaming is a background poller: it keeps its own IN urb/buffer (fw_rxurb and
+ * fw_rbuffer stay free for other commands), holds cfglock for a single round trip
+ * per chip, and appends only the bytes written since the previous snapshot to a
+ * per-chip kfifo. Readers block or poll on debugfs memx%d/fwlog<chip>.
+ * The poller only trylocks cfglock: while an inference transfer holds it, the chip
+ * is skipped and retried one period later, so logging never delays memx_write.
+ * A chip that writes more than one ring's worth between polls loses the overwritten part.
+ */
+static bool memx_fw_log_stream_append(struct memx_fwlog_chip *chip, const u8 *snap)
+{
+	u32 ring_size = MEMX_DBGLOG_CHIP_BUFFER_SIZE(0);
+	u32 wp_value = *(const u32 *)(snap + ring_size);
+	u32 rp_value = *(const u32 *)(snap + ring_size + 4);
+	u32 start, total, i;
+
+	if ((wp_value >= ring_size) || (rp_value >= ring_size))
+		return false;
+
+	/* first snapshot starts from what the fw has not handed out yet */
+	start = chip->synced ? chip->last_wp : rp_value;
+	chip->synced = true;
+	chip->last_wp = wp_value;
+
+	total = (wp_value - start) & (ring_size - 1);
+	for (i = 0; i < total; i++) {
+		u8 c = snap[(start + i) & (ring_size - 1)];
+
+		/* log entries are NUL separated */
+		if (!kfifo_put(&chip->ring, c ? c : '\n')) {
+			chip->dropped += total - i;
+			pr_warn_ratelimited("fw_log_stream: ring full, %llu bytes dropped\n", chip->dropped);
+			break;
+		}
+	}
+
+	if (total)
+		wake_up_interruptible(&chip->wq);
+
+	return total > 0;
+}
+
+static void memx_fw_log_stream_work(struct work_struct *work)
+{
+	struct memx_data *memx_dev = container_of(to_delayed_work(work), struct memx_data, fwlog_work);
+	unsigned long next_poll = jiffies + msecs_to_jiffies(memx_dev->fwlog_period_ms * MEMX_FWLOG_MAX_BACKOFF);
+	unsigned long now;
+	u32 chip_id;
+	s32 ret;
+
+	for (chip_id = 0; chip_id < min_t(u32, memx_dev->chipcnt, MAX_CHIP_NUM); chip_id++) {
+		struct memx_fwlog_chip *chip = &memx_dev->fwlog_chip[chip_id];
+
+		if (time_before(jiffies, chip->next_poll)) {
+			if (time_before(chip->next_poll, next_poll))
+				next_poll = chip->next_poll;
+			continue;
+		}
+
+		ret = memx_stream_logbuffer(memx_dev, chip_id, MEMX_DBGLOG_SNAPSHOT_SIZE);
+		if (ret == -EBUSY) {
+			/* cfglock busy with inference, retry soon without counting it as idle */
+			chip->next_poll = jiffies + msecs_to_jiffies(memx_dev->fwlog_period_ms);
+		} else {
+			if ((ret == MEMX_DBGLOG_SNAPSHOT_SIZE) && memx_fw_log_stream_append(chip, memx_dev->log_rbuffer))
+				chip->interval_ms = memx_dev->fwlog_period_ms;
+			else
+				chip->interval_ms = min(chip->interval_ms * 2, memx_dev->fwlog_period_ms * MEMX_FWLOG_MAX_BACKOFF);
+			chip->next_poll = jiffies + msecs_to_jiffies(chip->interval_ms);
+		}
+
+		if (time_before(chip->next_poll, next_poll))
+			next_poll = chip->next_poll;
+	}
+
+	now = jiffies;
+	schedule_delayed_work(&memx_dev->fwlog_work, time_after(next_poll, now) ? next_poll - now : 0);
+}
+
+static ssize_t memx_fw_log_stream_read(struct file *file, char __user *user_buffer, size_t count, loff_t *ppos)
+{
+	struct memx_fwlog_chip *chip = file->private_data;
+	unsigned int copied = 0;
+	int ret;
+
+	if (mutex_lock_interruptible(&chip->readlock))
+		return -ERESTARTSYS;
+
+	while (kfifo_is_empty(&chip->ring)) {
+		mutex_unlock(&chip->readlock);
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		if (wait_event_interruptible(chip->wq, !kfifo_is_empty(&chip->ring) || READ_ONCE(chip->memx_dev->fwlog_stopped)))
+			return -ERESTARTSYS;
+		if (READ_ONCE(chip->memx_dev->fwlog_stopped))
+			return 0;
+		if (mutex_lock_interruptible(&chip->readlock))
+			return -ERESTARTSYS;
+	}
+
+	ret = kfifo_to_user(&chip->ring, user_buffer, count, &copied);
+	mutex_unlock(&chip->readlock);
+
+	return ret ? ret : copied;
+}
+
+static __poll_t memx_fw_log_stream_poll(struct file *file, poll_table *wait)
+{
+	struct memx_fwlog_chip *chip = file->private_data;
+
+	poll_wait(file, &chip->wq, wait);
+
+	return kfifo_is_empty(&chip->ring) ? 0 : (EPOLLIN | EPOLLRDNORM);
+}
+
+static const struct file_operations memx_fw_log_stream_fops = {
+	.owner   = THIS_MODULE,
+	.open    = simple_open,
+	.read    = memx_fw_log_stream_read,
+	.poll    = memx_fw_log_stream_poll,
+	.llseek  = noop_llseek,
+};
+
+s32 memx_fw_log_stream_init(struct memx_data *memx_dev, u32 period_ms)
+{
+	char name[16];
+	u32 chip_id;
+
+	if (!memx_dev || !period_ms)
+		return -EINVAL;
+
+	memx_dev->log_rxurb = usb_alloc_urb(0, GFP_KERNEL);
+	memx_dev->log_rbuffer = kzalloc(MEMX_DBGLOG_SNAPSHOT_SIZE, GFP_KERNEL);
+	if (!memx_dev->log_rxurb || !memx_dev->log_rbuffer)
+		goto fail;
+
+	for (chip_id = 0; chip_id < min_t(u32, memx_dev->chipcnt, MAX_CHIP_NUM); chip_id++) {
+		struct memx_fwlog_chip *chip = &memx_dev->fwlog_chip[chip_id];
+
+		if (kfifo_alloc(&chip->ring, MEMX_FWLOG_RING_SIZE, GFP_KERNEL))
+			goto fail;
+		mutex_init(&chip->readlock);
+		chip->memx_dev = memx_dev;
+		init_waitqueue_head(&chip->wq);
+		chip->synced = false;
+		chip->dropped = 0;
+		chip->interval_ms = period_ms;
+		chip->next_poll = jiffies;
+	}
+
+	init_completion(&memx_dev->logrx_comp);
+	memx_dev->fwlog_stopped = false;
+	memx_dev->fwlog_period_ms = period_ms;
+
+	snprintf(name, sizeof(name), DEVICE_NODE_NAME, memx_dev->minor_index);
+	memx_dev->fwlog_dir = debugfs_create_dir(name, NULL);
+	for (chip_id = 0; chip_id < min_t(u32, memx_dev->chipcnt, MAX_CHIP_NUM); chip_id++) {
+		snprintf(name, sizeof(name), "fwlog%u", chip_id);
+		debugfs_create_file(name, 0444, memx_dev->fwlog_dir, &memx_dev->fwlog_chip[chip_id], &memx_fw_log_stream_fops);
+	}
+
+	INIT_DELAYED_WORK(&memx_dev->fwlog_work, memx_fw_log_stream_work);
+	schedule_delayed_work(&memx_dev->fwlog_work, 0);
+
+	pr_info("fw_log_stream: %u chips every %ums\n", memx_dev->chipcnt, period_ms);
+	return 0;
+
+fail:
+	for (chip_id = 0; chip_id < MAX_CHIP_NUM; chip_id++)
+		kfifo_free(&memx_dev->fwlog_chip[chip_id].ring);
+	usb_free_urb(memx_dev->log_rxurb);
+	memx_dev->log_rxurb = NULL;
+	kfree(memx_dev->log_rbuffer);
+	memx_dev->log_rbuffer = NULL;
+	return -ENOMEM;
+}
+
+void memx_fw_log_stream_deinit(struct memx_data *memx_dev)
+{
+	u32 chip_id;
+
+	if (!memx_dev || !memx_dev->log_rxurb)
+		return;
+
+	cancel_delayed_work_sync(&memx_dev->fwlog_work);
+	usb_kill_urb(memx_dev->log_rxurb);
+
+	/* release blocked readers before debugfs waits for them */
+	WRITE_ONCE(memx_dev->fwlog_stopped, true);
+	for (chip_id = 0; chip_id < min_t(u32, memx_dev->chipcnt, MAX_CHIP_NUM); chip_id++)
+		wake_up_interruptible(&memx_dev->fwlog_chip[chip_id].wq);
+
+	debugfs_remove_recursive(memx_dev->fwlog_dir);
+	memx_dev->fwlog_dir = NULL;
+
+	for (chip_id = 0; chip_id < MAX_CHIP_NUM; chip_id++)
+		kfifo_free(&memx_dev->fwlog_chip[chip_id].ring);
+	usb_free_urb(memx_dev->log_rxurb);
+	memx_dev->log_rxurb = NULL;
+	kfree(memx_dev->log_rbuffer);
+	memx_dev->log_rbuffer = NULL;
+}
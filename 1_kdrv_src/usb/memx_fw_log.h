@@ -4,5 +4,7 @@
 
 struct memx_data;
 s32 memx_fw_log_dump(struct memx_data *memx_dev, u8 chip_id);
+s32 memx_fw_log_stream_init(struct memx_data *memx_dev, u32 period_ms);
+void memx_fw_log_stream_deinit(struct memx_data *memx_dev);
 
 #endif
@@ -0,0 +1,104 @@
+#!/usr/bin/env bash
+# Run usb_bulk_test.ko against dummy_hcd + g_zero so the USB bulk data path can be
+# regression-tested without a MemryX device.
+#   tx/rx   -> g_zero source/sink function
+#   pattern -> g_zero loopback function (loopdefault=1)
+# Fails if any case moves no data or reports submit/status/timeout/mismatch errors.
+#
+# usage: sudo ./usb_bench_ci.sh [xfer_size] [qdepth] [duration_ms]
+set -Eeuo pipefail
+IFS=$'\n\t'
+
+ts() { date +"%Y-%m-%d %H:%M:%S"; }
+log() { printf "[%s] [%s] %s\n" "$(ts)" "$1" "$2"; }
+info(){ log "INFO" "$*"; }
+err() { log "ERROR" "$*" >&2; }
+
+on_err() {
+  local rc=$?
+  err "FAILED: usb bench ci (exit=${rc})"
+  exit "$rc"
+}
+trap on_err ERR
+
+XFER_SIZE="${1:-65536}"
+QDEPTH="${2:-4}"
+DURATION_MS="${3:-3000}"
+
+MODULE="${MODULE:-./usb_bulk_test.ko}"
+GZERO_ID="${GZERO_ID:-1a0a badd}"
+DRIVER_DIR="/sys/bus/usb/drivers/memx_usb_bench"
+DBGFS_DIR="/sys/kernel/debug/memx_usb_bench"
+
+[[ -f "$MODULE" ]] || { err "Missing module: $MODULE (run 'make bench' first)"; exit 2; }
+mountpoint -q /sys/kernel/debug || mount -t debugfs none /sys/kernel/debug
+
+cleanup() {
+  rmmod usb_bulk_test 2>/dev/null || true
+  modprobe -r g_zero 2>/dev/null || true
+  modprobe -r dummy_hcd 2>/dev/null || true
+}
+trap cleanup EXIT
+
+load_gadget() {
+  local loopdefault="$1"
+
+  modprobe -r g_zero 2>/dev/null || true
+  info "RUN: modprobe g_zero loopdefault=${loopdefault} buflen=${XFER_SIZE}"
+  modprobe g_zero loopdefault="$loopdefault" buflen="$XFER_SIZE"
+
+  for _ in $(seq 1 50); do
+    if compgen -G "${DBGFS_DIR}/*/control" >/dev/null; then
+      return 0
+    fi
+    sleep 0.1
+  done
+  err "g_zero device did not bind to memx_usb_bench"
+  return 1
+}
+
+run_case() {
+  local name="$1" mode="$2" loopdefault="$3"
+  local dir stats
+
+  info "STEP: ${name} (xfer_size=${XFER_SIZE} qdepth=${QDEPTH} duration_ms=${DURATION_MS})"
+  load_gadget "$loopdefault"
+  dir="$(compgen -G "${DBGFS_DIR}/*" | head -n1)"
+
+  echo "$mode" > "${dir}/mode"
+  echo "$XFER_SIZE" > "${dir}/xfer_size"
+  echo "$QDEPTH" > "${dir}/qdepth"
+  echo "$DURATION_MS" > "${dir}/duration_ms"
+  echo start > "${dir}/control"
+
+  sleep 0.2
+  while [[ "$(cat "${dir}/control")" == "running" ]]; do
+    sleep 0.2
+  done
+
+  stats="$(cat "${dir}/stats")"
+  printf "%s\n" "$stats"
+
+  if grep -q "^transfers: 0$" <<<"$stats"; then
+    err "${name}: no transfers completed"
+    return 1
+  fi
+  if ! grep -q "^errors: submit 0 status 0 timeout 0 mismatch 0$" <<<"$stats"; then
+    err "${name}: errors reported"
+    return 1
+  fi
+  info "PASS: ${name}"
+}
+
+info "STEP: load dummy_hcd and benchmark module"
+modprobe dummy_hcd
+modprobe -r usbtest 2>/dev/null || true
+rmmod usb_bulk_test 2>/dev/null || true
+insmod "$MODULE" ep_in=0 ep_out=0
+echo "$GZERO_ID" > "${DRIVER_DIR}/new_id"
+
+run_case "tx" 0 0
+run_case "rx" 1 0
+run_case "pattern" 2 1
+
+info "PASS: usb bench ci"
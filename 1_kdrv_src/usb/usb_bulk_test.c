@@ -1,1141 +1,684 @@
 // SPDX-License-Identifier: GPL-2.0+
+/*
+ * USB bulk throughput/latency benchmark for MemryX Cascade devices.
+ *
+ * Keeps qdepth URBs of xfer_size bytes in flight for duration_ms and reports
+ * throughput, a log2 latency histogram and error counts through debugfs:
+ *
+ *   /sys/kernel/debug/memx_usb_bench/<usb intf>/
+ *       mode         0-tx(OUT only) 1-rx(IN only) 2-pattern(OUT then IN, verified)
+ *       xfer_size    bytes per URB
+ *       qdepth       URBs (tx/rx) or OUT+IN pairs (pattern) in flight
+ *       duration_ms  run length
+ *       control      write "start" / "stop", read current state
+ *       stats        results of the current or last run
+ *
+ * Pattern mode expects the device to loop OUT data back on IN (firmware bulk
+ * loopback, or g_zero loopdefault=1 on dummy_hcd, see usb_bench_ci.sh).
+ * Bind to a non-MemryX device with /sys/bus/usb/drivers/memx_usb_bench/new_id.
+ */
 #include <linux/module.h>	// included for all kernel modules
 #include <linux/kernel.h>	// included for KERN_INFO
 #include <linux/init.h>	  // included for __init and __exit macros
 #include <linux/slab.h>
 #include <linux/usb.h>
 #include <linux/completion.h>
-#include <linux/kthread.h>
 #include <linux/mutex.h>
-#include <linux/firmware.h>
+#include <linux/spinlock.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
 #include <linux/uaccess.h>
-#include "../include/memx_ioctl.h"
-#define VERSION "1.10"
-
-#ifdef CONFIG_USB_DYNAMIC_MINORS
-#define USB_MEMXCHIP3_MINOR_BASE 0
-#else
-#define USB_MEMXCHIP3_MINOR_BASE 192
-#endif
+#define VERSION "2.00"
+
+#define DEVICE_VENDOR_ID	0x0559
+
+#define ROLE_G0_SINGLE_DEV  0x4006
+#define ROLE_G0_MULTI_FIRST 0x4007
+#define ROLE_G0_MULTI_LAST  0x4008
+#define ROLE_G1_SINGLE_DEV  0x4016
+#define ROLE_G1_MULTI_FIRST 0x4017
+#define ROLE_G1_MULTI_LAST  0x4018
+#define ROLE_G2_SINGLE_DEV  0x4026
+#define ROLE_G2_MULTI_FIRST 0x4027
+#define ROLE_G2_MULTI_LAST  0x4028
+#define ROLE_G3_SINGLE_DEV  0x4036
+#define ROLE_G3_MULTI_FIRST 0x4037
+#define ROLE_G3_MULTI_LAST  0x4038
 
 #define MEMX_IN_EP			0x81
-#define MEMX_OUT_EP		   0x01
-#define MEMX_FW_OUT_EP		0x02
-#define MAX_OPS_SIZE		  (64*1024)
-// #define MAX_MPUIN_SIZE  (19200)
-// #define MAX_MPUOUT_SIZE (57600)
-#define FWCFG_ID_CLR		  0x952700
-#define FWCFG_ID_FW		   0x952701
-#define FWCFG_ID_DFP		  0x952702
-#define FWCFG_ID_MPU_INSIZE   0x952703
-#define FWCFG_ID_MPU_OUTSIZE  0x952704
-#define FWCFG_ID_DFP_CHIPID   0x952705
-#define FWCFG_ID_DFP_CFGSIZE  0x952706
-#define FWCFG_ID_DFP_WMEMADR  0x952707
-#define FWCFG_ID_DFP_WTMEMSZ  0x952708
-#define FWCFG_ID_DFP_RESETMPU 0x952709
-#define FWCFG_ID_DFP_RECFGMPU 0x95270A
-#define DFP_FLASH_OFFSET	  0x20000
-#define MPU_CHIP_ID_BASE	  1
-static unsigned long MAX_MPUIN_SIZE = 18000;
-static unsigned long MAX_MPUOUT_SIZE = 54000;
-
-static unsigned int dfp_dwn;
-module_param(dfp_dwn, uint, 0);
-MODULE_PARM_DESC(dfp_dwn, "Process DFP Download if dfp_dwn = 1, default is 0");
-
-static unsigned int fw_dwn;
-module_param(fw_dwn, uint, 0);
-MODULE_PARM_DESC(fw_dwn, "Process FW Download if fw_dwn = 1, default is 0");
-
-static unsigned int loop;
-module_param(loop, uint, 0);
-MODULE_PARM_DESC(loop, "Process bulk loopback if loop = 1, default is 0");
-
-static unsigned int emu;
-module_param(emu, uint, 0);
-MODULE_PARM_DESC(emu, "Process emulation flow if emu = 1, default is 0");
-
-static unsigned int dfp_dir;
-module_param(dfp_dir, uint, 0);
-MODULE_PARM_DESC(dfp_dir, "Process DFP Direct Write if dfp_dir = 1, default is 0");
-
-static unsigned int frame_size = 252;
-module_param(frame_size, uint, 0);
-MODULE_PARM_DESC(fw_dwn, "frame size, default is 252");
-
-DECLARE_COMPLETION(fw_comp);
-DECLARE_COMPLETION(tx_comp);
-DECLARE_COMPLETION(rx_comp);
-
-static struct usb_driver memx_ai_driver;
-
-#define ROLE_SINGLE_DEV  0x4006
-#define ROLE_MULTI_FIRST 0x4007
-#define ROLE_MULTI_LAST  0x4008
+#define MEMX_OUT_EP			0x01
+#define MAX_OPS_SIZE		(64*1024)
+
+#define BENCH_DBGFS_ROOT	"memx_usb_bench"
+#define BENCH_MAX_QDEPTH	32
+#define BENCH_MAX_XFER_SIZE	(1024*1024)
+#define BENCH_HIST_CNT		24	/* bucket n holds [2^n, 2^(n+1)) us, the last one is open ended */
+#define BENCH_GRACE_MS		5000
+
+enum bench_mode {
+	BENCH_MODE_TX = 0,
+	BENCH_MODE_RX,
+	BENCH_MODE_PATTERN,
+	BENCH_MODE_MAX
+};
+
+static const char * const bench_mode_name[BENCH_MODE_MAX] = { "tx", "rx", "pattern" };
+
+static unsigned int mode = BENCH_MODE_TX;
+module_param(mode, uint, 0);
+MODULE_PARM_DESC(mode, "Default benchmark mode:: 0-tx(default) 1-rx 2-pattern loopback");
+
+static unsigned int xfer_size = MAX_OPS_SIZE;
+module_param(xfer_size, uint, 0);
+MODULE_PARM_DESC(xfer_size, "Default bytes per transfer, default is 65536, max is 1048576");
+
+static unsigned int qdepth = 4;
+module_param(qdepth, uint, 0);
+MODULE_PARM_DESC(qdepth, "Default transfers in flight, default is 4, max is 32");
+
+static unsigned int duration_ms = 10000;
+module_param(duration_ms, uint, 0);
+MODULE_PARM_DESC(duration_ms, "Default run length in ms, default is 10000");
+
+static unsigned int ep_in = MEMX_IN_EP;
+module_param(ep_in, uint, 0);
+MODULE_PARM_DESC(ep_in, "Bulk IN endpoint address, default is 0x81, 0 picks the first bulk IN endpoint");
+
+static unsigned int ep_out = MEMX_OUT_EP;
+module_param(ep_out, uint, 0);
+MODULE_PARM_DESC(ep_out, "Bulk OUT endpoint address, default is 0x01, 0 picks the first bulk OUT endpoint");
+
+static struct usb_driver memx_bench_driver;
+static struct dentry *bench_dbgfs_root;
 
 static const struct usb_device_id memx_table[] = {
 	/* MemryX CHIP-3 */
-	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_SINGLE_DEV) }, /*x1 case*/
-	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_MULTI_FIRST) }, /*xN first*/
-	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_MULTI_LAST) }, /*xN last*/
+	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_G0_SINGLE_DEV) }, /*x1 case*/
+	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_G0_MULTI_FIRST) }, /*xN first*/
+	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_G0_MULTI_LAST) }, /*xN last*/
+	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_G1_SINGLE_DEV) }, /*x1 case*/
+	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_G1_MULTI_FIRST) }, /*xN first*/
+	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_G1_MULTI_LAST) }, /*xN last*/
+	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_G2_SINGLE_DEV) }, /*x1 case*/
+	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_G2_MULTI_FIRST) }, /*xN first*/
+	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_G2_MULTI_LAST) }, /*xN last*/
+	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_G3_SINGLE_DEV) }, /*x1 case*/
+	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_G3_MULTI_FIRST) }, /*xN first*/
+	{ USB_DEVICE(DEVICE_VENDOR_ID, ROLE_G3_MULTI_LAST) }, /*xN last*/
 
 	{ }	/* Terminating entry */
 };
 MODULE_DEVICE_TABLE(usb, memx_table);
 
-struct DFP_MPU_WT_MEM {
-	uint32_t mpu_cg_wt_mem_data_adr;
-	uint32_t mpu_cg_wt_mem_data_reg;
-	uint32_t mpu_cg_wt_mem_data_sze;
-	uint32_t mpu_cg_wt_mem_data_crc;
-	uint32_t mpu_cg_wt_memflg_data_adr;
-	uint32_t mpu_cg_wt_memflg_data_reg;
-	uint32_t mpu_cg_wt_memflg_data_sze;
-	uint32_t mpu_cg_wt_memflg_data_crc;
-} __packed;
-
-#define MAX_WT_CNT   6
-#define DFP_CFG_SZ   0xD0
-#define DFP_OFS(N)   (0x10 + N*0xD0)
-#define MAX_CFG_SZ   MAX_OPS_SIZE
-
-struct DFP_DATA {
-	uint32_t mpu_rg_cfg_adr;
-	uint32_t mpu_rg_cfg_sze;
-	uint32_t mpu_cg_wt_mem_count;
-	uint32_t reserved0;
-	struct DFP_MPU_WT_MEM mpu_cg_wt_mem_data[MAX_WT_CNT];
-} __packed;
-
-struct memx_data {
+struct bench_cfg {
+	u32 mode;
+	u32 xfer_size;
+	u32 qdepth;
+	u32 duration_ms;
+};
+
+struct bench_stats {
+	u64     xfers;
+	u64     tx_bytes;
+	u64     rx_bytes;
+	u64     lat_sum_us;
+	u64     lat_min_us;
+	u64     lat_max_us;
+	u64     hist[BENCH_HIST_CNT];
+	u32     submit_err;
+	u32     status_err;
+	u32     timeout_err;
+	u32     mismatch_err;
+	ktime_t start_time;
+	ktime_t end_time;
+};
+
+struct bench_data;
+
+struct bench_slot {
+	struct bench_data *data;
+	struct urb        *txurb;
+	struct urb        *rxurb;
+	unsigned char     *tbuffer;
+	unsigned char     *rbuffer;
+	u32                seq;
+	ktime_t            submit_time;
+};
+
+struct bench_data {
 	struct usb_interface *interface;
-	struct usb_device	*udev;
-	unsigned long		state;
-	unsigned long		tx_size;
-	unsigned long		rx_size;
-	struct urb		   *txurb;
-	struct urb		   *rxurb;
-	unsigned char		*tbuffer;
-	unsigned char		*rbuffer;
-	struct work_struct   fw_work;
-	struct work_struct   tx_work;
-	struct work_struct   rx_work;
-	uint32_t			 flow_size[MEMX_TOTAL_FLOW_COUNT];
-	uint32_t			 buffer_size[MEMX_TOTAL_FLOW_COUNT];
-	struct mutex		 cfglock;
+	struct usb_device    *udev;
+	u8                    ep_in;
+	u8                    ep_out;
+	struct bench_cfg      cfg;	/* edited through debugfs */
+	struct bench_cfg      run;	/* snapshot taken at start */
+	struct bench_slot     slot[BENCH_MAX_QDEPTH];
+	struct usb_anchor     anchor;
+	spinlock_t            lock;
+	struct bench_stats    stats;
+	bool                  running;
+	atomic_t              inflight;
+	ktime_t               deadline;
+	struct completion     done;
+	struct work_struct    run_work;
+	struct mutex          ctrl_lock;
+	struct dentry        *dbg_dir;
 };
 
-static void memx_complete(struct urb *urb)
+static void bench_txcomplete(struct urb *urb);
+static void bench_rxcomplete(struct urb *urb);
+
+static void bench_fill_pattern(struct bench_slot *slot, u32 size)
 {
-	// struct memx_data *data = urb->context;
-	// struct usb_device *udev = urb->dev;
-	complete(&fw_comp);
+	u32 *buf32 = (u32 *)slot->tbuffer;
+	u32 i;
+
+	for (i = 0; i < size / 4; i++)
+		buf32[i] = slot->seq * 0x9E3779B1 + i;
+	for (i = size & ~3U; i < size; i++)
+		slot->tbuffer[i] = (u8)(slot->seq + i);
 }
 
-static void memx_txcomplete(struct urb *urb)
+static bool bench_check_pattern(struct bench_slot *slot, u32 size)
 {
-	// struct memx_data *data = urb->context;
-	// struct usb_device *udev = urb->dev;
-	complete(&tx_comp);
+	return (slot->rxurb->actual_length == size) && !memcmp(slot->tbuffer, slot->rbuffer, size);
 }
 
-static void memx_rxcomplete(struct urb *urb)
+static void bench_record(struct bench_data *data, u64 tx_bytes, u64 rx_bytes, ktime_t submit_time)
 {
-	// struct memx_data *data = urb->context;
-	// struct usb_device *udev = urb->dev;
-	complete(&rx_comp);
+	u64 lat_us = ktime_us_delta(ktime_get(), submit_time);
+	u32 bucket = (lat_us > 0) ? min_t(u32, ilog2(lat_us), BENCH_HIST_CNT - 1) : 0;
+	unsigned long flags;
+
+	spin_lock_irqsave(&data->lock, flags);
+	data->stats.xfers++;
+	data->stats.tx_bytes += tx_bytes;
+	data->stats.rx_bytes += rx_bytes;
+	data->stats.lat_sum_us += lat_us;
+	data->stats.lat_min_us = min(data->stats.lat_min_us, lat_us);
+	data->stats.lat_max_us = max(data->stats.lat_max_us, lat_us);
+	data->stats.hist[bucket]++;
+	spin_unlock_irqrestore(&data->lock, flags);
 }
 
-
-static void tx_thread(struct work_struct *work)
+static void bench_count_error(struct bench_data *data, u32 *counter)
 {
-	struct memx_data *data =
-		container_of(work, struct memx_data, tx_work);
-	unsigned long size = data->tx_size;
-	int i = 0;
-
-	if (emu) {
-		size = frame_size*2;
-		for (i = 0; i < frame_size; i++)
-			data->tbuffer[i] = i & 0xFF;
-
-		for (i = frame_size; i < frame_size*2; i++)
-			data->tbuffer[i] = 0x22;
-	}
-
-	/* set up our urb */
-	usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_OUT_EP),
-			data->tbuffer, size, memx_txcomplete, data);
-
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit TX URB");
-		return;
-	}
+	unsigned long flags;
 
-	if (!wait_for_completion_timeout(&tx_comp, msecs_to_jiffies(30000))) {
-		pr_err("wait tx timeout\n");
-		return;
-	}
-
-	if (emu)
-		schedule_work(&data->tx_work);
+	spin_lock_irqsave(&data->lock, flags);
+	(*counter)++;
+	spin_unlock_irqrestore(&data->lock, flags);
 }
 
-static void rx_thread(struct work_struct *work)
+static bool bench_should_continue(struct bench_data *data)
 {
-	struct memx_data *data =
-		container_of(work, struct memx_data, rx_work);
-	int i = 0;
-
-	if (emu) {
-		for (i = 0; i < MAX_OPS_SIZE; i++)
-			data->rbuffer[i] = 0x0;
-	}
-
-	/* set up our urb */
-	usb_fill_bulk_urb(data->rxurb, data->udev, usb_rcvbulkpipe(data->udev, MEMX_IN_EP),
-			data->rbuffer, MAX_OPS_SIZE, memx_rxcomplete, data);
-
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->rxurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit RX URB");
-		return;
-	}
-
-	if (!wait_for_completion_timeout(&rx_comp, msecs_to_jiffies(30000))) {
-		pr_err("wait rx timeout\n");
-		return;
-	}
-
-	if (emu)
-		schedule_work(&data->rx_work);
+	return READ_ONCE(data->running) && ktime_before(ktime_get(), data->deadline);
 }
 
-static void clear_fw_id(struct memx_data *data)
+static void bench_slot_finish(struct bench_slot *slot)
 {
-	uint32_t cfg_header[2] = {0};
-
-	cfg_header[0] = FWCFG_ID_CLR;
-	cfg_header[1] = 0;
-
-	memcpy(data->tbuffer, cfg_header, 8);
-
-	usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-		data->tbuffer, 8, memx_complete, data);
-
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit cfg clr");
-		return;
-	}
-
-	if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-		pr_err("wait cfg clr timeout\n");
-		return;
-	}
+	if (atomic_dec_and_test(&slot->data->inflight))
+		complete(&slot->data->done);
 }
 
-static void reset_mpu(struct memx_data *data, uint32_t id)
+static int bench_submit(struct bench_data *data, struct urb *urb, gfp_t mem_flags)
 {
-	uint32_t cfg_header[2] = {0};
-	uint32_t chip_id = id;
-
-	cfg_header[0] = FWCFG_ID_DFP_RESETMPU;
-	cfg_header[1] = 4;
-
-	memcpy(data->tbuffer, cfg_header, 8);
-
-	usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-		data->tbuffer, 8, memx_complete, data);
+	int ret;
 
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit cfg clr");
-		return;
-	}
-
-	if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-		pr_err("wait cfg clr timeout\n");
-		return;
-	}
-
-	usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-		&chip_id, 4, memx_complete, data);
-
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit cfg dfp");
-		return;
+	usb_anchor_urb(urb, &data->anchor);
+	ret = usb_submit_urb(urb, mem_flags);
+	if (ret < 0) {
+		usb_unanchor_urb(urb);
+		/* -EPERM means the urb is being killed by stop, not a real failure */
+		if (ret != -EPERM)
+			bench_count_error(data, &data->stats.submit_err);
 	}
 
-	if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-		pr_err("wait cfg dfp timeout\n");
-		return;
-	}
-
-	clear_fw_id(data);
+	return ret;
 }
 
-static void recfg_mpu(struct memx_data *data, uint32_t id)
+/* start the next transfer of a slot, returns false when the slot is done */
+static bool bench_slot_next(struct bench_slot *slot, gfp_t mem_flags)
 {
-	uint32_t cfg_header[2] = {0};
-	uint32_t chip_id = id;
+	struct bench_data *data = slot->data;
+	u32 size = data->run.xfer_size;
 
-	cfg_header[0] = FWCFG_ID_DFP_RECFGMPU;
-	cfg_header[1] = 4;
+	slot->submit_time = ktime_get();
 
-	memcpy(data->tbuffer, cfg_header, 8);
-
-	usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-		data->tbuffer, 8, memx_complete, data);
-
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit cfg clr");
-		return;
+	if (data->run.mode == BENCH_MODE_RX) {
+		usb_fill_bulk_urb(slot->rxurb, data->udev, usb_rcvbulkpipe(data->udev, data->ep_in),
+			slot->rbuffer, size, bench_rxcomplete, slot);
+		return bench_submit(data, slot->rxurb, mem_flags) == 0;
 	}
 
-	if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-		pr_err("wait cfg clr timeout\n");
-		return;
+	if (data->run.mode == BENCH_MODE_PATTERN) {
+		slot->seq += BENCH_MAX_QDEPTH;
+		bench_fill_pattern(slot, size);
 	}
 
-	usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-		&chip_id, 4, memx_complete, data);
-
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit cfg dfp");
-		return;
-	}
+	usb_fill_bulk_urb(slot->txurb, data->udev, usb_sndbulkpipe(data->udev, data->ep_out),
+		slot->tbuffer, size, bench_txcomplete, slot);
+	return bench_submit(data, slot->txurb, mem_flags) == 0;
+}
 
-	if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-		pr_err("wait cfg dfp timeout\n");
-		return;
+static bool bench_urb_ok(struct bench_data *data, struct urb *urb)
+{
+	switch (urb->status) {
+	case 0:
+		return true;
+	case -ENOENT:
+	case -ECONNRESET:
+	case -ESHUTDOWN:
+		/* killed by stop/timeout or disconnect */
+		return false;
+	default:
+		bench_count_error(data, &data->stats.status_err);
+		return false;
 	}
-
-	clear_fw_id(data);
 }
 
-static void set_dfp_chip_id(struct memx_data *data, uint32_t id)
+static void bench_txcomplete(struct urb *urb)
 {
-	uint32_t cfg_header[2] = {0};
-	uint32_t chip_id = id;
-
-	cfg_header[0] = FWCFG_ID_DFP_CHIPID;
-	cfg_header[1] = 4;
+	struct bench_slot *slot = urb->context;
+	struct bench_data *data = slot->data;
 
-	memcpy(data->tbuffer, cfg_header, 8);
-
-	usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-		data->tbuffer, 8, memx_complete, data);
-
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit cfg clr");
-		return;
-	}
-
-	if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-		pr_err("wait cfg clr timeout\n");
+	if (!bench_urb_ok(data, urb)) {
+		bench_slot_finish(slot);
 		return;
 	}
 
-	usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-		&chip_id, 4, memx_complete, data);
-
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit cfg dfp");
+	if (data->run.mode == BENCH_MODE_PATTERN) {
+		/* loopback: read the same pattern back, latency is counted on the IN side */
+		usb_fill_bulk_urb(slot->rxurb, data->udev, usb_rcvbulkpipe(data->udev, data->ep_in),
+			slot->rbuffer, data->run.xfer_size, bench_rxcomplete, slot);
+		if (bench_submit(data, slot->rxurb, GFP_ATOMIC) < 0)
+			bench_slot_finish(slot);
 		return;
 	}
 
-	if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-		pr_err("wait cfg dfp timeout\n");
-		return;
-	}
+	bench_record(data, urb->actual_length, 0, slot->submit_time);
 
-	clear_fw_id(data);
+	if (!bench_should_continue(data) || !bench_slot_next(slot, GFP_ATOMIC))
+		bench_slot_finish(slot);
 }
 
-static void set_wtmem_addr(struct memx_data *data, uint32_t id, uint32_t addr)
+static void bench_rxcomplete(struct urb *urb)
 {
-	uint32_t cfg_header[2] = {0};
-	uint32_t wtmem_addr = addr;
+	struct bench_slot *slot = urb->context;
+	struct bench_data *data = slot->data;
 
-	cfg_header[0] = id;
-	cfg_header[1] = 4;
-
-	memcpy(data->tbuffer, cfg_header, 8);
-
-	usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-		data->tbuffer, 8, memx_complete, data);
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit cfg clr");
-		return;
-	}
-
-	if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-		pr_err("wait cfg clr timeout\n");
-		return;
-	}
-
-	usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-		&wtmem_addr, 4, memx_complete, data);
-
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit cfg clr");
+	if (!bench_urb_ok(data, urb)) {
+		bench_slot_finish(slot);
 		return;
 	}
 
-	if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-		pr_err("wait cfg clr timeout\n");
-		return;
+	if (data->run.mode == BENCH_MODE_PATTERN) {
+		if (!bench_check_pattern(slot, data->run.xfer_size))
+			bench_count_error(data, &data->stats.mismatch_err);
+		bench_record(data, slot->txurb->actual_length, urb->actual_length, slot->submit_time);
+	} else {
+		bench_record(data, 0, urb->actual_length, slot->submit_time);
 	}
 
-	clear_fw_id(data);
+	if (!bench_should_continue(data) || !bench_slot_next(slot, GFP_ATOMIC))
+		bench_slot_finish(slot);
 }
 
-static void set_wtmem_size(struct memx_data *data, uint32_t size)
+static void bench_free_buffers(struct bench_data *data)
 {
-	uint32_t cfg_header[2] = {0};
-
-	cfg_header[0] = FWCFG_ID_DFP_WTMEMSZ;
-	cfg_header[1] = size;
-
-	memcpy(data->tbuffer, cfg_header, 8);
-
-	usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-		data->tbuffer, 8, memx_complete, data);
-
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit cfg clr");
-		return;
-	}
+	int i;
 
-	if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-		pr_err("wait cfg clr timeout\n");
-		return;
+	for (i = 0; i < BENCH_MAX_QDEPTH; i++) {
+		kfree(data->slot[i].tbuffer);
+		data->slot[i].tbuffer = NULL;
+		kfree(data->slot[i].rbuffer);
+		data->slot[i].rbuffer = NULL;
 	}
 }
 
-static void fw_thread(struct work_struct *work)
+static int bench_alloc_buffers(struct bench_data *data)
 {
-	struct memx_data *data =
-		container_of(work, struct memx_data, fw_work);
-	int i = 0;
-
-	if (dfp_dwn || fw_dwn) {
-		const struct firmware *firmware;
-		int fw_total_size = 0;
-		uint32_t cfg_header[2] = {0};
-
-		if (fw_dwn) {
-			if (request_firmware(&firmware, "cascade.bin", &data->udev->dev) < 0) {
-				pr_err("cascade bin request failed");
-				return;
-			}
-		} else {
-			if (request_firmware(&firmware, "cascade.dfp", &data->udev->dev) < 0) {
-				pr_err("cascade dfp request failed");
-				return;
-			}
-		}
-
-		if (fw_dwn)
-			cfg_header[0] = FWCFG_ID_FW;
-		else
-			cfg_header[0] = FWCFG_ID_DFP;
-		cfg_header[1] = firmware->size;
-
-		memcpy(data->tbuffer, cfg_header, 8);
-
-		usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-			data->tbuffer, 8, memx_complete, data);
-
-		/* send the data out the bulk port */
-		if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-			pr_err("Can't submit cfg dfp");
-			return;
-		}
-
-		if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-			pr_err("wait cfg dfp timeout\n");
-			return;
-		}
-
-		memset(data->tbuffer, 0x0, MAX_OPS_SIZE);
-
-		pr_err("data %p size %zu", firmware->data, firmware->size);
-
-		fw_total_size = firmware->size;
-
-		while (fw_total_size > 0) {
-			/* set up our urb */
-			if (fw_total_size > MAX_OPS_SIZE) {
-				memcpy(data->tbuffer, firmware->data + i*MAX_OPS_SIZE, MAX_OPS_SIZE);
-				usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-					data->tbuffer, MAX_OPS_SIZE, memx_complete, data);
-			} else {
-				memcpy(data->tbuffer, firmware->data + i*MAX_OPS_SIZE, fw_total_size);
-				usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-					data->tbuffer, fw_total_size, memx_complete, data);
-			}
-
-			/* send the data out the bulk port */
-			if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-				pr_err("Can't submit TX URB");
-				break;
-			}
-
-			if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-				pr_err("wait tx timeout\n");
-				break;
-			}
-
-			fw_total_size -= MAX_OPS_SIZE;
-			i++;
-			memset(data->tbuffer, 0x0, MAX_OPS_SIZE);
-		}
-
-		clear_fw_id(data);
-
-		release_firmware(firmware);
-	} else if (loop) {
-		int size = 1;
-		int ret = 0;
-
-		for (i = 0; i < MAX_OPS_SIZE; i++)
-			data->tbuffer[i] = i & 0xFF;
-
-		while (1) {
-			pr_err("test size %d\n", size);
-			/* set up our urb */
-			usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_OUT_EP),
-					data->tbuffer, size, memx_complete, data);
-
-			/* send the data out the bulk port */
-			if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-				pr_err("Can't submit TX URB");
-				break;
-			}
-
-			if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-				pr_err("wait tx timeout\n");
-				break;
-			}
-
-			for (i = 0; i < MAX_OPS_SIZE; i++)
-				data->rbuffer[i] = 0x0;
-
-			/* set up our urb */
-			usb_fill_bulk_urb(data->rxurb, data->udev, usb_rcvbulkpipe(data->udev, MEMX_IN_EP),
-					data->rbuffer, size, memx_complete, data);
-
-			/* send the data out the bulk port */
-			if (usb_submit_urb(data->rxurb, GFP_KERNEL) < 0) {
-				pr_err("Can't submit RX URB");
-				break;
-			}
-
-			if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-				pr_err("wait rx timeout\n");
-				break;
-			}
-
-			ret = memcmp(data->tbuffer, data->rbuffer, size);
-			if (ret) {
-				pr_err("test size %d Fail\n", size);
-				break;
-
-			} else
-				pr_err("test size %d PASS\n", size);
+	int i;
 
-			if (size == 64*1024)
-				break;
+	for (i = 0; i < data->run.qdepth; i++) {
+		struct bench_slot *slot = &data->slot[i];
 
-			else
-				size++;
+		slot->seq = i;
+		if (data->run.mode != BENCH_MODE_RX) {
+			slot->tbuffer = kzalloc(data->run.xfer_size, GFP_KERNEL);
+			if (!slot->tbuffer)
+				return -ENOMEM;
+			if (data->run.mode == BENCH_MODE_TX)
+				bench_fill_pattern(slot, data->run.xfer_size);
 		}
-	} else if (dfp_dir) {
-		const struct firmware *firmware;
-		const uint8_t *buffer;
-		uint32_t cfg_header[2] = {0};
-		struct DFP_DATA dfp_data[1] = {0};
-		uint32_t dfp_count = 0;
-		int i = 0, j = 0;
-
-		if (request_firmware(&firmware, "coco.dfp", &data->udev->dev) < 0) {
-			pr_err("coco dfp request failed");
-			return;
-		}
-
-		buffer = firmware->data;
-		dfp_count = *(uint32_t *) buffer;
-
-		/*program each dfp data*/
-		for (i = 0; i < dfp_count; i++) {
-			uint8_t *dfp_base_buf = NULL;
-			uint32_t dfp_cfg_addr = 0;
-			uint32_t dfp_wtmem_addr = 0;
-			uint32_t reg_write_addr = 0;
-			uint32_t cfg_size, wtmem_count, wtmem_sze, wtmemflg_sze;
-
-			reset_mpu(data, i + MPU_CHIP_ID_BASE);
-
-			/*read config value*/
-			dfp_base_buf = (void *)(buffer + DFP_OFS(i));
-
-			memcpy((void *)dfp_data, (const void *)dfp_base_buf, DFP_CFG_SZ);
-
-			set_dfp_chip_id(data, i + MPU_CHIP_ID_BASE);
-
-			/*program rg_cfg*/
-			cfg_size = dfp_data->mpu_rg_cfg_sze;
-
-			dfp_cfg_addr = dfp_data->mpu_rg_cfg_adr - DFP_FLASH_OFFSET;
-
-			if (cfg_size == 0) {
-				pr_err("invalid cfg size %d\r\n", cfg_size);
-				return;
-			}
-
-			cfg_header[0] = FWCFG_ID_DFP_CFGSIZE;
-			cfg_header[1] = cfg_size;
-
-			memcpy(data->tbuffer, cfg_header, 8);
-
-			usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-				data->tbuffer, 8, memx_complete, data);
-
-			/* send the data out the bulk port */
-			if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-				pr_err("Can't submit cfg size");
-				return;
-			}
-
-			if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-				pr_err("wait cfg size timeout\n");
-				return;
-			}
-
-			while (cfg_size > 0) {
-				if (cfg_size > MAX_CFG_SZ) {
-					memcpy(data->tbuffer, (uint8_t *)(buffer+dfp_cfg_addr), MAX_CFG_SZ);
-					usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-						data->tbuffer, MAX_CFG_SZ, memx_complete, data);
-
-					dfp_cfg_addr += MAX_CFG_SZ;
-					cfg_size -= MAX_CFG_SZ;
-				} else {
-					memcpy(data->tbuffer, (uint8_t *)(buffer+dfp_cfg_addr), cfg_size);
-					usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-						data->tbuffer, cfg_size, memx_complete, data);
-
-					cfg_size = 0;
-				}
-
-				/* send the data out the bulk port */
-				if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-					pr_err("Can't submit cfg data");
-					return;
-				}
-
-				if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-					pr_err("wait cfg data timeout\n");
-					return;
-				}
-			}
-
-			clear_fw_id(data);
-
-			/*program wt_mem*/
-			wtmem_count = dfp_data->mpu_cg_wt_mem_count;
-
-			if (wtmem_count == 0) {
-				pr_err("invalid wtmem count %d\r\n", wtmem_count);
-				return;
-			}
-
-			for (j = 0; j < wtmem_count; j++) {
-				wtmem_sze = dfp_data->mpu_cg_wt_mem_data[j].mpu_cg_wt_mem_data_sze;
-				dfp_wtmem_addr = dfp_data->mpu_cg_wt_mem_data[j].mpu_cg_wt_mem_data_adr - DFP_FLASH_OFFSET;
-				reg_write_addr = dfp_data->mpu_cg_wt_mem_data[j].mpu_cg_wt_mem_data_reg;
-
-				if ((wtmem_sze == 0) || (wtmem_sze == 0xFFFFFFFF))
-					continue;
-
-				while (wtmem_sze > 0) {
-					set_wtmem_addr(data, FWCFG_ID_DFP_WMEMADR, reg_write_addr);
-
-					if (wtmem_sze > MAX_CFG_SZ) {
-						set_wtmem_size(data, MAX_CFG_SZ);
-						memcpy(data->tbuffer, (uint8_t *)(buffer+dfp_wtmem_addr), MAX_CFG_SZ);
-						usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-							data->tbuffer, MAX_CFG_SZ, memx_complete, data);
-
-						dfp_wtmem_addr += MAX_CFG_SZ;
-
-						reg_write_addr += MAX_CFG_SZ;
-
-						wtmem_sze -= MAX_CFG_SZ;
-					} else {
-						set_wtmem_size(data, wtmem_sze);
-						memcpy(data->tbuffer, (uint8_t *)(buffer+dfp_wtmem_addr), wtmem_sze);
-						usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-							data->tbuffer, wtmem_sze, memx_complete, data);
-
-						wtmem_sze = 0;
-					}
-
-					/* send the data out the bulk port */
-					if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-						pr_err("Can't submit wtmem data");
-						return;
-					}
-
-					if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-						pr_err("wait wtmem data timeout\n");
-						return;
-					}
-					clear_fw_id(data);
-				}
-
-				wtmemflg_sze = dfp_data->mpu_cg_wt_mem_data[j].mpu_cg_wt_memflg_data_sze;
-				dfp_wtmem_addr = dfp_data->mpu_cg_wt_mem_data[j].mpu_cg_wt_memflg_data_adr - DFP_FLASH_OFFSET;
-				reg_write_addr = dfp_data->mpu_cg_wt_mem_data[j].mpu_cg_wt_memflg_data_reg;
-
-				if ((wtmemflg_sze == 0) || (wtmemflg_sze == 0xFFFFFFFF))
-					continue;
-
-				while (wtmemflg_sze > 0) {
-					set_wtmem_addr(data, FWCFG_ID_DFP_WMEMADR, reg_write_addr);
-
-					if (wtmemflg_sze > MAX_CFG_SZ) {
-						set_wtmem_size(data, MAX_CFG_SZ);
-						memcpy(data->tbuffer, (uint8_t *)(buffer+dfp_wtmem_addr), MAX_CFG_SZ);
-						usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-							data->tbuffer, MAX_CFG_SZ, memx_complete, data);
-
-						dfp_wtmem_addr += MAX_CFG_SZ;
-
-						reg_write_addr += MAX_CFG_SZ;
-
-						wtmemflg_sze -= MAX_CFG_SZ;
-					} else {
-						set_wtmem_size(data, MAX_CFG_SZ);
-						memcpy(data->tbuffer, (uint8_t *)(buffer+dfp_wtmem_addr), wtmemflg_sze);
-						usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-							data->tbuffer, wtmemflg_sze, memx_complete, data);
-
-						wtmemflg_sze = 0;
-					}
-					/* send the data out the bulk port */
-					if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-						pr_err("Can't submit wtmemflg data");
-						return;
-					}
-
-					if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-						pr_err("wait wtmemflg data timeout\n");
-						return;
-					}
-					clear_fw_id(data);
-				}
-			}
-			recfg_mpu(data, i + MPU_CHIP_ID_BASE);
+		if (data->run.mode != BENCH_MODE_TX) {
+			slot->rbuffer = kzalloc(data->run.xfer_size, GFP_KERNEL);
+			if (!slot->rbuffer)
+				return -ENOMEM;
 		}
 	}
+
+	return 0;
 }
 
-static ssize_t memx_read(struct file *file, char __user *user_buffer, size_t count, loff_t *ppos)
+static void bench_run(struct work_struct *work)
 {
-	struct memx_data *data = file->private_data;
-	struct usb_interface *interface;
-	size_t xfer_size;
+	struct bench_data *data = container_of(work, struct bench_data, run_work);
+	unsigned long flags;
+	int pending;
+	int i;
 
-	if (data == NULL)
-		return -ENODEV;
+	data->run = data->cfg;
+	data->run.mode = min_t(u32, data->run.mode, BENCH_MODE_MAX - 1);
+	data->run.qdepth = clamp_t(u32, data->run.qdepth, 1, BENCH_MAX_QDEPTH);
+	data->run.xfer_size = clamp_t(u32, data->run.xfer_size, 1, BENCH_MAX_XFER_SIZE);
+
+	if (bench_alloc_buffers(data)) {
+		pr_err("memx_usb_bench: can't allocate %u x %u bytes\n", data->run.qdepth, data->run.xfer_size);
+		bench_free_buffers(data);
+		WRITE_ONCE(data->running, false);
+		return;
+	}
 
-	interface = data->interface;
+	spin_lock_irqsave(&data->lock, flags);
+	memset(&data->stats, 0, sizeof(data->stats));
+	data->stats.lat_min_us = U64_MAX;
+	data->stats.start_time = ktime_get();
+	spin_unlock_irqrestore(&data->lock, flags);
 
-	/* set up our urb */
-	usb_fill_bulk_urb(data->rxurb, data->udev, usb_rcvbulkpipe(data->udev, MEMX_IN_EP),
-			data->rbuffer, MAX_OPS_SIZE, memx_rxcomplete, data);
+	reinit_completion(&data->done);
+	data->deadline = ktime_add_ms(data->stats.start_time, data->run.duration_ms);
+	atomic_set(&data->inflight, data->run.qdepth);
 
-	/* send the data out the bulk port */
-	if (usb_submit_urb(data->rxurb, GFP_KERNEL) < 0) {
-		pr_err("Can't submit RX URB");
-		return -1;
+	for (i = 0; i < data->run.qdepth; i++) {
+		if (!READ_ONCE(data->running) || !bench_slot_next(&data->slot[i], GFP_KERNEL))
+			bench_slot_finish(&data->slot[i]);
 	}
 
-	if (!wait_for_completion_timeout(&rx_comp, msecs_to_jiffies(300000))) {
-		pr_err("wait rx timeout\n");
-		return -1;
+	/* slots retire themselves after the deadline; anything still queued past the grace period is stuck */
+	if (!wait_for_completion_timeout(&data->done, msecs_to_jiffies(data->run.duration_ms + BENCH_GRACE_MS))) {
+		pending = atomic_read(&data->inflight);
+		pr_err("memx_usb_bench: %d transfers timed out\n", pending);
+		spin_lock_irqsave(&data->lock, flags);
+		data->stats.timeout_err += pending;
+		spin_unlock_irqrestore(&data->lock, flags);
 	}
 
-	xfer_size = data->rxurb->actual_length;
+	/* past the deadline, so killed slots retire instead of resubmitting */
+	usb_kill_anchored_urbs(&data->anchor);
+	wait_for_completion(&data->done);
 
-	if (copy_to_user(user_buffer, data->rbuffer, xfer_size))
-		return -1;
+	spin_lock_irqsave(&data->lock, flags);
+	data->stats.end_time = ktime_get();
+	spin_unlock_irqrestore(&data->lock, flags);
+	/* readers that see running cleared must see end_time, pairs with bench_stats_show() */
+	smp_wmb();
+	WRITE_ONCE(data->running, false);
 
-	return xfer_size;
+	bench_free_buffers(data);
+	pr_info("memx_usb_bench: %s done, %llu transfers\n", bench_mode_name[data->run.mode], data->stats.xfers);
 }
 
-static ssize_t memx_write(struct file *file, const char __user *user_buffer, size_t n_bytes, loff_t *pos)
+static void bench_stop(struct bench_data *data)
 {
-	struct memx_data *data = file->private_data;
-	struct usb_interface *interface;
-	char *buf = data->tbuffer;
-	int xfer_total_size = n_bytes;
-	size_t xfer_size;
-	int i = 0;
-	ssize_t ret_size = 0;
-
-	if (data == NULL)
-		return -ENODEV;
-
-	interface = data->interface;
-
-	mutex_lock(&data->cfglock);
-
-	while (xfer_total_size > 0) {
-		if (xfer_total_size > MAX_MPUOUT_SIZE)
-			xfer_size = MAX_MPUOUT_SIZE;
-		else
-			xfer_size = xfer_total_size;
-
-		if (copy_from_user(buf, user_buffer + i*MAX_MPUOUT_SIZE, xfer_size)) {
-			pr_err("Copy from user failed!");
-			ret_size = 0;
-			break;
-		}
-
-		/* set up our urb */
-		usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_OUT_EP),
-				buf, xfer_size, memx_txcomplete, data);
-
-		/* send the data out the bulk port */
-		if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-			pr_err("Can't submit TX URB");
-			ret_size = 0;
-			break;
-		}
+	WRITE_ONCE(data->running, false);
+	usb_kill_anchored_urbs(&data->anchor);
+	flush_work(&data->run_work);
+}
 
-		if (!wait_for_completion_timeout(&tx_comp, msecs_to_jiffies(300000))) {
-			pr_err("wait tx timeout\n");
-			ret_size = 0;
-			break;
-		}
+/* upper bound of the bucket holding the pct-th percentile */
+static u64 bench_hist_percentile(const struct bench_stats *stats, u32 pct)
+{
+	u64 target = div_u64(stats->xfers * pct + 99, 100);
+	u64 seen = 0;
+	int i;
 
-		ret_size += xfer_size;
-		xfer_total_size -= xfer_size;
-		i++;
+	for (i = 0; i < BENCH_HIST_CNT; i++) {
+		seen += stats->hist[i];
+		if (seen >= target)
+			return 1ULL << (i + 1);
 	}
 
-	mutex_unlock(&data->cfglock);
-
-	return ret_size;
+	return 1ULL << BENCH_HIST_CNT;
 }
 
-static int memx_release(struct inode *inode, struct file *file)
+static int bench_stats_show(struct seq_file *s, void *unused)
 {
-	struct memx_data *dev = file->private_data;
-	struct usb_interface *interface;
-
-	if (dev == NULL)
-		return -ENODEV;
+	struct bench_data *data = s->private;
+	struct bench_stats stats;
+	unsigned long flags;
+	bool running = READ_ONCE(data->running);
+	u64 elapsed_us;
+	u64 tx_rate, rx_rate;
+	int i;
 
-	interface = dev->interface;
+	/* pairs with the smp_wmb() in bench_run() */
+	smp_rmb();
+	spin_lock_irqsave(&data->lock, flags);
+	stats = data->stats;
+	spin_unlock_irqrestore(&data->lock, flags);
+
+	if (!stats.start_time) {
+		seq_puts(s, "no run yet\n");
+		return 0;
+	}
+
+	/* a stopped run is still winding down until end_time is stamped */
+	elapsed_us = ktime_us_delta((running || !stats.end_time) ? ktime_get() : stats.end_time, stats.start_time);
+	if (!elapsed_us)
+		elapsed_us = 1;
+	/* bytes/us == MB/s, kept with two decimals */
+	tx_rate = div64_u64(stats.tx_bytes * 100, elapsed_us);
+	rx_rate = div64_u64(stats.rx_bytes * 100, elapsed_us);
+
+	seq_printf(s, "state: %s\n", running ? "running" : "idle");
+	seq_printf(s, "mode: %s\n", bench_mode_name[data->run.mode]);
+	seq_printf(s, "xfer_size: %u\n", data->run.xfer_size);
+	seq_printf(s, "qdepth: %u\n", data->run.qdepth);
+	seq_printf(s, "elapsed_us: %llu\n", elapsed_us);
+	seq_printf(s, "transfers: %llu\n", stats.xfers);
+	seq_printf(s, "tx_bytes: %llu\n", stats.tx_bytes);
+	seq_printf(s, "rx_bytes: %llu\n", stats.rx_bytes);
+	seq_printf(s, "tx_MBps: %llu.%02llu\n", tx_rate / 100, tx_rate % 100);
+	seq_printf(s, "rx_MBps: %llu.%02llu\n", rx_rate / 100, rx_rate % 100);
+	if (stats.xfers) {
+		seq_printf(s, "latency_us: min %llu avg %llu max %llu\n", stats.lat_min_us,
+			div64_u64(stats.lat_sum_us, stats.xfers), stats.lat_max_us);
+		seq_printf(s, "latency_us: p50 <%llu p90 <%llu p99 <%llu\n", bench_hist_percentile(&stats, 50),
+			bench_hist_percentile(&stats, 90), bench_hist_percentile(&stats, 99));
+	}
+	seq_printf(s, "errors: submit %u status %u timeout %u mismatch %u\n",
+		stats.submit_err, stats.status_err, stats.timeout_err, stats.mismatch_err);
+	seq_puts(s, "histogram_us:\n");
+	for (i = 0; i < BENCH_HIST_CNT; i++) {
+		if (!stats.hist[i])
+			continue;
+		if (i == BENCH_HIST_CNT - 1)
+			seq_printf(s, "  [%8llu, +inf) %llu\n", 1ULL << i, stats.hist[i]);
+		else
+			seq_printf(s, "  [%8llu, %8llu) %llu\n", i ? (1ULL << i) : 0, 1ULL << (i + 1), stats.hist[i]);
+	}
 
 	return 0;
 }
+DEFINE_SHOW_ATTRIBUTE(bench_stats);
 
-static int memx_open(struct inode *inode, struct file *file)
+static ssize_t bench_control_read(struct file *file, char __user *user_buffer, size_t count, loff_t *ppos)
 {
-	struct memx_data *dev;
-	struct usb_interface *interface;
-
-	//printk("%s %d\n", __func__, __LINE__);
-
-	/* get the interface from minor number and driver information */
-	interface = usb_find_interface(&memx_ai_driver, iminor(inode));
-	if (!interface)
-		return -ENODEV;
-
-	dev = usb_get_intfdata(interface);
-	if (!dev)
-		return -ENODEV;
-
-	file->private_data = dev;
+	struct bench_data *data = file->private_data;
+	const char *state = READ_ONCE(data->running) ? "running\n" : "idle\n";
 
-	return 0;
+	return simple_read_from_buffer(user_buffer, count, ppos, state, strlen(state));
 }
 
-
-static long memx_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+static ssize_t bench_control_write(struct file *file, const char __user *user_buffer, size_t count, loff_t *ppos)
 {
-	struct memx_data *data = file->private_data;
-	struct usb_interface *interface = data->interface;
-	memx_mpu_size_t mpu_size;
-	uint32_t cfg_header[2] = {0};
-	long ret = 0;
-	int i;
-
-	if (!interface)
-		return -ENODEV;
-
-	mutex_lock(&data->cfglock);
-
-	switch (cmd) {
-	case MEMX_DRIVER_MPU_IN_SIZE:
-		if (copy_from_user(&mpu_size, (memx_mpu_size_t *)arg, sizeof(memx_mpu_size_t))) {
-			pr_err("MEMX_DRIVER_MPU_IN_SIZE, copy_from_user fail\n");
-			ret = -ENOMEM;
-			break;
-		}
-		for (i = 0; i < MEMX_TOTAL_FLOW_COUNT; i++) {
-			data->flow_size[i] = mpu_size.flow_size[i];
-			data->buffer_size[i] = mpu_size.buffer_size[i];
-		}
-
-		MAX_MPUIN_SIZE = data->buffer_size[0];
-
-		cfg_header[0] = FWCFG_ID_MPU_INSIZE;
-		cfg_header[1] = 4*MEMX_TOTAL_FLOW_COUNT;
-
-		memcpy(data->tbuffer, cfg_header, 8);
-
-		usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-			data->tbuffer, 8, memx_complete, data);
-
-		/* send the data out the bulk port */
-		if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-			pr_err("Can't submit cfg dfp");
-			ret = -ENOMEM;
-			break;
-		}
-
-		if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-			pr_err("wait cfg dfp timeout\n");
-			ret = -ENOMEM;
-			break;
-		}
-
-		memcpy(data->tbuffer, data->buffer_size, 4*MEMX_TOTAL_FLOW_COUNT);
-
-		usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-			data->tbuffer, 4*MEMX_TOTAL_FLOW_COUNT, memx_complete, data);
-
-		/* send the data out the bulk port */
-		if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-			pr_err("Can't submit cfg dfp");
-			ret = -ENOMEM;
-			break;
-		}
-
-		if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-			pr_err("wait cfg dfp timeout\n");
-			ret = -ENOMEM;
-			break;
-		}
+	struct bench_data *data = file->private_data;
+	char cmd[16] = {0};
+	ssize_t ret = count;
 
-		clear_fw_id(data);
-	break;
-	case MEMX_DRIVER_MPU_OUT_SIZE:
-		if (copy_from_user(&mpu_size, (memx_mpu_size_t *)arg, sizeof(memx_mpu_size_t))) {
-			pr_err("MEMX_DRIVER_MPU_IN_SIZE, copy_from_user fail\n");
-			ret = -ENOMEM;
-			break;
-		}
-		MAX_MPUOUT_SIZE = mpu_size.cfg_size;
-	break;
-	case MEMX_FW_MPU_OUT_SIZE:
-		if (copy_from_user(&mpu_size, (memx_mpu_size_t *)arg, sizeof(memx_mpu_size_t))) {
-			pr_err("MEMX_DRIVER_MPU_IN_SIZE, copy_from_user fail\n");
-			ret = -ENOMEM;
-			break;
-		}
-		cfg_header[0] = FWCFG_ID_MPU_OUTSIZE;
-		cfg_header[1] = 4;
-
-		memcpy(data->tbuffer, cfg_header, 8);
-
-		usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-			data->tbuffer, 8, memx_complete, data);
-
-		/* send the data out the bulk port */
-		if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-			pr_err("Can't submit cfg dfp");
-			ret = -ENOMEM;
-			break;
-		}
-
-		if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-			pr_err("wait cfg dfp timeout\n");
-			ret = -ENOMEM;
-			break;
-		}
+	if (copy_from_user(cmd, user_buffer, min(count, sizeof(cmd) - 1)))
+		return -EFAULT;
 
-		memcpy(data->tbuffer, &mpu_size.cfg_size, 4);
-
-		usb_fill_bulk_urb(data->txurb, data->udev, usb_sndbulkpipe(data->udev, MEMX_FW_OUT_EP),
-			data->tbuffer, 4, memx_complete, data);
-
-		/* send the data out the bulk port */
-		if (usb_submit_urb(data->txurb, GFP_KERNEL) < 0) {
-			pr_err("Can't submit cfg dfp");
-			ret = -ENOMEM;
-			break;
-		}
-
-		if (!wait_for_completion_timeout(&fw_comp, msecs_to_jiffies(30000))) {
-			pr_err("wait cfg dfp timeout\n");
-			ret = -ENOMEM;
-			break;
+	mutex_lock(&data->ctrl_lock);
+	if (sysfs_streq(cmd, "start")) {
+		if (READ_ONCE(data->running)) {
+			ret = -EBUSY;
+		} else {
+			WRITE_ONCE(data->running, true);
+			schedule_work(&data->run_work);
 		}
-
-		clear_fw_id(data);
-	break;
-	default:
-		ret = -ENOTTY;
-	break;
+	} else if (sysfs_streq(cmd, "stop")) {
+		bench_stop(data);
+	} else {
+		ret = -EINVAL;
 	}
-
-	mutex_unlock(&data->cfglock);
+	mutex_unlock(&data->ctrl_lock);
 
 	return ret;
 }
 
-static const struct file_operations memx_fops = {
-	.owner		  = THIS_MODULE,
-	.read		   = memx_read,
-	.write		  = memx_write,
-	.open		   = memx_open,
-	.unlocked_ioctl = memx_ioctl,
-	.release		= memx_release,
-	.llseek		 = default_llseek,
+static const struct file_operations bench_control_fops = {
+	.owner = THIS_MODULE,
+	.open  = simple_open,
+	.read  = bench_control_read,
+	.write = bench_control_write,
+	.llseek = default_llseek,
 };
 
-static struct usb_class_driver memxchip_class = {
-	.name =		 "memxchip",
-	.fops =		 &memx_fops,
-	.minor_base =   USB_MEMXCHIP3_MINOR_BASE,
-};
+static u8 bench_pick_endpoint(struct usb_interface *intf, unsigned int addr, bool dir_in)
+{
+	struct usb_host_interface *alt = intf->cur_altsetting;
+	int i;
 
-static struct usb_class_driver memxchip_classo = {
-	.name =		 "memxchipo",
-	.fops =		 &memx_fops,
-	.minor_base =   USB_MEMXCHIP3_MINOR_BASE,
-};
+	if (addr)
+		return addr;
 
-static struct usb_class_driver memxchip_classi = {
-	.name =		 "memxchipi",
-	.fops =		 &memx_fops,
-	.minor_base =   USB_MEMXCHIP3_MINOR_BASE,
-};
+	for (i = 0; i < alt->desc.bNumEndpoints; i++) {
+		struct usb_endpoint_descriptor *desc = &alt->endpoint[i].desc;
+
+		if (dir_in ? usb_endpoint_is_bulk_in(desc) : usb_endpoint_is_bulk_out(desc))
+			return desc->bEndpointAddress;
+	}
+
+	return 0;
+}
 
 static int memx_probe(struct usb_interface *intf, const struct usb_device_id *id)
 {
 	struct usb_device *udev = interface_to_usbdev(intf);
-	struct memx_data *data;
+	struct bench_data *data;
+	int i;
 
 	data = devm_kzalloc(&intf->dev, sizeof(*data), GFP_KERNEL);
 	if (!data)
 		return -ENOMEM;
 
-	data->udev  = udev;
-
-	data->txurb = usb_alloc_urb(0, GFP_KERNEL);
-	if (!data->txurb)
-		return -ENOMEM;
-
-	data->txurb->transfer_flags = URB_ZERO_PACKET;
+	data->udev = udev;
+	data->ep_in = bench_pick_endpoint(intf, ep_in, true);
+	data->ep_out = bench_pick_endpoint(intf, ep_out, false);
+	if (!data->ep_in || !data->ep_out) {
+		pr_err("memx_usb_bench: no bulk endpoint pair on %s\n", dev_name(&intf->dev));
+		return -ENODEV;
+	}
 
-	data->rxurb = usb_alloc_urb(0, GFP_KERNEL);
-	if (!data->rxurb)
-		return -ENOMEM;
+	for (i = 0; i < BENCH_MAX_QDEPTH; i++) {
+		data->slot[i].data = data;
+		data->slot[i].txurb = usb_alloc_urb(0, GFP_KERNEL);
+		data->slot[i].rxurb = usb_alloc_urb(0, GFP_KERNEL);
+		if (!data->slot[i].txurb || !data->slot[i].rxurb)
+			goto fail;
 
-	data->tbuffer = kzalloc(MAX_OPS_SIZE, GFP_KERNEL);
-	if (!data->tbuffer) {
-		//pr_err("Can't allocate memory for tx");
-		usb_free_urb(data->txurb);
-		return -ENOMEM;
+		data->slot[i].txurb->transfer_flags = URB_ZERO_PACKET;
 	}
 
-	data->rbuffer = kzalloc(MAX_OPS_SIZE, GFP_KERNEL);
-	if (!data->rbuffer) {
-		//pr_err("Can't allocate memory for rx");
-		usb_free_urb(data->rxurb);
-		return -ENOMEM;
-	}
+	data->cfg.mode = mode;
+	data->cfg.xfer_size = xfer_size;
+	data->cfg.qdepth = qdepth;
+	data->cfg.duration_ms = duration_ms;
+	data->run = data->cfg;
 
-	mutex_init(&data->cfglock);
+	init_usb_anchor(&data->anchor);
+	spin_lock_init(&data->lock);
+	mutex_init(&data->ctrl_lock);
+	init_completion(&data->done);
+	INIT_WORK(&data->run_work, bench_run);
 
 	data->interface = usb_get_intf(intf);
-
 	usb_set_intfdata(intf, data);
 
-	if (id->idProduct == ROLE_MULTI_FIRST)
-		usb_register_dev(intf, &memxchip_classo);
-	else if (id->idProduct == ROLE_MULTI_LAST)
-		usb_register_dev(intf, &memxchip_classi);
-	else
-		usb_register_dev(intf, &memxchip_class);
-
-	INIT_WORK(&data->fw_work, fw_thread);
-	schedule_work(&data->fw_work);
-
-	if (!loop && !fw_dwn && !dfp_dwn) {
-		INIT_WORK(&data->tx_work, tx_thread);
-		INIT_WORK(&data->rx_work, rx_thread);
-		if (emu) {
-			schedule_work(&data->tx_work);
-			schedule_work(&data->rx_work);
-		}
-	}
+	data->dbg_dir = debugfs_create_dir(dev_name(&intf->dev), bench_dbgfs_root);
+	debugfs_create_u32("mode", 0644, data->dbg_dir, &data->cfg.mode);
+	debugfs_create_u32("xfer_size", 0644, data->dbg_dir, &data->cfg.xfer_size);
+	debugfs_create_u32("qdepth", 0644, data->dbg_dir, &data->cfg.qdepth);
+	debugfs_create_u32("duration_ms", 0644, data->dbg_dir, &data->cfg.duration_ms);
+	debugfs_create_file("control", 0644, data->dbg_dir, data, &bench_control_fops);
+	debugfs_create_file("stats", 0444, data->dbg_dir, data, &bench_stats_fops);
 
+	pr_info("memx_usb_bench: %s bound, ep out 0x%02x in 0x%02x\n", dev_name(&intf->dev), data->ep_out, data->ep_in);
 	return 0;
+
+fail:
+	for (i = 0; i < BENCH_MAX_QDEPTH; i++) {
+		usb_free_urb(data->slot[i].txurb);
+		usb_free_urb(data->slot[i].rxurb);
+	}
+	return -ENOMEM;
 }
+
 static void memx_disconnect(struct usb_interface *intf)
 {
-	struct memx_data *data = usb_get_intfdata(intf);
+	struct bench_data *data = usb_get_intfdata(intf);
+	int i;
 
-	cancel_work_sync(&data->fw_work);
-	if (!loop && !fw_dwn && !dfp_dwn) {
-		cancel_work_sync(&data->tx_work);
-		cancel_work_sync(&data->rx_work);
-	}
+	debugfs_remove_recursive(data->dbg_dir);
 
-	usb_kill_urb(data->txurb);
-	usb_kill_urb(data->rxurb);
+	mutex_lock(&data->ctrl_lock);
+	bench_stop(data);
+	mutex_unlock(&data->ctrl_lock);
 
-	usb_deregister_dev(intf, &memxchip_class);
+	for (i = 0; i < BENCH_MAX_QDEPTH; i++) {
+		usb_free_urb(data->slot[i].txurb);
+		usb_free_urb(data->slot[i].rxurb);
+	}
 
 	usb_set_intfdata(intf, NULL);
-
-	usb_free_urb(data->txurb);
-	usb_free_urb(data->rxurb);
-	kfree(data->tbuffer);
-	kfree(data->rbuffer);
+	usb_put_intf(data->interface);
 }
 
-static struct usb_driver memx_ai_driver = {
-	.name		= "memx_ai_chip",
+static struct usb_driver memx_bench_driver = {
+	.name		= "memx_usb_bench",
 	.probe		= memx_probe,
 	.disconnect	= memx_disconnect,
 	.id_table	= memx_table,
 	.disable_hub_initiated_lpm = 0,
 };
 
-module_usb_driver(memx_ai_driver);
+static int __init memx_bench_init(void)
+{
+	int ret;
+
+	bench_dbgfs_root = debugfs_create_dir(BENCH_DBGFS_ROOT, NULL);
+
+	ret = usb_register(&memx_bench_driver);
+	if (ret)
+		debugfs_remove_recursive(bench_dbgfs_root);
+
+	return ret;
+}
+
+static void __exit memx_bench_exit(void)
+{
+	usb_deregister(&memx_bench_driver);
+	debugfs_remove_recursive(bench_dbgfs_root);
+}
+
+module_init(memx_bench_init);
+module_exit(memx_bench_exit);
 
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("Howard Chang");
 MODULE_VERSION(VERSION);
-MODULE_DESCRIPTION("A Bulk Test sample");
+MODULE_DESCRIPTION("MemryX USB bulk throughput/latency benchmark");
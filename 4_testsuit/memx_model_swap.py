@@ -0,0 +1,252 @@
+import mxa # mxa driver
+import numpy as np
+import os, sys, glob, time, argparse
+from pathlib import Path
+from utilities.dfp_inspect import dfp_inspect
+from utilities.benchmark import Benchmark, latency_summary
+
+# name: (download type, from buffer)
+DOWNLOAD_TYPES = {
+    'wtmem_and_model'   : (mxa.download_type_wtmem_and_model, False),
+    'legacy'            : (mxa.download_type_wtmem_and_model_legacy, False),
+    'buffer'            : (mxa.download_type_wtmem_and_model_buffer, True),
+    'wtmem'             : (mxa.download_type_wtmem, False),
+    'model'             : (mxa.download_type_model, False),
+}
+
+# per swap phases (ms) of the result files
+PHASES = ['read', 'disable', 'download', 'host', 'wtmem', 'rgcfg', 'admin', 'enable', 'swap']
+
+def __parse():
+        """
+        Setup the parser (`argparse`) and parse the command line arguments.
+        """
+
+        epilog = "Examples:\n"
+        epilog += "\n"
+        epilog += "    » python memx_model_swap                                   # swap the first 2 dfp under dfp folder with every download type'. \n"
+        epilog += "    » python memx_model_swap --dfp dfp/a dfp/b dfp/c           # swap between these testcase folders'. \n"
+        epilog += "    » python memx_model_swap --types wtmem_and_model buffer    # only these download types'. \n"
+        epilog += "    » python memx_model_swap --swaps 200 -g 1                  # 200 swaps per type on device group 1'. \n"
+
+        parser = argparse.ArgumentParser(
+                 description = "\033[34mMemryX Model Swap Benchmark\033[0m",
+                 formatter_class = argparse.RawDescriptionHelpFormatter,
+                 epilog=epilog)
+
+        visual = parser.add_argument_group("Visualization")
+        control = parser.add_argument_group("Control")
+        #-- Verbosity ---------------------------------------------------------
+        visual.add_argument("-v",
+                            dest = "verbose",
+                            action  = "count",
+                            default = 0,
+                            help    = "Verbose messaging")
+
+        #-- Control -----------------------------------------------------------
+        control.add_argument("--dir",
+                             dest    =   "dataflow_dir",
+                             action  =   "store",
+                             type    =   str,
+                             default =   "dfp",
+                             metavar =   "",
+                             help    =   "the root folder to put DFP file")
+
+        control.add_argument("--dfp",
+                             dest    =   "dfp",
+                             action  =   "store",
+                             nargs   =   "+",
+                             default =   None,
+                             metavar =   "DFP",
+                             help    =   "testcase folders or .dfp files to swap between, instead of the first --models of --dir")
+
+        control.add_argument("--models",
+                             dest    =   "models",
+                             action  =   "store",
+                             type    =   int,
+                             default =   2,
+                             help    =   "how many testcases of --dir to swap between")
+
+        control.add_argument("--log",
+                             dest    =   "log_dir",
+                             action  =   "store",
+                             type    =   str,
+                             default =   "log",
+                             metavar =   "",
+                             help    =   "the root folder to put log file")
+
+        control.add_argument("-g",
+                             dest    =   "device_group",
+                             action  =   "store",
+                             type    =   int,
+                             default =   0,
+                             metavar =   "",
+                             help    =   "the device group index for running")
+
+        control.add_argument("--types",
+                             dest    =   "types",
+                             action  =   "store",
+                             nargs   =   "+",
+                             choices =   list(DOWNLOAD_TYPES),
+                             default =   list(DOWNLOAD_TYPES),
+                             help    =   "download types to swap with")
+
+        control.add_argument("--swaps",
+                             dest    =   "swaps",
+                             action  =   "store",
+                             type    =   int,
+                             default =   20,
+                             help    =   "measured swaps per download type")
+
+        control.add_argument("--warmup",
+                             dest    =   "warmup",
+                             action  =   "store",
+                             type    =   int,
+                             default =   2,
+                             help    =   "unmeasured swaps per download type before --swaps")
+
+        cmd_args = parser.parse_args()
+
+        return cmd_args
+
+def find_dfps(cmd_arg):
+    if cmd_arg.dfp:
+        paths = [Path(d) if d.endswith('.dfp') else Path(d, 'model.dfp') for d in cmd_arg.dfp]
+    else:
+        paths = sorted(Path(p) for p in glob.glob(str(Path(cmd_arg.dataflow_dir, '*', 'model.dfp'))))[:cmd_arg.models]
+    for p in paths:
+        if not p.is_file():
+            raise Exception("{} is not file".format(p))
+    mpus = {dfp_inspect(str(p))['num_mxas'] for p in paths}
+    if len(mpus) > 1:
+        raise Exception("dfps are compiled for different chip counts {}, cannot swap on one group".format(sorted(mpus)))
+    return paths
+
+def download_stats_path(group):
+    """
+    Kernel driver DFP download counters of a device (PCIe, fs_debug_en=1), None if not exposed.
+    """
+    for root in ('/sys', '/proc'):
+        path = Path(root, 'memx{}'.format(group), 'dfp_download')
+        if path.is_file():
+            return path
+    return None
+
+def read_download_stats(path):
+    """
+    Kernel time (ms) spent in weight memory, register config and admin (Cascade+) download
+    commands of the device since driver load or the last "reset" written to `path`.
+    """
+    stats = {'wtmem': 0.0, 'rgcfg': 0.0, 'admin': 0.0}
+    if path is None:
+        return stats
+    with open(str(path), 'r') as f:
+        for line in f.read().split('\n')[2:]:
+            cols = [c.strip() for c in line.split('|')]
+            if len(cols) == 3 and cols[0].lower() in stats:
+                stats[cols[0].lower()] = int(cols[2]) / 1000
+    return stats
+
+def swap(model, dfp, dl_type, from_buffer, stats_path):
+    """
+    Swap `model` to `dfp`: stop streaming, download, restart streaming. Returns the phase times (ms).
+    """
+    t = {}
+    start = time.perf_counter()
+    with open(str(dfp), 'rb') as f:
+        data = f.read()
+    t['read'] = (time.perf_counter() - start) * 1000
+    before = read_download_stats(stats_path)
+
+    start = time.perf_counter()
+    err = mxa.set_stream_disable(model, 1)
+    t['disable'] = (time.perf_counter() - start) * 1000
+    if err:
+        raise Exception("set_stream_disable failed with code {}".format(err))
+
+    start = time.perf_counter()
+    if from_buffer:
+        err = mxa.download_buffer(model, data)
+    else:
+        err = mxa.download(model, str(dfp), 0, dl_type)
+    t['download'] = (time.perf_counter() - start) * 1000
+    if err:
+        raise Exception("download failed with code {}".format(err))
+    after = read_download_stats(stats_path)
+    t.update({k: after[k] - before[k] for k in after})
+    # parsing and user to kernel copies of the driver library, file read included for file downloads
+    t['host'] = max(t['download'] - t['wtmem'] - t['rgcfg'] - t['admin'], 0.0)
+
+    start = time.perf_counter()
+    err = mxa.set_stream_enable(model, 0)
+    t['enable'] = (time.perf_counter() - start) * 1000
+    if err:
+        raise Exception("set_stream_enable failed with code {}".format(err))
+
+    t['swap'] = t['disable'] + t['download'] + t['enable'] + (t['read'] if from_buffer else 0.0)
+    return t
+
+def run_type(accl, name, dfps, cmd_arg, stats_path, detail_file):
+    """
+    Warm up and measured swaps round robin over `dfps` with one download type, returns its summary.
+    """
+    dl_type, from_buffer = DOWNLOAD_TYPES[name]
+    rows = []
+    for i in range(cmd_arg.warmup):
+        swap(accl.model, dfps[i % len(dfps)], dl_type, from_buffer, stats_path)
+
+    start = time.perf_counter()
+    for i in range(cmd_arg.swaps):
+        dfp = dfps[i % len(dfps)]
+        t = swap(accl.model, dfp, dl_type, from_buffer, stats_path)
+        rows.append(t)
+        detail_file.write('{},{},{},{}\n'.format(name, dfp.parent.name, i, ','.join('{:.3f}'.format(t[p]) for p in PHASES)))
+        if cmd_arg.verbose:
+            print('    {0:16s} {1:32s} swap {2:8.3f} ms'.format(name, dfp.parent.name, t['swap']))
+    dt = time.perf_counter() - start
+
+    result = {p: float(np.mean([r[p] for r in rows])) for p in PHASES}
+    stats = latency_summary([r['swap'] for r in rows])
+    result['p50'], result['p99'] = stats['p50'], stats['p99']
+    result['swaps_per_s'] = cmd_arg.swaps / dt
+    return result
+
+def main(cmd_arg):
+    dfps = find_dfps(cmd_arg)
+    if not dfps:
+        print('No dfp to swap')
+        return 1
+    stats_path = download_stats_path(cmd_arg.device_group)
+    if stats_path is None:
+        print('Kernel download counters not found (PCIe driver with fs_debug_en=1), wtmem/rgcfg/admin phases are 0 and host is the whole download')
+
+    detail_path = Path(cmd_arg.log_dir, 'swap_detail.csv')
+    result_path = Path(cmd_arg.log_dir, 'swap_result.csv')
+    cols = ['Type', 'Swaps', 'Swaps_per_s', 'P50_ms', 'P99_ms'] + ['{}_ms'.format(p.capitalize()) for p in PHASES]
+
+    print('{}: Swapping {} ({} swaps per type)...'.format(time.strftime("%m-%d %H:%M:%S"), ', '.join(p.parent.name for p in dfps), cmd_arg.swaps))
+    error = 0
+    with open(str(detail_path), 'w') as detail_file, open(str(result_path), 'w') as result_file:
+        detail_file.write('Type,Model,Swap,{}\n'.format(','.join('{}_ms'.format(p.capitalize()) for p in PHASES)))
+        result_file.write(','.join(cols) + '\n')
+
+        # the first dfp is downloaded as usual, every type then swaps on the same open model
+        with Benchmark(dfp=str(dfps[0]), group=cmd_arg.device_group, profile=None) as accl:
+            for name in cmd_arg.types:
+                try:
+                    r = run_type(accl, name, dfps, cmd_arg, stats_path, detail_file)
+                except Exception as e:
+                    print('{0:16s} FAIL: {1}'.format(name, e))
+                    error += 1
+                    continue
+                print('{0:16s} {1:8.2f} swaps/s, swap p50 {2:8.3f} ms p99 {3:8.3f} ms | download {4:8.3f} = host {5:8.3f} + wtmem {6:8.3f} + rgcfg {7:8.3f} + admin {8:8.3f} ms'.format(
+                      name, r['swaps_per_s'], r['p50'], r['p99'], r['download'], r['host'], r['wtmem'], r['rgcfg'], r['admin']))
+                result_file.write('{},{},{:.3f},{:.3f},{:.3f},{}\n'.format(name, cmd_arg.swaps, r['swaps_per_s'], r['p50'], r['p99'],
+                                  ','.join('{:.3f}'.format(r[p]) for p in PHASES)))
+
+    print('{}: Test Finished'.format(time.strftime("%m-%d %H:%M:%S")))
+    return error
+
+if __name__=="__main__":
+    cmd_arg = __parse()
+    sys.exit(main(cmd_arg))
@@ -1,11 +1,16 @@
 import mxa # mxa driver
-import os, sys, glob, time, struct, argparse
+import numpy as np
+import os, sys, glob, time, struct, argparse, queue
+import multiprocessing
 from pathlib import Path
 from utilities.dfp_inspect import dfp_inspect
-from utilities.benchmark import Benchmark
+from utilities.benchmark import Benchmark, ARRIVALS, TUNING_KEYS, latency_summary, tune
 from tool.perf_report import result_processing
+from tool.timeline import KernelTrace, write_chrome_trace
+from tool.perf_gate import gate_results
 
 burning_test = 0
+GROUP_TIMEOUT = 3600 # s, a group run without a result by then is terminated and reported failed
 
 def __parse():
         """
@@ -19,6 +24,14 @@ def __parse():
         epilog += "    » python memx_performance --burning                      # run all dfp repeatly'. \n"
         epilog += "    » python memx_regression --burning  --hours 3            # run all dfp repeatly about 3 hours'. \n"
         epilog += "    » python memx_performance -g 1                           # run all dfp on device group 1'. \n"
+        epilog += "    » python memx_performance --fps 500 --arrival poisson    # run all dfp open loop at 500 fps on average'. \n"
+        epilog += "    » python memx_performance --sweep 10                     # throughput vs latency curve and knee of each dfp'. \n"
+        epilog += "    » python memx_performance --groups all                   # run each dfp on every device group at once'. \n"
+        epilog += "    » python memx_performance --group_dfp 0:dfp/a 1:dfp/b    # run different dfps on groups 0 and 1 at once'. \n"
+        epilog += "    » python memx_performance --tune                         # tune queue size / threads / batch of each dfp, then run'. \n"
+        epilog += "    » python memx_performance --profile latency              # run all dfp with their latency tuning'. \n"
+        epilog += "    » sudo python memx_performance --trace 200               # timeline of 200 frames of each dfp with driver tracepoints'. \n"
+        epilog += "    » python memx_performance --repeat 5 --gate tool --gate_format gbf80   # 5 runs per dfp, gated against the tool/ history'. \n"
 
         parser = argparse.ArgumentParser(
                  description = "\033[34mMemryX Driver Test Suite\033[0m",
@@ -88,10 +101,305 @@ def __parse():
                              default =   0,
                              help    =   "Constraint fps for specific value")
 
+        control.add_argument("--arrival",
+                             dest    =   "arrival",
+                             action  =   "store",
+                             choices =   ARRIVALS,
+                             default =   "constant",
+                             help    =   "Frame arrival process of --fps / --sweep runs")
+
+        control.add_argument("--burst",
+                             dest    =   "burst_size",
+                             action  =   "store",
+                             type    =   int,
+                             default =   8,
+                             help    =   "Frames per burst for --arrival burst")
+
+        control.add_argument("--sweep",
+                             dest    =   "sweep",
+                             action  =   "store",
+                             type    =   int,
+                             default =   0,
+                             help    =   "Sweep offered load in N steps from 10%% to 120%% of the closed loop fps, "
+                                         "writing sweep_<model>.csv to the log folder")
+
+        control.add_argument("--groups",
+                             dest    =   "groups",
+                             action  =   "store",
+                             type    =   str,
+                             default =   None,
+                             metavar =   "",
+                             help    =   "Run each dfp on these device groups concurrently, e.g. '0,1,2,3' or 'all', each group a row of performance_runs.csv")
+
+        control.add_argument("--group_dfp",
+                             dest    =   "group_dfp",
+                             action  =   "store",
+                             nargs   =   "+",
+                             default =   None,
+                             metavar =   "G:DIR",
+                             help    =   "Run the dfp of testcase folder DIR on group G, all pairs concurrently")
+
+        control.add_argument("--deviation",
+                             dest    =   "deviation",
+                             action  =   "store",
+                             type    =   float,
+                             default =   10.0,
+                             help    =   "Flag groups whose fps or p50 latency deviates more than this %% from the median of groups running the same dfp")
+
+        control.add_argument("--tune",
+                             dest    =   "tune",
+                             action  =   "store_true",
+                             default =   False,
+                             help    =   "Sweep queue size, thread layout and batch of each dfp first, saving the best "
+                                         "configurations to <model>.tune.json and tune_<model>.csv in the log folder")
+
+        control.add_argument("--profile",
+                             dest    =   "profile",
+                             action  =   "store",
+                             choices =   ["throughput", "latency", "none"],
+                             default =   "throughput",
+                             help    =   "Tuning of <model>.tune.json to run each dfp with, 'none' for the defaults")
+
+        control.add_argument("--host_cost",
+                             dest    =   "host_cost",
+                             action  =   "store_true",
+                             default =   False,
+                             help    =   "Report the host CPU cost per frame of each dfp (CPU time, context switches, syscalls, "
+                                         "cycles split by conversion / syscall / other / wait) to host_cost.csv in the log folder")
+
+        control.add_argument("--trace",
+                             dest    =   "trace",
+                             action  =   "store",
+                             type    =   int,
+                             default =   0,
+                             metavar =   "FRAMES",
+                             help    =   "After the measured run, trace FRAMES more frames of each dfp into a Chrome trace "
+                                         "(trace_<model>.json in the log folder, open in ui.perfetto.dev), merged with the "
+                                         "driver tracepoints when run as root")
+
+        control.add_argument("--repeat",
+                             dest    =   "repeat",
+                             action  =   "store",
+                             type    =   int,
+                             default =   1,
+                             help    =   "Measured runs of each dfp, each one a row of performance_runs.csv; the result row has their mean FPS")
+
+        control.add_argument("--gate",
+                             dest    =   "gate",
+                             action  =   "store",
+                             type    =   str,
+                             default =   None,
+                             metavar =   "DIR",
+                             help    =   "Gate the runs against the dated result csvs in DIR (e.g. tool) with confidence intervals "
+                                         "into performance_gate.csv, exit code 1 on a significant FPS / latency regression")
+
+        control.add_argument("--gate_format",
+                             dest    =   "gate_format",
+                             action  =   "store",
+                             type    =   str,
+                             default =   None,
+                             metavar =   "",
+                             help    =   "Format of the dfps (e.g. gbf80, fp32) to pick the history files of with --gate")
+
         cmd_args = parser.parse_args()
+        if cmd_args.profile == "none":
+            cmd_args.profile = None
+        # multi-group runs only measure fps and latency of each group
+        if cmd_args.groups or cmd_args.group_dfp:
+            if cmd_args.groups and cmd_args.group_dfp:
+                parser.error("--groups and --group_dfp are exclusive")
+            unsupported = [opt for opt, used in (("--tune", cmd_args.tune), ("--host_cost", cmd_args.host_cost),
+                                                 ("--trace", cmd_args.trace > 0), ("--sweep", cmd_args.sweep > 0),
+                                                 ("--repeat", cmd_args.repeat > 1)) if used]
+            if unsupported:
+                parser.error("{} not supported with --groups / --group_dfp".format(", ".join(unsupported)))
 
         return cmd_args
 
+def run_sweep(accl, max_fps, cmd_arg, sweep_path):
+    """
+    Offered load sweep around the closed loop fps of a model, saved as a throughput vs latency curve.
+    """
+    rates = np.linspace(0.1, 1.2, cmd_arg.sweep) * max_fps
+    points, knee = accl.sweep(rates, frames=cmd_arg.frames)
+
+    cols = ['offered_fps', 'fps', 'mean', 'p50', 'p90', 'p99', 'p99.9', 'max']
+    with open(str(sweep_path), 'w') as f:
+        f.write(','.join(cols) + '\n')
+        for pt in points:
+            f.write(','.join('{:.3f}'.format(pt[c]) for c in cols) + '\n')
+
+    for pt in points:
+        print('    offered {0:9.2f} fps -> {1:9.2f} fps, p50 {2:8.3f} ms, p99 {3:8.3f} ms'.format(pt['offered_fps'], pt['fps'], pt['p50'], pt['p99']))
+    if knee:
+        print('    knee: {0:.2f} fps at p99 {1:.3f} ms ({2})'.format(knee['offered_fps'], knee['p99'], cmd_arg.arrival))
+    else:
+        print('    knee: saturated at every load point')
+
+HOST_COST_COLS = ['cores', 'max_streams', 'user_us', 'sys_us', 'vcsw', 'ivcsw', 'syscalls',
+                  'convert_us', 'syscall_us', 'other_us', 'wait_us']
+
+def report_host_cost(name, fps, cost, host_cost_path):
+    """
+    Appends the host cost per frame of a run (`Benchmark.host_cost`) to the host cost csv and prints it.
+    """
+    fmt = lambda v: '' if v is None else '{:.3f}'.format(v)
+    cycles = cost['cycles'] or {}
+    driver = cost['driver'] or {}
+    with open(str(host_cost_path), 'a') as f:
+        f.write('{},{:.3f},{},{},{},{}\n'.format(name, fps, ','.join(fmt(cost[c]) for c in HOST_COST_COLS),
+                ','.join(fmt(cycles.get(k)) for k in ('convert', 'syscall', 'other', 'wait')),
+                fmt(driver.get('kdrv_w_us')), fmt(driver.get('kdrv_r_us'))))
+
+    print('    host: {0:.2f} cores (feeds {1} such streams), per frame user {2:.1f} us sys {3:.1f} us, '
+          '{4:.2f} ctx switches, {5} syscalls'.format(cost['cores'], '{:.1f}'.format(cost['max_streams']) if cost['max_streams'] else 'n/a', cost['user_us'], cost['sys_us'],
+          cost['vcsw'] + cost['ivcsw'], fmt(cost['syscalls'])))
+    split = ' '.join('{} {:.1f} us'.format(k, cost[k + '_us']) for k in ('convert', 'syscall', 'other', 'wait'))
+    if cycles:
+        split += ' | cycles ' + ' '.join('{} {:.0f}'.format(k, v) for k, v in cycles.items())
+    print('    host split: ' + split)
+    for t in cost['threads']:
+        print('      {0:8s} user {1:8.1f} us sys {2:8.1f} us convert {3:8.1f} us driver {4:8.1f} us wait {5:8.1f} us'.format(
+              t['role'], t['user_us'], t['sys_us'], t['convert_us'], t['driver_us'], t['wait_us']))
+
+def run_trace(accl, frames, name, trace_path):
+    """
+    Extra traced run of a model, host stream calls and driver transfers saved as one timeline.
+    """
+    with KernelTrace() as ktrace:
+        accl.run(frames=frames, threading=True, record_cost=False, trace=True)
+    write_chrome_trace(trace_path, accl.trace_events, accl.trace_threads, ktrace.events, name)
+    print('    trace: {} host events, {} driver transfers{} -> {}'.format(len(accl.trace_events), len(ktrace.events),
+          ' ({})'.format(ktrace.error) if ktrace.error else '', trace_path))
+
+def run_tune(dfp_path, cmd_arg, tune_path):
+    """
+    Queue size / thread layout / batch sweep of a model, saved as its tuning profile and a csv of all points.
+    """
+    profile = tune(dfp_path, group=cmd_arg.device_group, frames=cmd_arg.frames, verbose=cmd_arg.verbose)
+
+    cols = list(TUNING_KEYS) + ['fps', 'p50', 'p99']
+    with open(str(tune_path), 'w') as f:
+        f.write(','.join(cols) + '\n')
+        for pt in profile['points']:
+            f.write(','.join(str(pt[c]) for c in cols) + '\n')
+
+    for objective in ('throughput', 'latency'):
+        best = profile[objective]
+        print('    best {0:10s}: queue {1}, {2} threads, batch {3} -> {4:9.2f} fps, p99 {5:8.3f} ms'.format(
+              objective, best['queue_size'], best['threads'], best['batch'], best['fps'], best['p99']))
+
+def run_group(index, group, dfp_path, cmd_arg, barrier, result_queue):
+    """
+    Worker process of a multi-group run: one Benchmark on one group, started together with the others.
+    """
+    result = {'index': index, 'group': group, 'dfp': dfp_path.parent.name, 'fps': 0.0, 'latency': np.zeros(0), 'error': None}
+    try:
+        result['interface'] = mxa.get_interface_info(group)
+        # model ids kept distinct across the workers
+        with Benchmark(dfp=str(dfp_path), group=group, model=index, fps=cmd_arg.fps,
+                       arrival=cmd_arg.arrival, burst_size=cmd_arg.burst_size, profile=cmd_arg.profile) as accl:
+            barrier.wait()
+            _, _, fps = accl.run(frames=cmd_arg.frames, threading=True)
+            result['fps'] = fps
+            result['latency'] = accl.frame_latency
+    except Exception as e:
+        result['error'] = str(e)
+        barrier.abort()
+    result_queue.put(result)
+
+def collect_groups(jobs, workers, result_queue):
+    """
+    Results of the group workers by job index. A worker that exits without one (crash, kill) or
+    still has none after GROUP_TIMEOUT is terminated and gets an 'error' result instead.
+    """
+    results = {}
+    deadline = time.time() + GROUP_TIMEOUT
+    while len(results) < len(workers):
+        try:
+            r = result_queue.get(timeout=1)
+            results[r['index']] = r
+            continue
+        except queue.Empty:
+            pass
+        timed_out = time.time() > deadline
+        gone = [i for i, w in enumerate(workers) if i not in results and (timed_out or w.exitcode is not None)]
+        if not gone:
+            continue
+        # a worker that just exited may still have its result in the pipe
+        try:
+            while True:
+                r = result_queue.get(timeout=1)
+                results[r['index']] = r
+        except queue.Empty:
+            pass
+        for i in gone:
+            if i in results:
+                continue
+            if workers[i].exitcode is None:
+                workers[i].terminate()
+                error = 'no result within {} s'.format(GROUP_TIMEOUT)
+            else:
+                error = 'worker exited with code {}'.format(workers[i].exitcode)
+            results[i] = {'index': i, 'group': jobs[i][0], 'dfp': jobs[i][1].parent.name, 'error': error}
+    return results
+
+def run_groups(jobs, cmd_arg, groups_path, runs_path):
+    """
+    Runs (group, dfp_path) jobs concurrently, one process per group, and reports per group and
+    aggregate fps / latency. Groups running the same dfp are compared against their median to flag
+    slow modules (e.g. a downtrained PCIe link). Each group is one row of runs_path. Returns the
+    aggregate fps and latency stats, None on error.
+    """
+    # spawned, not forked: the workers open the devices with an mxa of their own
+    ctx = multiprocessing.get_context('spawn')
+    barrier = ctx.Barrier(len(jobs), timeout=600)
+    result_queue = ctx.Queue()
+    workers = [ctx.Process(target=run_group, args=(i, g, d, cmd_arg, barrier, result_queue))
+               for i, (g, d) in enumerate(jobs)]
+    [w.start() for w in workers]
+    results = sorted(collect_groups(jobs, workers, result_queue).values(), key=lambda r: r['group'])
+    [w.join(timeout=10) for w in workers]
+
+    failed = [r for r in results if r['error']]
+    for r in failed:
+        print('    group {0:3d} {1}: {2}'.format(r['group'], r['dfp'], r['error']))
+    if failed:
+        return None
+
+    tol = cmd_arg.deviation / 100.0
+    for r in results:
+        r['stats'] = latency_summary(r['latency'])
+    for r in results:
+        same = [o for o in results if o['dfp'] == r['dfp']]
+        median_fps = np.median([o['fps'] for o in same])
+        median_p50 = np.median([o['stats']['p50'] for o in same])
+        r['flag'] = 'SLOW' if (r['fps'] < (1 - tol) * median_fps or r['stats']['p50'] > (1 + tol) * median_p50) else 'OK'
+
+    total_fps = sum(r['fps'] for r in results)
+    total = latency_summary(np.concatenate([r['latency'] for r in results]))
+
+    with open(str(runs_path), 'a') as f:
+        for r in results:
+            f.write('{},{},{},{},{}\n'.format(r['dfp'], r['group'], r['fps'], r['stats']['p50'], r['stats']['p99']))
+
+    with open(str(groups_path), 'a') as f:
+        for r in results:
+            print('    group {0:3d} {1:40s} {2:10.2f} fps, p50 {3:8.3f} ms, p99 {4:8.3f} ms, iface {5:#x} {6}'.format(
+                  r['group'], r['dfp'], r['fps'], r['stats']['p50'], r['stats']['p99'], r['interface'], r['flag']))
+            f.write('{},{},{},{},{},{},{}\n'.format(r['dfp'], r['group'], r['flag'], r['fps'], r['stats']['p50'], r['stats']['p99'], r['stats']['p99.9']))
+        print('    all {0:3d} groups {1:36s} {2:10.2f} fps, p50 {3:8.3f} ms, p99 {4:8.3f} ms'.format(
+              len(results), '', total_fps, total['p50'], total['p99']))
+        f.write('{},{},{},{},{},{},{}\n'.format('+'.join(sorted(set(r['dfp'] for r in results))), 'all',
+                'SLOW' if any(r['flag'] == 'SLOW' for r in results) else 'OK', total_fps, total['p50'], total['p99'], total['p99.9']))
+
+    return total_fps, total
+
+def parse_groups(groups):
+    if groups == 'all':
+        return list(range(mxa.get_device_count()))
+    return [int(g) for g in groups.split(',')]
+
 def main(cmd_arg):
     #parameter setting
     prefix = ["k", "onnx_", "pt_", "tf_", "tfl_", "model_"]
@@ -106,19 +414,51 @@ def main(cmd_arg):
     #print(testcase_dir)
     #check already_ran in output file or not
     result_path = Path(cmd_arg.log_dir, result_file)
+    result_header = ','.join(("Model", "Result", "FPS", "P50_ms", "P99_ms", "P99.9_ms"))
     if burning_test or (Path.is_file(result_path) == False):
         #print('Creating {}'.format(str(result_path)))
         already_ran = []
         with open(str(result_path), 'w') as f:
-            f.write('{},{},{}\n'.format("Model", "Result", "FPS"))
+            f.write(result_header + '\n')
     else:
         #print('Reading {}'.format(str(result_path)))
         with open(str(result_path), 'r') as f:
             already_ran = f.read().split('\n')[:-1]
-            already_ran = [a.split(',')[0] for a in already_ran]
+        # file of an older version without the latency columns: pad its rows so resumed rows line up
+        if already_ran and already_ran[0].replace(' ', '') != result_header:
+            pad = ',' * max(len(result_header.split(',')) - len(already_ran[0].split(',')), 0)
+            with open(str(result_path), 'w') as f:
+                f.write(result_header + '\n')
+                f.writelines(a + pad + '\n' for a in already_ran[1:])
+        already_ran = [a.split(',')[0] for a in already_ran]
 
     #print(already_ran)
 
+    runs_path = Path(cmd_arg.log_dir, 'performance_runs.csv')
+    if burning_test or not runs_path.is_file():
+        with open(str(runs_path), 'w') as f:
+            f.write('{},{},{},{},{}\n'.format("Model", "Run", "FPS", "P50_ms", "P99_ms"))
+
+    groups_path = Path(cmd_arg.log_dir, 'performance_groups.csv')
+    if cmd_arg.groups or cmd_arg.group_dfp:
+        with open(str(groups_path), 'w') as f:
+            f.write('{},{},{},{},{},{},{}\n'.format("Model", "Group", "Flag", "FPS", "P50_ms", "P99_ms", "P99.9_ms"))
+
+    host_cost_path = Path(cmd_arg.log_dir, 'host_cost.csv')
+    if cmd_arg.host_cost and (burning_test or not host_cost_path.is_file()):
+        with open(str(host_cost_path), 'w') as f:
+            f.write('Model,FPS,{},{},Kdrv_W_us,Kdrv_R_us\n'.format(','.join(HOST_COST_COLS),
+                    ','.join('{}_cycles'.format(k) for k in ('convert', 'syscall', 'other', 'wait'))))
+
+    # different dfps on different groups: one concurrent run, no testcase loop
+    if cmd_arg.group_dfp:
+        jobs = [(int(g), Path(d, dfp_name)) for g, d in (gd.split(':', 1) for gd in cmd_arg.group_dfp)]
+        print('{}: Running {} groups...'.format(time.strftime("%m-%d %H:%M:%S"), len(jobs)))
+        if run_groups(jobs, cmd_arg, groups_path, runs_path) is None:
+            return - 1
+        print('{}: Test Finished'.format(time.strftime("%m-%d %H:%M:%S")))
+        return 0
+
     #running for each file
     for t in testcase_dir:
         path = Path(t)
@@ -134,21 +474,56 @@ def main(cmd_arg):
             else:
                 raise Exception("dfp_path is not file")
 
-        try:
-            with Benchmark(dfp=str(dfp_path), group = cmd_arg.device_group, frames = cmd_arg.frames, fps=cmd_arg.fps) as accl:
-                ofmaps, latency, fps = accl.run(frames=cmd_arg.frames, threading=True) # threading=True without inputs to run fps
-        except Exception as e:
-            print(e)
-            return - 1
+        if cmd_arg.tune:
+            try:
+                run_tune(dfp_path, cmd_arg, Path(cmd_arg.log_dir, 'tune_{}.csv'.format(path.name)))
+            except Exception as e:
+                print(e)
+                return - 1
+
+        if cmd_arg.groups:
+            aggregate = run_groups([(g, dfp_path) for g in parse_groups(cmd_arg.groups)], cmd_arg, groups_path, runs_path)
+            if aggregate is None:
+                return - 1
+            ofmaps, (fps, stats) = None, aggregate
+        else:
+            try:
+                with Benchmark(dfp=str(dfp_path), group = cmd_arg.device_group, frames = cmd_arg.frames, fps=cmd_arg.fps,
+                               arrival=cmd_arg.arrival, burst_size=cmd_arg.burst_size, profile=cmd_arg.profile) as accl:
+                    run_fps, run_latency = [], []
+                    for run in range(max(cmd_arg.repeat, 1)):
+                        ofmaps, latency, fps = accl.run(frames=cmd_arg.frames, threading=True) # threading=True without inputs to run fps
+                        run_fps.append(fps)
+                        run_latency.append(accl.frame_latency)
+                        with open(str(runs_path), 'a') as f:
+                            f.write('{},{},{},{},{}\n'.format(path.name, run, fps, accl.latency_stats['p50'], accl.latency_stats['p99']))
+                    fps = float(np.mean(run_fps))
+                    stats = latency_summary(np.concatenate(run_latency)) if len(run_latency) > 1 else accl.latency_stats
+                    if cmd_arg.host_cost and accl.host_cost:
+                        report_host_cost(path.name, fps, accl.host_cost, host_cost_path)
+                    if cmd_arg.sweep > 0:
+                        run_sweep(accl, fps, cmd_arg, Path(cmd_arg.log_dir, 'sweep_{}.csv'.format(path.name)))
+                    if cmd_arg.trace > 0:
+                        run_trace(accl, cmd_arg.trace, path.name, Path(cmd_arg.log_dir, 'trace_{}.json'.format(path.name)))
+            except Exception as e:
+                print(e)
+                return - 1
 
-        if (ofmaps == None) and (latency == -1):  #accl.run fps finished
-            print('{0:64s}, {1:4s}, {2:6.3f}\n'.format(path.name, "PASS", float(fps)))
+        if ofmaps is None:  #accl.run fps finished
+            print('{0:64s}, {1:4s}, {2:6.3f}, p50 {3:.3f} ms, p99 {4:.3f} ms, p99.9 {5:.3f} ms\n'.format(path.name, "PASS", float(fps), stats['p50'], stats['p99'], stats['p99.9']))
             with open(str(result_path), 'a') as f:
-                f.write('{}, {}, {}\n'.format(path.name, "PASS", fps))
+                f.write('{}, {}, {}, {}, {}, {}\n'.format(path.name, "PASS", fps, stats['p50'], stats['p99'], stats['p99.9']))
 
     #Post-processing
     if not cmd_arg.burning:
         result_processing(str(result_path))
+        if cmd_arg.gate:
+            try:
+                if gate_results(str(runs_path), cmd_arg.gate, fmt=cmd_arg.gate_format, verbose=cmd_arg.verbose):
+                    return 1
+            except ValueError as e:
+                print(e)
+                return - 1
 
     print('{}: Test Finished'.format(time.strftime("%m-%d %H:%M:%S")))
 
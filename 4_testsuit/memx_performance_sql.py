@@ -358,7 +358,7 @@ def main(cmd_arg, loop):
                     print(e)
                     return - 1
 
-                if (ofmaps == None) and (latency == -1):  #accl.run fps finished
+                if ofmaps is None:  #accl.run fps finished
                     print('{0:64s}, {1:4s}, {2:6.3f} FPS, CPU {3:.3f}, {4:.3f}mW, {5:.3f}C, {6:.3f}MHz, {7:.3f}mV, Thermal {8:.3f}C\n'.format(path.name, "PASS", average_fps, average_cpu_usage, average_power, average_temperature, Frequency, Voltage, Thermal_threshold))
 
                     with open(str(result_path), 'a') as f:
@@ -5,6 +5,7 @@ from io import BytesIO
 import numpy as np
 from utilities.dfp_inspect import dfp_inspect
 from utilities.benchmark import Benchmark
+from utilities import fmaps
 import faulthandler
 from collections import defaultdict
 ATOL = 1e-4
@@ -114,7 +115,6 @@ def run_driver_regression(cmd_arg):
 
     testcase_dir = sorted(testcase_dir)
     for t in testcase_dir:
-        num_out_ports = 0
         path = Path(t)
         # Check if results failed  with exception
         outputs_file = open(str(result_path), 'a')
@@ -138,35 +138,8 @@ def run_driver_regression(cmd_arg):
                 result = -5
 
         if result == 0:
-            # Load ifmaps
-            ifmaps = []
-            for i,(k,v) in enumerate(dfp_info['input_ports'].items()):
-                if not v['active']:
-                    continue
-                #print(v)
-                fmap = []
-                for f in range(num_frames):
-                    fname = t+'/fmaps/ifmap_truth_{}_{}'.format(i, f)
-                    fmap.append(np.loadtxt(fname).reshape(v['shape'])[:,:,:,:])
-
-                if v['packing_format'] == 'rgb888':
-                    ifmaps.append(np.array(fmap).astype(np.uint8))
-                else:
-                    ifmaps.append(np.array(fmap).astype(np.float32))
-
-            # Load ofmaps
-            ofmaps_t = []
-            for i,(k,v) in enumerate(dfp_info['output_ports'].items()):
-                if not v['active']:
-                    continue
-                #print(v)
-                fmap = []
-                num_out_ports = num_out_ports + 1
-                fmap = []
-                for f in range(num_frames):
-                    fname = t+'/fmaps/ofmap_{}_{}'.format(i, f)
-                    fmap.append(np.loadtxt(fname).reshape(v['shape']))
-                ofmaps_t.append(np.array(fmap))
+            # Load golden fmaps (memory-mapped .npy, converted from text on first use)
+            ifmaps, ofmaps_t = fmaps.load_testcase(t, dfp_info, num_frames)
             try:
                 with Benchmark(dfp=str(dfp_path), group = cmd_arg.device_group) as accl:
                     ofmaps, __, fps = accl.run(ifmaps, frames=1)
@@ -174,26 +147,12 @@ def run_driver_regression(cmd_arg):
                 return -1
 
         if ofmaps is not None:
-            passed = []
-            for f in range(num_frames):
-                for j in range(num_out_ports):
-                    if ofmaps[j].shape == ofmaps_t[j].shape:
-                        if np.allclose(ofmaps[j], ofmaps_t[j], atol=1e-4):
-                            passed.append(True)
-                            #print('>>>>>>>>>>>>>>> compare true')
-                        else:
-                            passed.append(False)
-                            #print('>>>>>>>>>>>>>>> compare false')
-
-                    else:
-                        #print('>>>>>>>>>>>>>>> shape mismatch')
-                        passed.append(False)
-                        result = -7
-
-            if all(passed):
+            passed, report = fmaps.compare(ofmaps, ofmaps_t, atol=ATOL, equal_nan=False)
+            if passed:
                 result = 0
             else:
                 result = -2
+                print(fmaps.describe(report))
         else:
             result = -6
 
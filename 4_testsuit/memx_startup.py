@@ -0,0 +1,288 @@
+import mxa # mxa driver
+import numpy as np
+import re, sys, glob, time, argparse, subprocess
+from pathlib import Path
+from utilities.benchmark import Benchmark
+
+# kernel driver "startup" stamps in probe order, each phase ends at its stamp
+KERNEL_STAMPS = ['module_init', 'probe', 'device_node', 'fs', 'fw_download', 'fw_boot', 'hw_info', 'fw_log', 'done']
+
+# waterfall width in characters
+BAR_WIDTH = 50
+
+def __parse():
+        """
+        Setup the parser (`argparse`) and parse the command line arguments.
+        """
+
+        epilog = "Examples:\n"
+        epilog += "\n"
+        epilog += "    » python memx_startup                                          # phases of the loaded driver and of the first dfp under dfp folder'. \n"
+        epilog += "    » python memx_startup --load '../r0_load.sh'                   # time from insmod to the first ofmap'. \n"
+        epilog += "    » python memx_startup --unload 'sudo rmmod memx_cascade_plus_pcie' --load '../r0_load.sh' --runs 5   # 5 restarts'. \n"
+        epilog += "    » python memx_startup --dfp dfp/a -g 1                         # this testcase on device group 1'. \n"
+
+        parser = argparse.ArgumentParser(
+                 description = "\033[34mMemryX Startup Time Profiler\033[0m",
+                 formatter_class = argparse.RawDescriptionHelpFormatter,
+                 epilog=epilog)
+
+        visual = parser.add_argument_group("Visualization")
+        control = parser.add_argument_group("Control")
+        #-- Verbosity ---------------------------------------------------------
+        visual.add_argument("-v",
+                            dest = "verbose",
+                            action  = "count",
+                            default = 0,
+                            help    = "Verbose messaging")
+
+        #-- Control -----------------------------------------------------------
+        control.add_argument("--dir",
+                             dest    =   "dataflow_dir",
+                             action  =   "store",
+                             type    =   str,
+                             default =   "dfp",
+                             metavar =   "",
+                             help    =   "the root folder to put DFP file")
+
+        control.add_argument("--dfp",
+                             dest    =   "dfp",
+                             action  =   "store",
+                             type    =   str,
+                             default =   None,
+                             metavar =   "DFP",
+                             help    =   "testcase folder or .dfp file to run, instead of the first one of --dir")
+
+        control.add_argument("--log",
+                             dest    =   "log_dir",
+                             action  =   "store",
+                             type    =   str,
+                             default =   "log",
+                             metavar =   "",
+                             help    =   "the root folder to put log file")
+
+        control.add_argument("-g",
+                             dest    =   "device_group",
+                             action  =   "store",
+                             type    =   int,
+                             default =   0,
+                             metavar =   "",
+                             help    =   "the device group index for running")
+
+        control.add_argument("--load",
+                             dest    =   "load",
+                             action  =   "store",
+                             type    =   str,
+                             default =   None,
+                             metavar =   "CMD",
+                             help    =   "shell command loading the driver (e.g. r0_load.sh), timed as the start of the waterfall")
+
+        control.add_argument("--unload",
+                             dest    =   "unload",
+                             action  =   "store",
+                             type    =   str,
+                             default =   None,
+                             metavar =   "CMD",
+                             help    =   "shell command unloading the driver, run untimed before every --load")
+
+        control.add_argument("--runs",
+                             dest    =   "runs",
+                             action  =   "store",
+                             type    =   int,
+                             default =   1,
+                             help    =   "startups to measure, more than 1 needs --load and --unload")
+
+        control.add_argument("--timeout",
+                             dest    =   "timeout",
+                             action  =   "store",
+                             type    =   float,
+                             default =   10.0,
+                             help    =   "seconds to wait for the device node after --load")
+
+        cmd_arg = parser.parse_args()
+
+        return cmd_arg
+
+def find_dfp(cmd_arg):
+    if cmd_arg.dfp:
+        path = Path(cmd_arg.dfp) if cmd_arg.dfp.endswith('.dfp') else Path(cmd_arg.dfp, 'model.dfp')
+    else:
+        paths = sorted(glob.glob(str(Path(cmd_arg.dataflow_dir, '*', 'model.dfp'))))
+        if not paths:
+            raise Exception("no model.dfp under {}".format(cmd_arg.dataflow_dir))
+        path = Path(paths[0])
+    if not path.is_file():
+        raise Exception("{} is not file".format(path))
+    return path
+
+def startup_stats_path(group):
+    """
+    Kernel driver probe phase stamps of a device (PCIe, fs_debug_en=1), None if not exposed.
+    """
+    for root in ('/sys', '/proc'):
+        path = Path(root, 'memx{}'.format(group), 'startup')
+        if path.is_file():
+            return path
+    return None
+
+def read_startup_stats(path):
+    """
+    CLOCK_MONOTONIC ns of the driver startup stamps, phases not reached are left out.
+    """
+    stamps = {}
+    with open(str(path), 'r') as f:
+        for line in f.read().split('\n')[2:]:
+            cols = [c.strip() for c in line.split('|')]
+            if len(cols) == 2 and cols[0] in KERNEL_STAMPS and int(cols[1]) > 0:
+                stamps[cols[0]] = int(cols[1])
+    return stamps
+
+def read_startup_dmesg(group):
+    """
+    Driver startup stamps from the last probe summary printk of a device, without
+    module_init. printk time is the local clock, which follows CLOCK_MONOTONIC
+    closely enough for a waterfall.
+    """
+    try:
+        log = subprocess.run(['dmesg'], stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, universal_newlines=True).stdout
+    except OSError:
+        return {}
+    pattern = re.compile(r'\[\s*([\d.]+)\]\s*memryx: startup: memx{} probe\(us\): (.*)'.format(group))
+    found = [m for m in (pattern.search(line) for line in log.split('\n')) if m]
+    if not found:
+        return {}
+    ts, pairs = found[-1].groups()
+    offsets = dict(zip(pairs.split()[0::2], (int(v) for v in pairs.split()[1::2])))
+    # the line is printed right after the "done" stamp
+    probe = int(float(ts) * 1e9) - offsets.get('done', 0) * 1000
+    stamps = {'probe': probe}
+    stamps.update({k: probe + v * 1000 for k,v in offsets.items() if k in KERNEL_STAMPS and v > 0})
+    return stamps
+
+def wait_device_node(group, timeout):
+    node = Path('/dev', 'memx{}'.format(group))
+    deadline = time.monotonic() + timeout
+    while not node.exists():
+        if time.monotonic() > deadline:
+            raise Exception("{} did not show up within {} s".format(node, timeout))
+        time.sleep(0.001)
+    return time.monotonic_ns()
+
+def startup(dfp, cmd_arg):
+    """
+    One startup, returns its waterfall segments, each a list of rows (phase, source, start ns,
+    end ns) in time order. With --load it is one segment from the load command to the first
+    ofmap, otherwise the kernel phases of the last load and the user phases are apart.
+    """
+    rows = []
+    load_start = load_end = node = None
+    if cmd_arg.load:
+        if cmd_arg.unload:
+            subprocess.run(cmd_arg.unload, shell=True)
+        load_start = time.monotonic_ns()
+        ret = subprocess.run(cmd_arg.load, shell=True).returncode
+        load_end = time.monotonic_ns()
+        if ret:
+            raise Exception("'{}' failed with code {}".format(cmd_arg.load, ret))
+        node = wait_device_node(cmd_arg.device_group, cmd_arg.timeout)
+
+    stats_path = startup_stats_path(cmd_arg.device_group)
+    kernel = read_startup_stats(stats_path) if stats_path else read_startup_dmesg(cmd_arg.device_group)
+    if load_start is not None and kernel.get('module_init', kernel.get('probe', 0)) < load_start:
+        # left over from an earlier load, the driver did not probe again
+        kernel = {}
+
+    if kernel:
+        reached = [k for k in KERNEL_STAMPS if k in kernel]
+        if load_start is not None:
+            rows.append(('insmod', 'host', load_start, kernel[reached[0]]))
+        for prev, cur in zip(reached, reached[1:]):
+            rows.append((prev if prev == 'module_init' else cur, 'kernel', kernel[prev], kernel[cur]))
+        if load_end is not None:
+            rows.append(('load_return', 'host', kernel[reached[-1]], load_end))
+    elif load_start is not None:
+        rows.append(('load', 'host', load_start, load_end))
+    if node is not None:
+        rows.append(('dev_node', 'host', load_end, node))
+
+    accl = Benchmark(dfp=str(dfp), group=cmd_arg.device_group, profile=None)
+    with accl:
+        start = time.monotonic_ns()
+        accl.run(frames=1, threading=False)
+        end = time.monotonic_ns()
+    steps = accl.init_times
+    user = [('dfp_parse', 'host', node, steps[0][1])] if node is not None else []
+    for (_, prev), (step, cur) in zip(steps, steps[1:]):
+        user.append((step, 'user', prev, cur))
+    user.append(('first_ofmap', 'user', start, end))
+    if cmd_arg.load:
+        return [rows + user]
+    return [r for r in (rows, user) if r]
+
+def print_waterfall(rows):
+    """
+    One line per phase, offsets from the first phase, with a bar placed on the whole timeline.
+    """
+    t0 = rows[0][2]
+    total = max(rows[-1][3] - t0, 1)
+    print('    {0:18s} {1:6s} {2:>10s} {3:>10s}  |{4}|'.format('Phase', 'Source', 'Start(ms)', 'Dur(ms)', ' ' * BAR_WIDTH))
+    for phase, source, start, end in rows:
+        left = int((start - t0) * BAR_WIDTH / total)
+        width = max(int(round((end - start) * BAR_WIDTH / total)), 1)
+        left = min(left, BAR_WIDTH - width)
+        print('    {0:18s} {1:6s} {2:10.3f} {3:10.3f}  |{4}{5}{6}|'.format(phase, source, (start - t0) / 1e6, (end - start) / 1e6,
+              ' ' * left, '#' * width, ' ' * (BAR_WIDTH - left - width)))
+    print('    {0:18s} {1:6s} {2:10s} {3:10.3f}'.format('total', '', '', (rows[-1][3] - t0) / 1e6))
+
+def main(cmd_arg):
+    if cmd_arg.runs > 1 and not (cmd_arg.load and cmd_arg.unload):
+        print('--runs {} needs --load and --unload to restart the driver'.format(cmd_arg.runs))
+        return 1
+    dfp = find_dfp(cmd_arg)
+    if not cmd_arg.load:
+        print('No --load, the kernel phases are from the last driver load and not on the same time line as the user phases')
+
+    detail_path = Path(cmd_arg.log_dir, 'startup_detail.csv')
+    result_path = Path(cmd_arg.log_dir, 'startup_result.csv')
+
+    print('{}: Starting {} ({} runs)...'.format(time.strftime("%m-%d %H:%M:%S"), dfp.parent.name, cmd_arg.runs))
+    error = 0
+    phases, durations = [], {}
+    with open(str(detail_path), 'w') as detail_file:
+        detail_file.write('Run,Phase,Source,Start_ms,Dur_ms\n')
+        for run in range(cmd_arg.runs):
+            try:
+                segments = startup(dfp, cmd_arg)
+            except Exception as e:
+                print('run {} FAIL: {}'.format(run, e))
+                error += 1
+                continue
+            # start offsets are within the segment
+            for rows in segments:
+                t0 = rows[0][2]
+                for phase, source, start, end in rows:
+                    detail_file.write('{},{},{},{:.3f},{:.3f}\n'.format(run, phase, source, (start - t0) / 1e6, (end - start) / 1e6))
+                    if phase not in durations:
+                        phases.append(phase)
+                        durations[phase] = []
+                    durations[phase].append((end - start) / 1e6)
+            durations.setdefault('total', []).append(sum(rows[-1][3] - rows[0][2] for rows in segments) / 1e6)
+            if cmd_arg.verbose or run == cmd_arg.runs - 1:
+                print('run {}:'.format(run))
+                for rows in segments:
+                    print_waterfall(rows)
+
+    with open(str(result_path), 'w') as result_file:
+        result_file.write('Phase,Runs,Mean_ms,Max_ms\n')
+        for phase in phases + (['total'] if 'total' in durations else []):
+            d = durations[phase]
+            result_file.write('{},{},{:.3f},{:.3f}\n'.format(phase, len(d), float(np.mean(d)), float(np.max(d))))
+    if cmd_arg.runs > 1 and 'total' in durations:
+        print('total over {} runs: mean {:.3f} ms max {:.3f} ms'.format(len(durations['total']), float(np.mean(durations['total'])), float(np.max(durations['total']))))
+
+    print('{}: Test Finished'.format(time.strftime("%m-%d %H:%M:%S")))
+    return error
+
+if __name__=="__main__":
+    cmd_arg = __parse()
+    sys.exit(main(cmd_arg))
@@ -0,0 +1,359 @@
+"""
+Statistical performance regression gate.
+
+Compares the runs of a memx_performance session (performance_runs.csv with
+--repeat, or a plain performance_result.csv) against the history of dated
+result csvs (performance_result_<format>_<platform>_<date>.csv,
+results_for_chip_bm_*, ...) of the same platform and format.
+
+Per model and metric (FPS, and P99 latency when both sides have it) the change
+of the session mean from the history mean gets a Welch confidence interval. A
+regression is flagged only when the interval excludes no change and the change
+is beyond --min_effect, so run to run noise neither raises false alarms nor
+hides a real drop behind a fixed percentage. With few samples the spread of a
+model is floored by the spread pooled over all models of the history
+(relative to their mean), which also lets single runs be gated.
+"""
+import re, sys, glob, math, time, shutil, platform, argparse
+import pandas as pd
+import numpy  as np
+from pathlib import Path
+from statistics import NormalDist
+
+# history file name prefixes, the rest is <format>[_<platform>]_<date>[_<format suffix>]
+HISTORY_PREFIXES = ('performance_result_', 'performance_runs_', 'results_for_', 'model_explorer_perf_result_')
+PLATFORMS = ('linux', 'windows')
+# _0215, _2024_3_3, _20261019_0938 (saved runs)
+DATE_PATTERNS = (r'_(\d{8}_\d{4})(?=_|$)', r'_(\d{4}_\d{1,2}_\d{1,2})(?=_|$)', r'_(\d{4})(?=_|$)')
+
+# metric: (result column, True if higher is better)
+METRICS = {'FPS': ('fps', True), 'P99_ms': ('p99', False)}
+
+def __parse():
+        """
+        Gate the runs of a memx_performance session against the historical results
+        """
+
+        epilog = "Examples:\n"
+        epilog += "\n"
+        epilog += "    » python -m tool.perf_gate --runs log/performance_runs.csv --format gbf80       # gate against tool/ history of this OS'. \n"
+        epilog += "    » python -m tool.perf_gate --runs log/performance_runs.csv --format fp32 --platform windows --alpha 0.01'. \n"
+        epilog += "    » python -m tool.perf_gate --runs log/performance_runs.csv --format gbf80 --save # add the session to the history if it passes'. \n"
+
+        parser = argparse.ArgumentParser(
+                 description = "\033[34mMemryX Performance Regression Gate\033[0m",
+                 formatter_class = argparse.RawDescriptionHelpFormatter,
+                 epilog=epilog)
+
+        visual = parser.add_argument_group("Visualization")
+        control = parser.add_argument_group("Control")
+        #-- Verbosity ---------------------------------------------------------
+        visual.add_argument("-v",
+                            dest = "verbose",
+                            action  = "count",
+                            default = 0,
+                            help    = "Verbose messaging")
+
+        #-- Control -----------------------------------------------------------
+        control.add_argument("--runs",
+                             dest    =   "runs_file",
+                             action  =   "store",
+                             type    =   str,
+                             default =   "log/performance_runs.csv",
+                             metavar =   "",
+                             help    =   "The session results, one row per model and run")
+
+        control.add_argument("--history",
+                             dest    =   "history_dir",
+                             action  =   "store",
+                             type    =   str,
+                             default =   str(Path(__file__).parent),
+                             metavar =   "",
+                             help    =   "The folder of the dated result csvs")
+
+        control.add_argument("--platform",
+                             dest    =   "platform",
+                             action  =   "store",
+                             type    =   str,
+                             default =   platform.system().lower(),
+                             metavar =   "",
+                             help    =   "Platform of the session, history files without one match any")
+
+        control.add_argument("--format",
+                             dest    =   "format",
+                             action  =   "store",
+                             type    =   str,
+                             default =   None,
+                             metavar =   "",
+                             help    =   "Format of the session (regex on the history format, e.g. gbf80 or fp32), needed when the history has several")
+
+        control.add_argument("--alpha",
+                             dest    =   "alpha",
+                             action  =   "store",
+                             type    =   float,
+                             default =   0.05,
+                             metavar =   "",
+                             help    =   "Significance level, changes get (1 - alpha) confidence intervals")
+
+        control.add_argument("--min_effect",
+                             dest    =   "min_effect",
+                             action  =   "store",
+                             type    =   float,
+                             default =   2.0,
+                             metavar =   "",
+                             help    =   "Smallest change (%%) flagged, significant or not")
+
+        control.add_argument("--result",
+                             dest    =   "result_file",
+                             action  =   "store",
+                             type    =   str,
+                             default =   "performance_gate.csv",
+                             metavar =   "",
+                             help    =   "The output data file, next to --runs")
+
+        control.add_argument("--save",
+                             dest    =   "save",
+                             action  =   "store_true",
+                             default =   False,
+                             help    =   "Copy the session into --history as a dated performance_runs csv when nothing regressed")
+
+        cmd_args = parser.parse_args()
+
+        return cmd_args
+
+def model_key(name):
+    """
+    Model of a testcase folder name, without the compile uuid that changes between DFP builds.
+    """
+    return re.sub(r'_uuid_[0-9a-fA-F-]+$', '', str(name).strip())
+
+def history_meta(path):
+    """
+    'format', 'platform' ('any' if not in the name) and 'date' of a history csv name, None if not one.
+    """
+    stem = Path(path).stem
+    prefix = next((p for p in HISTORY_PREFIXES if stem.startswith(p)), None)
+    if prefix is None:
+        return None
+    rest = '_' + stem[len(prefix):]
+    date = ''
+    for pattern in DATE_PATTERNS:
+        m = re.search(pattern, rest)
+        if m:
+            date = m.group(1)
+            rest = rest[:m.start()] + rest[m.end():]
+            break
+    tokens = [t for t in rest.split('_') if t]
+    plat = next((t for t in tokens if t in PLATFORMS), 'any')
+    return {'format': '_'.join(t for t in tokens if t != plat) or 'any', 'platform': plat, 'date': date}
+
+def load_results(path):
+    """
+    One row per model and run of a result csv: 'model', 'fps', 'p50', 'p99' (NaN
+    if the file has no latency). Failed runs and -1 / NaN FPS are left out.
+    """
+    df = pd.read_csv(str(path), skipinitialspace=True)
+    cols = {c.strip().lower(): c for c in df.columns}
+    if 'model' not in cols or 'fps' not in cols:
+        return pd.DataFrame(columns=['model', 'fps', 'p50', 'p99'])
+    out = pd.DataFrame({'model': df[cols['model']].map(model_key),
+                        'fps': pd.to_numeric(df[cols['fps']], errors='coerce')})
+    for name, col in (('p50', 'p50_ms'), ('p99', 'p99_ms')):
+        out[name] = pd.to_numeric(df[cols[col]], errors='coerce') if col in cols else np.nan
+    keep = out['fps'] > 0
+    if 'result' in cols:
+        keep &= df[cols['result']].astype(str).str.strip().str.upper() == 'PASS'
+    return out[keep].reset_index(drop=True)
+
+def load_history(history_dir, plat, fmt=None):
+    """
+    Results of the history csvs of `plat` (or of no platform) whose format matches
+    the `fmt` regex, with their 'file' and 'date'. Raises if `fmt` is None and the
+    history has several formats, their FPS are not comparable.
+    """
+    files = []
+    for path in sorted(glob.glob(str(Path(history_dir, '*.csv')))):
+        meta = history_meta(path)
+        if meta is None or meta['platform'] not in (plat, 'any'):
+            continue
+        if fmt is not None and not re.search(fmt, meta['format']):
+            continue
+        files.append((path, meta))
+
+    formats = sorted(set(m['format'] for _, m in files))
+    if fmt is None and len(formats) > 1:
+        raise ValueError('history has formats {}, pick the one of the session with --format'.format(', '.join(formats)))
+
+    frames = []
+    for path, meta in files:
+        df = load_results(path)
+        df['file'], df['date'] = Path(path).name, meta['date']
+        frames.append(df)
+    if not frames:
+        return pd.DataFrame(columns=['model', 'fps', 'p50', 'p99', 'file', 'date'])
+    return pd.concat(frames, ignore_index=True)
+
+def t_quantile(p, dof):
+    """
+    Student t quantile: exact for 1 and 2 dof, Cornish-Fisher expansion around the
+    normal quantile above (within 0.1% from 3 dof).
+    """
+    if dof is None or math.isinf(dof):
+        return NormalDist().inv_cdf(p)
+    if dof <= 1:
+        return math.tan(math.pi * (p - 0.5))
+    if dof <= 2:
+        return (2 * p - 1) / math.sqrt(2 * p * (1 - p))
+    z = NormalDist().inv_cdf(p)
+    g = ((z**3 + z) / 4,
+         (5*z**5 + 16*z**3 + 3*z) / 96,
+         (3*z**7 + 19*z**5 + 17*z**3 - 15*z) / 384,
+         (79*z**9 + 776*z**7 + 1482*z**5 - 1920*z**3 - 945*z) / 92160)
+    return z + sum(gi / dof**(i + 1) for i, gi in enumerate(g))
+
+def pooled_cv(groups):
+    """
+    Relative spread (std / mean) pooled over the models with 2+ samples, weighted
+    by their degrees of freedom, and those degrees of freedom. (None, 0) if no
+    model has 2 samples.
+    """
+    num, dof = 0.0, 0
+    for values in groups:
+        values = np.asarray(values, dtype=np.float64)
+        if values.size < 2 or values.mean() <= 0:
+            continue
+        num += (values.size - 1) * values.var(ddof=1) / values.mean()**2
+        dof += values.size - 1
+    if dof == 0:
+        return None, 0
+    return math.sqrt(num / dof), dof
+
+def _spread(values, cv, cv_dof):
+    """
+    Variance and its degrees of freedom of one side of a comparison, floored by the pooled spread.
+    """
+    mean = float(np.mean(values))
+    var = float(np.var(values, ddof=1)) if len(values) > 1 else 0.0
+    floor = (cv * mean)**2 if cv is not None else 0.0
+    if var >= floor and len(values) > 1:
+        return var, len(values) - 1
+    return floor, cv_dof
+
+def compare(session, history, higher_better=True, alpha=0.05, min_effect=2.0, cv=None, cv_dof=0):
+    """
+    Change of the session mean from the history mean of one model and metric.
+
+    Returns
+    -------
+    row : dict
+        'runs', 'mean' and its (1 - alpha) 'ci_low' / 'ci_high', 'hist_runs',
+        'hist_mean', 'hist_std', 'change' (%) and its 'change_low' /
+        'change_high' (%), and 'status': 'REGRESS' / 'IMPROVE' when the change
+        interval is clear of 0 the bad / good way and the change is at least
+        `min_effect` %, 'OK' otherwise, 'NEW' without history and 'NOISE'
+        when the spread is unknown (single samples, nothing to pool).
+    """
+    x, h = np.asarray(session, dtype=np.float64), np.asarray(history, dtype=np.float64)
+    row = {'runs': x.size, 'mean': float(x.mean()), 'ci_low': np.nan, 'ci_high': np.nan,
+           'hist_runs': h.size, 'hist_mean': np.nan, 'hist_std': np.nan,
+           'change': np.nan, 'change_low': np.nan, 'change_high': np.nan, 'status': 'NEW'}
+    var_x, dof_x = _spread(x, cv, cv_dof)
+    if var_x > 0 and dof_x > 0:
+        half = t_quantile(1 - alpha / 2, dof_x) * math.sqrt(var_x / x.size)
+        row['ci_low'], row['ci_high'] = row['mean'] - half, row['mean'] + half
+    if h.size == 0:
+        return row
+
+    row['hist_mean'] = float(h.mean())
+    row['hist_std'] = float(h.std(ddof=1)) if h.size > 1 else np.nan
+    row['change'] = (row['mean'] / row['hist_mean'] - 1) * 100
+    var_h, dof_h = _spread(h, cv, cv_dof)
+    se2_x, se2_h = var_x / x.size, var_h / h.size
+    if se2_x + se2_h <= 0 or dof_x <= 0 or dof_h <= 0:
+        row['status'] = 'NOISE'
+        return row
+
+    # Welch-Satterthwaite degrees of freedom
+    dof = (se2_x + se2_h)**2 / (se2_x**2 / dof_x + se2_h**2 / dof_h)
+    half = t_quantile(1 - alpha / 2, dof) * math.sqrt(se2_x + se2_h)
+    diff = row['mean'] - row['hist_mean']
+    row['change_low'] = (diff - half) / row['hist_mean'] * 100
+    row['change_high'] = (diff + half) / row['hist_mean'] * 100
+
+    worse = row['change_high'] < 0 if higher_better else row['change_low'] > 0
+    better = row['change_low'] > 0 if higher_better else row['change_high'] < 0
+    if worse and abs(row['change']) >= min_effect:
+        row['status'] = 'REGRESS'
+    elif better and abs(row['change']) >= min_effect:
+        row['status'] = 'IMPROVE'
+    else:
+        row['status'] = 'OK'
+    return row
+
+def gate(session, history, alpha=0.05, min_effect=2.0):
+    """
+    `compare()` rows of every model of the `load_results()` session against the
+    `load_history()` results, one per metric both sides have, with 'model' and 'metric'.
+    """
+    rows = []
+    for metric, (col, higher_better) in METRICS.items():
+        hist = history.dropna(subset=[col])
+        cv, cv_dof = pooled_cv([g[col].values for _, g in hist.groupby('model')])
+        if cv is None:
+            cv, cv_dof = pooled_cv([g[col].values for _, g in session.dropna(subset=[col]).groupby('model')])
+        for model, runs in session.dropna(subset=[col]).groupby('model', sort=True):
+            past = hist[hist['model'] == model][col].values
+            if metric != 'FPS' and past.size == 0:
+                continue
+            row = compare(runs[col].values, past, higher_better, alpha, min_effect, cv, cv_dof)
+            row.update({'model': model, 'metric': metric})
+            rows.append(row)
+    return rows
+
+GATE_COLS = ['model', 'metric', 'status', 'runs', 'mean', 'ci_low', 'ci_high', 'hist_runs', 'hist_mean', 'hist_std',
+             'change', 'change_low', 'change_high']
+
+def gate_results(runs_file, history_dir, plat=None, fmt=None, alpha=0.05, min_effect=2.0,
+                 result_file='performance_gate.csv', save=False, verbose=0):
+    """
+    Gates a session csv against the history, prints and writes the rows next to
+    the session csv. Returns the number of regressions.
+    """
+    plat = plat or platform.system().lower()
+    session = load_results(runs_file)
+    history = load_history(history_dir, plat, fmt)
+    print('{}: Gating {} models ({} runs) against {} results of {} files ({}, {})'.format(time.strftime("%m-%d %H:%M:%S"),
+          session['model'].nunique(), len(session), len(history), history['file'].nunique() if len(history) else 0,
+          plat, fmt or 'any format'))
+
+    rows = gate(session, history, alpha, min_effect)
+    fmt_num = lambda v: '' if (v is None or (isinstance(v, float) and math.isnan(v))) else ('{:.3f}'.format(v) if isinstance(v, float) else str(v))
+    result_path = Path(Path(runs_file).parent, result_file)
+    with open(str(result_path), 'w') as f:
+        f.write(','.join(c.title().replace('_', ' ') for c in GATE_COLS) + '\n')
+        for r in rows:
+            f.write(','.join(fmt_num(r[c]) for c in GATE_COLS) + '\n')
+
+    for r in rows:
+        if verbose or r['status'] in ('REGRESS', 'IMPROVE'):
+            print('{0:64s} {1:6s} {2:7s} {3:10.3f} [{4}, {5}] vs {6} x {7:10.3f}: {8:+7.2f}% [{9:+.2f}%, {10:+.2f}%]'.format(
+                  r['model'][:64], r['metric'], r['status'], r['mean'], fmt_num(r['ci_low']), fmt_num(r['ci_high']),
+                  r['hist_runs'], r['hist_mean'], r['change'], r['change_low'], r['change_high']))
+    counts = {s: sum(1 for r in rows if r['status'] == s) for s in ('REGRESS', 'IMPROVE', 'OK', 'NEW', 'NOISE')}
+    print('    ' + ', '.join('{} {}'.format(k, v) for k, v in counts.items()) + ' -> {}'.format(result_path))
+
+    if save and counts['REGRESS'] == 0:
+        history_file = Path(history_dir, 'performance_runs_{}_{}_{}.csv'.format(re.sub(r'\W', '', fmt or 'any'), plat, time.strftime("%Y%m%d_%H%M")))
+        shutil.copy(str(runs_file), str(history_file))
+        print('    saved as {}'.format(history_file))
+    return counts['REGRESS']
+
+if __name__=="__main__":
+    cmd_arg = __parse()
+    try:
+        regressions = gate_results(cmd_arg.runs_file, cmd_arg.history_dir, cmd_arg.platform, cmd_arg.format, cmd_arg.alpha,
+                                   cmd_arg.min_effect, cmd_arg.result_file, cmd_arg.save, cmd_arg.verbose)
+    except ValueError as e:
+        print(e)
+        sys.exit(2)
+    sys.exit(1 if regressions else 0)
@@ -0,0 +1,203 @@
+"""
+Timeline of a traced Benchmark run as a Chrome Trace Event file.
+
+`Benchmark.run(trace=True)` records the enter / exit of every stream_ifmap /
+stream_ofmap call of its sender and receiver threads and the frame conversion
+inside it. `KernelTrace` captures the driver tracepoints (memx_pcie / memx_usb
+events, one start / done pair per ifmap write and ofmap read) of the same run
+through tracefs. Both are CLOCK_MONOTONIC, and `write_chrome_trace()` merges
+them into one JSON file for chrome://tracing or ui.perfetto.dev, where a
+driver transfer nests under the stream call that made it and queueing gaps
+show up as holes between the slices.
+"""
+import os, re, json
+from pathlib import Path
+
+TRACEFS = ('/sys/kernel/tracing', '/sys/kernel/debug/tracing')
+TRACE_SYSTEMS = ('memx_pcie', 'memx_usb')
+
+# "python3-1234    (   1200) [002] ..... 51.000123: memx_write_start: memx0 id=-1 size=4096 ret=0", tgid optional
+_LINE = re.compile(r'^\s*(.+?)-(\d+)\s+(?:\(\s*(\d+|-+)\)\s+)?\[(\d+)\]\s+\S*\s*(\d+\.\d+):\s+memx_(write|read)_(start|done):'
+                   r'\s+memx(\d+) id=(-?\d+) size=(\d+) ret=(-?\d+)')
+
+class KernelTrace:
+    """
+    Captures the driver tracepoints while in the `with` block. Needs root, a
+    mounted tracefs and a driver built with memx_trace.h, otherwise `error`
+    says why and `events` stays empty. The trace clock is switched to 'mono'
+    for the capture and restored after.
+
+    `events` then holds one dict per transfer: 'op' ('write' / 'read'),
+    'minor' (memx<minor>), 'id', 'size', 'ret', 'tid' / 'pid' / 'comm' of the
+    calling thread, 'cpu' and 'start' / 'end' ns.
+    """
+    def __init__(self, buffer_kb=16384):
+        self.buffer_kb = buffer_kb
+        self.root = next((Path(r) for r in TRACEFS if Path(r, 'trace').is_file()), None)
+        self.systems = [s for s in TRACE_SYSTEMS if self.root and Path(self.root, 'events', s).is_dir()]
+        self.events = []
+        self.error = None
+        self.__saved = {}
+
+    def __write(self, name, value):
+        with open(str(Path(self.root, name)), 'w') as f:
+            f.write(str(value))
+
+    def __read(self, name):
+        with open(str(Path(self.root, name)), 'r') as f:
+            return f.read()
+
+    def __enter__(self):
+        if not self.systems:
+            self.error = 'no tracefs' if self.root is None else 'no {} events, driver without tracepoints'.format('/'.join(TRACE_SYSTEMS))
+            return self
+        try:
+            # e.g. "[local] global counter uptime perf mono ..."
+            self.__saved['trace_clock'] = re.search(r'\[(\S+)\]', self.__read('trace_clock')).group(1)
+            self.__saved['tracing_on'] = self.__read('tracing_on').strip()
+            self.__write('tracing_on', 0)
+            self.__write('trace_clock', 'mono')
+            self.__write('buffer_size_kb', self.buffer_kb)
+            if Path(self.root, 'options/record-tgid').is_file():
+                self.__saved['options/record-tgid'] = self.__read('options/record-tgid').strip()
+                self.__write('options/record-tgid', 1)
+            self.__write('trace', '')
+            for s in self.systems:
+                self.__write('events/{}/enable'.format(s), 1)
+            self.__write('tracing_on', 1)
+        except (OSError, AttributeError) as e:
+            self.error = str(e)
+            self.__restore()
+            self.systems = []
+        return self
+
+    def __exit__(self, type, value, traceback):
+        if self.systems:
+            try:
+                self.__write('tracing_on', 0)
+                self.events = parse_trace(self.__read('trace'))
+            except OSError as e:
+                self.error = str(e)
+            self.__restore()
+        return False
+
+    def __restore(self):
+        for s in self.systems:
+            try:
+                self.__write('events/{}/enable'.format(s), 0)
+            except OSError:
+                pass
+        for name, value in self.__saved.items():
+            try:
+                self.__write(name, value)
+            except OSError:
+                pass
+
+def parse_trace(text):
+    """
+    Driver transfers of a tracefs `trace` dump, each start paired with the next
+    done of the same thread and direction. Unpaired events (buffer overrun, abort
+    paths) are dropped.
+    """
+    events, open_xfer = [], {}
+    for line in text.split('\n'):
+        m = _LINE.match(line)
+        if not m:
+            continue
+        comm, tid, tgid, cpu, ts, op, edge, minor, xid, size, ret = m.groups()
+        key = (int(tid), op)
+        ns = int(round(float(ts) * 1e9))
+        if edge == 'start':
+            open_xfer[key] = ns
+            continue
+        if key not in open_xfer:
+            continue
+        events.append({'op': op, 'minor': int(minor), 'id': int(xid), 'size': int(size), 'ret': int(ret),
+                       'tid': int(tid), 'pid': int(tgid) if tgid and tgid.isdigit() else None, 'comm': comm,
+                       'cpu': int(cpu), 'start': open_xfer.pop(key), 'end': ns})
+    return events
+
+def frames_in_flight(host):
+    """
+    (ns, frames) steps of the frames sent on port 0 and not yet received on all
+    output ports, from the host events of a traced run.
+    """
+    sent, received = {}, {}
+    for name, tid, port, frame, start, end in host:
+        if name == 'stream_ifmap' and port == 0:
+            sent[frame] = end
+        elif name == 'stream_ofmap':
+            received[frame] = max(received.get(frame, 0), end)
+    changes = sorted([(t, 1) for t in sent.values()] + [(t, -1) for f, t in received.items() if f in sent])
+    steps, n = [], 0
+    for t, d in changes:
+        n += d
+        steps.append((t, n))
+    return steps
+
+def chrome_trace(host, threads=None, kernel=(), name='benchmark'):
+    """
+    Chrome Trace Event dict of a traced run.
+
+    Parameters
+    ----------
+    host : list of tuple
+        `Benchmark.trace_events`.
+
+    threads : dict
+        `Benchmark.trace_threads`, thread id to the role shown as its row name.
+
+    kernel : list of dict
+        `KernelTrace.events` of the run, shown on the rows of their threads;
+        transfers of other processes get rows of their own process.
+
+    name : str
+        Process name of the run (e.g. the model).
+
+    Times are us from the first event, its CLOCK_MONOTONIC ns is kept in
+    'otherData'.
+    """
+    pid = os.getpid()
+    threads = threads or {}
+    t0 = min([e[4] for e in host] + [k['start'] for k in kernel] or [0])
+    us = lambda ns: (ns - t0) / 1e3
+
+    events = [{'name': 'process_name', 'ph': 'M', 'pid': pid, 'args': {'name': name}}]
+    events += [{'name': 'thread_name', 'ph': 'M', 'pid': pid, 'tid': tid, 'args': {'name': role}} for tid, role in threads.items()]
+
+    last_port = {}
+    for ev_name, tid, port, frame, start, end in host:
+        events.append({'name': ev_name if ev_name == 'convert' else '{} {}'.format(ev_name, port), 'cat': 'host', 'ph': 'X',
+                       'ts': us(start), 'dur': (end - start) / 1e3, 'pid': pid, 'tid': tid, 'args': {'port': port, 'frame': frame}})
+        if ev_name == 'stream_ofmap' and end >= last_port.get(frame, (0, 0, 0))[0]:
+            last_port[frame] = (end, tid, start)
+
+    # frame flow: send call of port 0 to the receive call completing the frame
+    for ev_name, tid, port, frame, start, end in host:
+        if ev_name == 'stream_ifmap' and port == 0 and frame in last_port:
+            _, recv_tid, recv_start = last_port[frame]
+            events.append({'name': 'frame', 'cat': 'frame', 'ph': 's', 'id': frame, 'ts': us(start), 'pid': pid, 'tid': tid})
+            events.append({'name': 'frame', 'cat': 'frame', 'ph': 'f', 'bp': 'e', 'id': frame, 'ts': us(recv_start), 'pid': pid, 'tid': recv_tid})
+
+    for t, n in frames_in_flight(host):
+        events.append({'name': 'frames in flight', 'ph': 'C', 'ts': us(t), 'pid': pid, 'args': {'frames': n}})
+
+    named = set(threads)
+    for k in kernel:
+        kpid = k['pid'] if k['pid'] is not None else pid
+        if k['tid'] not in named:
+            events.append({'name': 'thread_name', 'ph': 'M', 'pid': kpid, 'tid': k['tid'], 'args': {'name': k['comm']}})
+            named.add(k['tid'])
+        events.append({'name': 'kdrv_{} memx{}'.format(k['op'], k['minor']), 'cat': 'kernel', 'ph': 'X',
+                       'ts': us(k['start']), 'dur': (k['end'] - k['start']) / 1e3, 'pid': kpid, 'tid': k['tid'],
+                       'args': {'id': k['id'], 'size': k['size'], 'ret': k['ret'], 'cpu': k['cpu']}})
+
+    return {'traceEvents': events, 'displayTimeUnit': 'ms', 'otherData': {'t0_monotonic_ns': t0}}
+
+def write_chrome_trace(path, host, threads=None, kernel=(), name='benchmark'):
+    """
+    Writes `chrome_trace()` of a traced run to `path` (.json).
+    """
+    with open(str(path), 'w') as f:
+        json.dump(chrome_trace(host, threads, kernel, name), f)
+    return path
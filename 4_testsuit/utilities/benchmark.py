@@ -1,9 +1,18 @@
 import numpy as np
+import os, json, hashlib
 from pathlib import Path
 from threading import Thread, Lock
+try:
+    from threading import get_native_id
+except ImportError: # python < 3.8, timeline thread rows then do not match the kernel ones
+    from threading import get_ident as get_native_id
 from utilities.dfp_inspect import dfp_inspect
 import mxa # mxa driver
 import time
+try:
+    import resource
+except ImportError: # not on Windows, host cost accounting is off there
+    resource = None
 
 class Benchmark:
     """MemryX Benchmark.
@@ -21,6 +30,37 @@ class Benchmark:
         dfp : string or bytearray
             Path to dfp or a dfp object (bytearray)
 
+        fps : float
+            Offered load of threaded runs in frames per second. '0' sends
+            frames back to back (closed loop), otherwise frames are sent open
+            loop at their scheduled arrival times, whether or not the
+            accelerator keeps up.
+
+        arrival : string
+            Arrival process of open loop runs: 'constant' (fixed interval),
+            'poisson' (exponential intervals) or 'burst' (groups of
+            `burst_size` frames back to back, same average rate).
+
+        burst_size : int
+            Frames per burst for `arrival='burst'`.
+
+        queue_size : int
+            Driver ifmap / ofmap queue depth (frames).
+
+        threads : string
+            Thread layout of threaded runs: 'shared' (one sender thread for
+            all input ports, one receiver for all output ports) or 'port'
+            (one sender / receiver thread per port).
+
+        batch : int
+            Frames per driver call of a thread that streams a single port.
+
+        profile : string
+            Tuning profile to take `queue_size`, `threads` and `batch` from
+            when not given: 'throughput' or 'latency' configuration of the
+            model's `tune()` profile (`<model>.tune.json` next to the DFP),
+            None for the defaults. Ignored if the DFP changed since tuning.
+
     Examples
     --------
     .. code-block:: python
@@ -36,7 +76,9 @@ class Benchmark:
 
 ###############################################################################
     #@initializer
-    def __init__(self, verbose=0, fps=0, dfp="model.dfp", group=0, model=0, chip_gen=3.1, **kwargs):
+    def __init__(self, verbose=0, fps=0, dfp="model.dfp", group=0, model=0, chip_gen=3.1,
+                 arrival="constant", burst_size=8, seed=0, queue_size=None, threads=None, batch=None,
+                 profile="throughput", **kwargs):
         if not mxa:
             raise Exception("driver package not installed! Please install the .deb/.rpm/.tgz and try again")
 
@@ -60,7 +102,22 @@ class Benchmark:
         self.output_ports= {}
 
         self.fps = fps
+        if arrival not in ARRIVALS:
+            raise ValueError(f"arrival must be one of {ARRIVALS}")
+        self.arrival = arrival
+        self.burst_size = max(int(burst_size), 1)
+        self.seed = seed
         self.latency = None
+        self.latency_stats = None
+        self.frame_latency = None
+        self.host_cost = None
+        self.trace_events = None
+        self.trace_threads = None
+        # Tuning, explicit args over the model profile over the defaults
+        self.profile = profile
+        self.queue_size, self.threads, self.batch = queue_size, threads, batch
+        # (step, time.monotonic_ns() at its end) of the last driver init, 'start' first
+        self.init_times = []
 
         # dfp as bytes need to be saved to a tempfile, since the driver
         # currently requires download_model to use file args
@@ -70,6 +127,7 @@ class Benchmark:
         self.mxa_io_lock = Lock()
         self.outstanding_frames = 0
         self.frame_start_time, self.frame_stop_time = [],[]
+        self.record_latency = True
 
         # Parse DFP
         self.__parse_dfp()
@@ -79,6 +137,8 @@ class Benchmark:
         elif self.gen == "Cascade":
             self.chip_gen = 3
 
+        self.__apply_tuning()
+
         # Hpoc
         hpoc_fname = kwargs.get('hpoc_fname', None)
         # self.__do_hpoc = bool(hpoc_fname)
@@ -202,21 +262,50 @@ class Benchmark:
                 'num_inports', 'num_outports', 'input_ports', 'output_ports']:
             setattr(self, attr_name, getattr(self._sys_info, attr_name))
 
+###############################################################################
+    def __apply_tuning(self):
+        """
+        Resolve queue size, thread layout and batch of unset args from the
+        tuning profile, then the defaults
+        """
+        tuned = None
+        if self.profile and not self.is_tempfile:
+            if self.profile not in ("throughput", "latency"):
+                raise ValueError("profile must be 'throughput', 'latency' or None")
+            tuned = load_profile(self.dfp, self.profile)
+        self.tuning = "profile" if tuned else "default"
+
+        for key, default in DEFAULT_TUNING.items():
+            if getattr(self, key) is None:
+                setattr(self, key, tuned[key] if tuned else default)
+        if self.threads not in THREAD_LAYOUTS:
+            raise ValueError(f"threads must be one of {THREAD_LAYOUTS}")
+        self.queue_size = max(int(self.queue_size), 1)
+        self.batch = max(int(self.batch), 1)
+
 ##  Driver  ###################################################################
+    def __init_step(self, step):
+        self.init_times.append((step, time.monotonic_ns()))
+
     def __init_driver(self):
+        self.init_times = []
+        self.__init_step('start')
         # Open mxa
         mxa.lock(self.group)
+        self.__init_step('lock')
         err = mxa.open(self.model, self.group, self.chip_gen)
         if err:
             raise Exception("Failed to open MXA")
+        self.__init_step('open')
 
         # increase queue sizes
-        err = mxa.set_ifmap_queue_size(self.model, 10)
+        err = mxa.set_ifmap_queue_size(self.model, self.queue_size)
         if err:
             raise Exception("Failed to set ifmap queue size")
-        err = mxa.set_ofmap_queue_size(self.model, 10)
+        err = mxa.set_ofmap_queue_size(self.model, self.queue_size)
         if err:
             raise Exception("Failed to set ofmap queue size")
+        self.__init_step('queue_size')
 
         hw_mpus = mxa.chip_count(self.group)
         dfp_mpus = self._sys_info.mpus
@@ -243,15 +332,17 @@ class Benchmark:
                 raise Exception(f"Input DFP was compiled for {dfp_mpus} chips, but the connected accelerator has {hw_mpus} chips")
         else:
             raise Exception(f"Unsupport generation {self.gen} chips")
-
+        self.__init_step('config_mpu_group')
 
         # Download the dfp
         err = mxa.download(self.model, self.dfp, 0, 3)
         if err:
             raise Exception("Failed to download DFP to mxa!")
+        self.__init_step('download')
 
         # start the driver workers
         mxa.set_stream_enable(self.model, 0)
+        self.__init_step('stream_enable')
 
 ###############################################################################
     def __close(self):
@@ -259,7 +350,7 @@ class Benchmark:
         time.sleep(0.01)
 
 ###############################################################################
-    def run(self, inputs=None, frames=100, threading=True):
+    def run(self, inputs=None, frames=100, threading=True, record_latency=True, record_cost=True, trace=False):
         """ Run inference on the benchmark.
 
         Perform inference using the configured DFP on the connected MXA with the given inputs or random data if no
@@ -280,12 +371,29 @@ class Benchmark:
         threading : bool
             Use threading to send / recieve frame. This will allow frames to be
             pipelined on the accelerator which enables higher FPS. Otherwise a
-            blocking scheme to send / receive frames will be used.
-
-            .. note::
-
-                You must use `threading=False` in order to measure latency. On the other
-                hand, use `threading=True` to get the best FPS.
+            blocking scheme to send / receive frames will be used. Threads are
+            laid out as set by `threads` and stream `batch` frames per call.
+
+        record_latency : bool
+            With `threading=True`, timestamp every frame as it is sent and
+            received and report the pipelined latency (see `latency_stats`),
+            frames of a batch sharing the stamps of its call. Set to False to
+            let each single port thread stream the whole run in one batch call
+            for the last bit of FPS (latency is then -1).
+
+        record_cost : bool
+            With `threading=True`, account the host CPU spent on the run per
+            frame in `host_cost` (see `host_cost_summary()`). Reads and
+            clears the driver throughput counters when they are exposed.
+
+        trace : bool
+            With `threading=True`, record the enter / exit of every stream
+            call and the frame conversion inside it in `trace_events`, as
+            (name, thread id, port, frame, start ns, end ns) on the
+            CLOCK_MONOTONIC (`time.monotonic_ns()`) time line of the driver
+            tracepoints, and the role of each thread id in `trace_threads`
+            (see `tool.timeline`). Frames are streamed one per call while
+            tracing.
 
         Returns
         -------
@@ -298,19 +406,22 @@ class Benchmark:
 
             .. note::
 
-                The latency is timed from the moment the first data of the
-                input is consumed until the last data of the output produced.
+                With `threading=False` the latency (ms) is the run time divided
+                by the number of frames, one frame in flight at a time. With
+                `threading=True` it is the mean latency (ms) of the frames under
+                pipelined load, each timed from its send call on the first input
+                port to the return of its receive call on the last output port,
+                matched by sequence number. Percentiles and a histogram of it are
+                kept in `latency_stats` (see `latency_summary()`), the raw
+                per-frame values in `frame_latency`.
                 The FPS is calculated as the time between output frames.
 
-            .. note::
-
-                You must use `threading=False` in order to measure latency. On the other
-                hand, use `threading=True` to get the best FPS.
-
         Raises
         ------
         ValueError :
             When the input is incorrectly configured.
+        Exception :
+            The first error of a sender / receiver thread of a threaded run.
 
         Examples
         --------
@@ -323,6 +434,10 @@ class Benchmark:
                 # single frame, get latency
                 outputs,latency,_ = accl.run(threading=False)
 
+                # latency under load
+                _,latency,_ = accl.run(frames=1000)
+                print(accl.latency_stats['p99'])
+
                 # four frames of a numpy array's data (assume 224x224x3 model input)
                 inputs = np.zeros([4,224,224,3])
                 outputs,latency,fps = accl.run(inputs=inputs)
@@ -381,20 +496,61 @@ class Benchmark:
 
 
         # Run inference
+        self.latency_stats = None
+        self.frame_latency = None
+        self.host_cost = None
+        self.trace_events = None
+        self.trace_threads = None
+        self.record_latency = record_latency
+        self.__trace = trace
         if threading:
-            if (self.fps > 0):
-                threads = [Thread(target=self.__send_fps, args=(ifmaps,frames,), daemon=True),
-                    Thread(target=self.__receive, args=(ofmaps,frames,), daemon=True)]
+            # ports served by each sender / receiver thread
+            if self.threads == "port":
+                send_ports = [[p] for p in range(len(ifmaps))]
+                recv_ports = [[p] for p in range(len(ofmaps))]
             else:
-                threads = [Thread(target=self.__send, args=(ifmaps,frames,), daemon=True),
-                    Thread(target=self.__receive, args=(ofmaps,frames,), daemon=True)]
+                send_ports = [list(range(len(ifmaps)))]
+                recv_ports = [list(range(len(ofmaps)))]
+
+            # per-frame perf_counter_ns() stamps, written by the sender of port 0 / each receiver thread
+            self.__send_ts = np.zeros(frames, dtype=np.int64)
+            self.__recv_ts = np.zeros([len(recv_ports), frames], dtype=np.int64)
+            schedule = arrival_schedule(frames, self.fps, self.arrival, self.burst_size, self.seed) if (self.fps > 0) else None
+            threads = [Thread(target=self.__accounted, args=('send',self.__send,(ifmaps,ports,frames,schedule,),), daemon=True)
+                       for ports in send_ports]
+            threads += [Thread(target=self.__accounted, args=('receive',self.__receive,(ofmaps,ports,frames,self.__recv_ts[i],),), daemon=True)
+                        for i,ports in enumerate(recv_ports)]
+            self.__record_cost = record_cost and (resource is not None)
+            self.__thread_cost = []
+            self.__thread_errors = []
+            if trace:
+                self.__trace_events, self.__trace_threads = [], {}
+            if self.__record_cost:
+                driver_throughput(self.group)
+                process = cpu_usage('process')
             start = time.time()
             [t.start() for t in threads]
-            [t.join() for t in threads]
+            # a failed sender leaves the receivers blocked on frames that never come, stop waiting on the first error
+            for t in threads:
+                while t.is_alive() and not self.__thread_errors:
+                    t.join(0.1)
+            if self.__thread_errors:
+                raise self.__thread_errors[0]
             dt = time.time() - start
+            if self.__record_cost:
+                self.host_cost = host_cost_summary(usage_delta(process, cpu_usage('process')), self.__thread_cost,
+                                                   frames, driver_throughput(self.group))
+            if trace:
+                self.trace_events = sorted(self.__trace_events, key=lambda e: e[4])
+                self.trace_threads = self.__trace_threads
 
             latency = -1
             fps = frames / dt
+            if record_latency:
+                # a frame is received once its last port is
+                self.frame_latency = (self.__recv_ts.max(axis=0) - self.__send_ts) / 1e6
+                self.latency_stats = latency_summary(self.frame_latency)
+                latency = self.latency_stats['mean']
         else:
             # Completely blocking
             start = time.time()
@@ -431,56 +587,306 @@ class Benchmark:
             return None, latency, fps
         return ofmaps.copy(), latency, fps
 
-    # threaded sender
-    def __send(self, ifmaps, frames):
-        frame_num = 0
-        while frame_num < frames:
-            for p,ifmap in enumerate(ifmaps):
-                if (self.input_ports[p]['data_range_enabled'] == 0) and (self.input_ports[p]['data_type'].lower() in ['uint8', 'rgb565', 'yuv422', 'yuy2']):
-                    err = mxa.stream_ifmap(self.model, p, ifmap[self.__get_frame_idx(frame_num)].astype(np.uint8))
-                else:
-                    err = mxa.stream_ifmap(self.model, p, ifmap[self.__get_frame_idx(frame_num)].astype(np.float32))
-                if err:
-                    raise Exception('stream_ifmap err', err)
+    def sweep(self, rates, inputs=None, frames=1000):
+        """ Sweep the offered load of open loop runs.
 
-            frame_num += 1
+        Parameters
+        ----------
+        rates : list of float
+            Offered loads (FPS) to run, using the configured `arrival` process.
 
-    # threaded sender
-    def __send_fps(self, ifmaps, frames):
-        frame_num = 0
-        time_end = 0
-        time_start = time.time()
-        latency = 1000 / self.fps #ms
+        inputs, frames :
+            As in `run()`, for every load point.
 
-        while frame_num < frames:
-            for p,ifmap in enumerate(ifmaps):
-                if (self.input_ports[p]['data_range_enabled'] == 0) and (self.input_ports[p]['data_type'].lower() in ['uint8', 'rgb565', 'yuv422', 'yuy2']):
-                    err = mxa.stream_ifmap(self.model, p, ifmap[self.__get_frame_idx(frame_num)].astype(np.uint8))
-                else:
-                    err = mxa.stream_ifmap(self.model, p, ifmap[self.__get_frame_idx(frame_num)].astype(np.float32))
+        Returns
+        -------
+        points, knee : list of dict, dict
+            One dict per load point with 'offered_fps', 'fps' and the
+            `latency_stats` percentiles (ms), and the saturation knee
+            (see `saturation_knee()`), None if even the lowest load saturates.
+        """
+        closed_loop_fps = self.fps
+        points = []
+        try:
+            for rate in rates:
+                self.fps = rate
+                _, _, fps = self.run(inputs=inputs, frames=frames, threading=True)
+                point = {'offered_fps': float(rate), 'fps': fps}
+                point.update({k: v for k, v in self.latency_stats.items() if k != 'histogram'})
+                points.append(point)
+        finally:
+            self.fps = closed_loop_fps
+        return points, saturation_knee(points)
+
+    # threaded sender of `ports`; open loop with a `schedule`: each frame goes
+    # out at its scheduled arrival time and is timed from it, so a backed up
+    # accelerator shows as latency instead of silently lowering the offered load
+    def __send(self, ifmaps, ports, frames, schedule=None):
+        batch = self.__thread_batch(ports, frames, schedule)
+        if batch > 1:
+            # one port, `batch` frames per call, converted once and streamed without the GIL
+            p = ports[0]
+            ifmap = ifmaps[p] if self.__u8_float_port(p, ifmaps[p]) else self.__host_ifmaps(ifmaps)[p]
+            for start in range(0, frames, batch):
+                n = min(batch, frames - start)
+                if p == 0:
+                    self.__send_ts[start:start+n] = time.perf_counter_ns()
+                chunk = ifmap if self._random_inputs else ifmap[start:start+n]
+                err, sent = mxa.stream_ifmap_batch(self.model, p, chunk, frames=n)
+                if err:
+                    raise Exception('stream_ifmap err', err, 'after', start + sent)
+            return
+
+        ifmaps = self.__host_ifmaps(ifmaps)
+        time_start = time.perf_counter_ns()
+        for frame_num in range(frames):
+            if schedule is not None:
+                stamp = time_start + int(schedule[frame_num])
+                wait_until(stamp)
+            else:
+                stamp = time.perf_counter_ns()
+            if 0 in ports:
+                self.__send_ts[frame_num] = stamp
+            for p in ports:
+                enter = time.monotonic_ns() if self.__trace else 0
+                err = mxa.stream_ifmap(self.model, p, ifmaps[p][self.__get_frame_idx(frame_num)])
+                if self.__trace:
+                    self.__trace_call('stream_ifmap', p, frame_num, enter)
                 if err:
                     raise Exception('stream_ifmap err', err)
 
-            frame_num += 1
-
-            if (frame_num < frames):
-                while ((time.time() - time_start) * 1000) < latency:
-                    pass
-                time_start = time.time()
-    # threaded receiver
-    def __receive(self, ofmaps, frames):
-        frame_num = 0
-        while frame_num < frames:
-
-            for p,ofmap in enumerate(ofmaps):
-                err = mxa.stream_ofmap(self.model, p, ofmap[self.__get_frame_idx(frame_num),...])
+    # threaded receiver of `ports`, stamping `recv_ts`
+    def __receive(self, ofmaps, ports, frames, recv_ts):
+        batch = self.__thread_batch(ports, frames)
+        if batch > 1:
+            p = ports[0]
+            for start in range(0, frames, batch):
+                n = min(batch, frames - start)
+                chunk = ofmaps[p] if self._random_inputs else ofmaps[p][start:start+n]
+                err, received = mxa.stream_ofmap_batch(self.model, p, chunk, frames=n)
+                if err:
+                    raise Exception('stream_ofmap err', err, 'after', start + received)
+                recv_ts[start:start+n] = time.perf_counter_ns()
+            return
+
+        for frame_num in range(frames):
+            for p in ports:
+                enter = time.monotonic_ns() if self.__trace else 0
+                err = mxa.stream_ofmap(self.model, p, ofmaps[p][self.__get_frame_idx(frame_num),...])
+                if self.__trace:
+                    self.__trace_call('stream_ofmap', p, frame_num, enter)
                 if err:
                     raise Exception('stream_ofmap err', err)
-            frame_num += 1
+            recv_ts[frame_num] = time.perf_counter_ns()
+
+    def __accounted(self, role, target, args):
+        """
+        Runs a sender / receiver thread body, keeping the CPU usage and stream
+        stats of the thread for `host_cost` and its role for `trace_threads`.
+        An exception of the body is kept for `run()` to raise.
+        """
+        try:
+            if self.__trace:
+                self.__trace_threads[get_native_id()] = '{} {}'.format(role, ','.join(str(p) for p in args[1]))
+            if not self.__record_cost:
+                return target(*args)
+            start = cpu_usage('thread')
+            if _stream_stats:
+                _stream_stats()
+            target(*args)
+            usage = usage_delta(start, cpu_usage('thread'))
+            usage['role'] = role
+            usage.update(_stream_stats() if _stream_stats else {'convert_ns': 0, 'driver_ns': 0})
+            self.__thread_cost.append(usage)
+        except Exception as e:
+            self.__thread_errors.append(e)
+
+    # timeline events of a stream call that entered at `enter`, with the
+    # conversion it did if any (the last one of the thread, read without reset)
+    def __trace_call(self, name, port, frame, enter):
+        end = time.monotonic_ns()
+        tid = get_native_id()
+        self.__trace_events.append((name, tid, port, frame, enter, end))
+        if _stream_stats:
+            stats = _stream_stats(0)
+            if enter <= stats['convert_start'] and stats['convert_end'] <= end:
+                self.__trace_events.append(('convert', tid, port, frame, stats['convert_start'], stats['convert_end']))
+
+    # frames per driver call of a thread: only a thread serving a single port
+    # batches, chunks of several ports in turn could stall the device on a full
+    # queue; open loop sends keep their per-frame arrival times and traced runs
+    # their per-frame events
+    def __thread_batch(self, ports, frames, schedule=None):
+        if len(ports) != 1 or schedule is not None or self.__trace:
+            return 1
+        if not self.record_latency:
+            return frames
+        return min(self.batch, frames)
+
+    # uint8 frames (e.g. camera data) on a Cascade+ float port: the driver module
+    # encodes them to GBF80/BF16 directly, no float32 copy of the frames needed
+    def __u8_float_port(self, p, ifmap):
+        return (self.gen == "Cascade+") and (ifmap.dtype == np.uint8) and \
+               (self.input_ports[p]['data_range_enabled'] == 0) and (self.input_ports[p]['data_type'].lower() in ['float'])
+
+    # ifmaps in the dtype each port streams, converted once for the whole run
+    def __host_ifmaps(self, ifmaps):
+        host = []
+        for p,ifmap in enumerate(ifmaps):
+            if (self.input_ports[p]['data_range_enabled'] == 0) and (self.input_ports[p]['data_type'].lower() in ['uint8', 'rgb565', 'yuv422', 'yuy2']):
+                host.append(np.ascontiguousarray(ifmap, dtype=np.uint8))
+            else:
+                host.append(np.ascontiguousarray(ifmap, dtype=np.float32))
+        return host
 
     def __get_frame_idx(self, idx):
         return 0 if self._random_inputs else idx
 
+ARRIVALS = ("constant", "poisson", "burst")
+THREAD_LAYOUTS = ("shared", "port")
+DEFAULT_TUNING = {'queue_size': 10, 'threads': "shared", 'batch': 1}
+TUNING_KEYS = tuple(DEFAULT_TUNING)
+
+def profile_path(dfp):
+    """
+    Tuning profile of a DFP, `<model>.tune.json` next to it.
+    """
+    return Path(dfp).with_suffix('.tune.json')
+
+def _dfp_digest(dfp):
+    h = hashlib.sha1()
+    with open(str(dfp), 'rb') as f:
+        for block in iter(lambda: f.read(1 << 20), b''):
+            h.update(block)
+    return h.hexdigest()
+
+def load_profile(dfp, objective="throughput"):
+    """
+    The tuned `queue_size`, `threads` and `batch` of a DFP for `objective`
+    ('throughput' or 'latency'), None if it has no profile or the DFP changed
+    since it was tuned.
+    """
+    path = profile_path(dfp)
+    if not path.is_file():
+        return None
+    with open(str(path), 'r') as f:
+        profile = json.load(f)
+    if profile.get('sha1') != _dfp_digest(dfp) or objective not in profile:
+        return None
+    return {k: profile[objective][k] for k in TUNING_KEYS}
+
+def tune(dfp, group=0, model=0, queue_sizes=(2, 4, 8, 16, 32), layouts=THREAD_LAYOUTS, batches=(1, 4, 16),
+         frames=1000, fps_margin=0.02, save=True, verbose=0):
+    """
+    Sweep driver queue depth, thread layout and batching of a DFP with closed
+    loop random input runs, and find the configurations with the best
+    throughput (lowest p99 of those within `fps_margin` of the highest FPS,
+    closer than that is run to run noise) and the best latency (lowest p99).
+
+    Combinations that run the same as another one are skipped: the 'port'
+    layout of a single input / single output model, and batches on a layout
+    where no thread serves a single port.
+
+    Parameters
+    ----------
+    dfp : string
+        Path to the DFP.
+
+    queue_sizes, layouts, batches : list
+        Values of `queue_size`, `threads` and `batch` to try.
+
+    frames : int
+        Frames per run.
+
+    save : bool
+        Write the result to the DFP's profile (see `profile_path()`), which
+        `Benchmark` then loads on its own.
+
+    Returns
+    -------
+    profile : dict
+        'throughput' and 'latency' configuration with their 'fps', 'p50' and
+        'p99' (ms), and all tried 'points'.
+    """
+    points = []
+    for q in queue_sizes:
+        with Benchmark(dfp=str(dfp), group=group, model=model, queue_size=q, profile=None) as accl:
+            ins = sum(1 for v in accl.input_ports.values() if v['active'])
+            outs = sum(1 for v in accl.output_ports.values() if v['active'])
+            for layout in layouts:
+                if layout == "port" and ins == 1 and outs == 1:
+                    continue
+                for batch in batches:
+                    if batch > 1 and layout == "shared" and ins > 1 and outs > 1:
+                        continue
+                    accl.threads, accl.batch = layout, batch
+                    _, _, fps = accl.run(frames=frames, threading=True)
+                    point = {'queue_size': q, 'threads': layout, 'batch': batch, 'fps': fps,
+                             'p50': accl.latency_stats['p50'], 'p99': accl.latency_stats['p99']}
+                    if verbose:
+                        print('    queue {queue_size:3d}, {threads:6s}, batch {batch:3d}: {fps:9.2f} fps, '
+                              'p50 {p50:8.3f} ms, p99 {p99:8.3f} ms'.format(**point))
+                    points.append(point)
+
+    max_fps = max(pt['fps'] for pt in points)
+    profile = {'dfp': Path(dfp).name, 'sha1': _dfp_digest(dfp), 'frames': frames,
+               'throughput': min((pt for pt in points if pt['fps'] >= (1 - fps_margin) * max_fps), key=lambda pt: pt['p99']),
+               'latency': min(points, key=lambda pt: pt['p99']),
+               'points': points}
+    if save:
+        with open(str(profile_path(dfp)), 'w') as f:
+            json.dump(profile, f, indent=2)
+    return profile
+
+def arrival_schedule(frames, fps, arrival="constant", burst_size=8, seed=0):
+    """
+    Send time of each frame in ns from the start of an open loop run, at an
+    average of `fps` frames per second (see Benchmark `arrival`).
+    """
+    period = 1e9 / fps
+    if arrival == "constant":
+        offsets = np.arange(frames) * period
+    elif arrival == "poisson":
+        # rescaled to the exact mean, so load points of a sweep differ by rate only
+        gaps = np.random.default_rng(seed).exponential(period, max(frames - 1, 1))
+        gaps *= period * gaps.size / gaps.sum()
+        offsets = np.concatenate(([0.0], np.cumsum(gaps)))[:frames]
+    elif arrival == "burst":
+        offsets = (np.arange(frames) // burst_size) * (period * burst_size)
+    else:
+        raise ValueError(f"arrival must be one of {ARRIVALS}")
+    return offsets.astype(np.int64)
+
+def wait_until(deadline_ns, spin_ns=200000):
+    """
+    Sleep until shortly before `deadline_ns` (perf_counter_ns(), monotonic) and
+    spin the rest, which keeps sleep wake-up jitter off the send times. The
+    spin yields with sleep(0) so the receiver thread is never starved of the GIL.
+    """
+    while True:
+        remaining = deadline_ns - time.perf_counter_ns()
+        if remaining <= 0:
+            return
+        time.sleep((remaining - spin_ns) / 1e9 if remaining > spin_ns else 0)
+
+def saturation_knee(points, throughput_ratio=0.95, latency_factor=2.0):
+    """
+    Highest load point of a `Benchmark.sweep()` that still keeps up: achieved
+    FPS at least `throughput_ratio` of the offered load, and median latency
+    within `latency_factor` times the median of the lightest load (the tail is
+    too noisy to call the knee on). None if no point does.
+    """
+    points = sorted(points, key=lambda pt: pt['offered_fps'])
+    if not points:
+        return None
+    base_p50 = points[0]['p50']
+    knee = None
+    for pt in points:
+        if pt['fps'] < throughput_ratio * pt['offered_fps'] or pt['p50'] > latency_factor * base_p50:
+            break
+        knee = pt
+    return knee
+
 def calculate_latency(time_points):
     time_points = np.array(sorted(time_points))
 
@@ -492,6 +898,165 @@ def calculate_latency(time_points):
 
     return np.average(filtered_time_points)
 
+def latency_summary(lat, bins=64):
+    """
+    Statistics of per-frame latencies `lat` (ms), e.g. `Benchmark.frame_latency`
+    or those of several runs concatenated.
+
+    Returns
+    -------
+    stats : dict
+        'frames', 'mean', 'min', 'max', 'p50', 'p90', 'p99', 'p99.9' in ms, and
+        'histogram' as (counts, bin_edges_ms). None if `lat` is empty.
+    """
+    lat = np.asarray(lat, dtype=np.float64)
+    if lat.size == 0:
+        return None
+
+    stats = {'frames': int(lat.size), 'mean': float(np.mean(lat)),
+             'min': float(np.min(lat)), 'max': float(np.max(lat))}
+    for name, q in (('p50', 50), ('p90', 90), ('p99', 99), ('p99.9', 99.9)):
+        stats[name] = float(np.percentile(lat, q))
+
+    lo, hi = max(stats['min'], 1e-3), max(stats['max'], 1e-3)
+    edges = np.geomspace(lo, hi, bins + 1) if hi > lo else np.array([lo, lo + 1e-3])
+    counts, edges = np.histogram(np.clip(lat, edges[0], edges[-1]), bins=edges)
+    stats['histogram'] = (counts, edges)
+    return stats
+
+# per thread conversion / driver call time of the pymodule, older builds lack it
+_stream_stats = getattr(mxa, 'get_stream_stats', None)
+
+def cpu_usage(scope='thread'):
+    """
+    CPU usage counters of the calling thread ('thread') or the whole process
+    ('process'): 'wall' perf_counter() seconds, 'user' and 'sys' CPU seconds,
+    'vcsw' / 'ivcsw' voluntary / involuntary context switches (getrusage) and
+    'syscalls' read plus write syscalls (/proc io accounting, None if not
+    available). The data path of the PCIe driver is one read / write per frame.
+    """
+    ru = resource.getrusage(resource.RUSAGE_THREAD if scope == 'thread' else resource.RUSAGE_SELF)
+    usage = {'wall': time.perf_counter(), 'user': ru.ru_utime, 'sys': ru.ru_stime,
+             'vcsw': ru.ru_nvcsw, 'ivcsw': ru.ru_nivcsw, 'syscalls': None}
+    try:
+        with open('/proc/thread-self/io' if scope == 'thread' else '/proc/self/io', 'r') as f:
+            io = dict(line.split(':') for line in f.read().split('\n') if ':' in line)
+        usage['syscalls'] = int(io['syscr']) + int(io['syscw'])
+    except (OSError, KeyError, ValueError):
+        pass
+    return usage
+
+def usage_delta(start, end):
+    return {k: (end[k] - start[k]) if (start[k] is not None and end[k] is not None) else None for k in start}
+
+def cpu_hz():
+    """
+    Nominal CPU clock (Hz) to express CPU time as cycles, None if unknown.
+    """
+    try:
+        with open('/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq', 'r') as f:
+            return int(f.read()) * 1000
+    except (OSError, ValueError):
+        pass
+    try:
+        with open('/proc/cpuinfo', 'r') as f:
+            for line in f:
+                if line.startswith('cpu MHz'):
+                    return int(float(line.split(':')[1]) * 1e6)
+    except (OSError, ValueError):
+        pass
+    return None
+
+def driver_throughput(group):
+    """
+    Kernel driver stream counters of a device (PCIe, fs_debug_en=1) since the
+    last read, which clears them: 'kdrv_w' / 'kdrv_r' (kernel write / read
+    transfers) and 'udrv_w' / 'udrv_r' (as reported by the driver library),
+    each {'us', 'kb'}. None if not exposed.
+    """
+    for root in ('/sys', '/proc'):
+        path = Path(root, 'memx{}'.format(group), 'throughput')
+        if path.is_file():
+            break
+    else:
+        return None
+
+    stats = {}
+    try:
+        with open(str(path), 'r') as f:
+            for line in f.read().split('\n')[2:]:
+                cols = [c.strip() for c in line.split('|')]
+                if len(cols) >= 3 and cols[0].lower() in ('kdrv_w', 'kdrv_r', 'udrv_w', 'udrv_r'):
+                    stats[cols[0].lower()] = {'us': int(cols[1], 0), 'kb': int(cols[2], 0)}
+    except (OSError, ValueError):
+        return None
+    return stats
+
+def host_cost_summary(process, threads, frames, throughput=None, hz=None):
+    """
+    Host cost per frame of a threaded run.
+
+    Parameters
+    ----------
+    process : dict
+        `usage_delta()` of `cpu_usage('process')` over the run.
+
+    threads : list of dict
+        `usage_delta()` of `cpu_usage('thread')` of each sender / receiver
+        thread, with its 'role' and the 'convert_ns' / 'driver_ns' of
+        `mxa.get_stream_stats()`.
+
+    throughput : dict
+        `driver_throughput()` read after the run, if any.
+
+    hz : int
+        CPU clock for the cycle figures, `cpu_hz()` if not given.
+
+    Returns
+    -------
+    cost : dict
+        Per frame: 'user_us' / 'sys_us' process CPU, 'vcsw' / 'ivcsw' context
+        switches and 'syscalls' (None if unknown) of the process, and the
+        split of the host time into 'convert_us' (frame encode / decode),
+        'syscall_us' (kernel CPU, the process sys time), 'other_us' (the rest
+        of the user CPU: python, copies, driver library threads) and
+        'wait_us' (sender / receiver threads off CPU, blocked on the
+        accelerator). 'cycles' has the same split at `hz` (None if unknown).
+        'cores' is the CPU the run kept busy and 'max_streams' how many such
+        streams all host cores could feed. 'threads' has the per frame
+        figures of each thread, 'driver' the per frame 'kdrv_w' / 'kdrv_r'
+        transfer time ('*_us') and data ('*_kb') if the counters are exposed.
+    """
+    frames = max(int(frames), 1)
+    per_frame = lambda v: None if v is None else v / frames
+    wall = max(process['wall'], 1e-9)
+
+    rows = []
+    for t in threads:
+        rows.append({'role': t['role'], 'user_us': t['user'] * 1e6 / frames, 'sys_us': t['sys'] * 1e6 / frames,
+                     'vcsw': per_frame(t['vcsw']), 'ivcsw': per_frame(t['ivcsw']), 'syscalls': per_frame(t['syscalls']),
+                     'convert_us': t['convert_ns'] / 1e3 / frames, 'driver_us': t['driver_ns'] / 1e3 / frames,
+                     'wait_us': max(t['wall'] - t['user'] - t['sys'], 0) * 1e6 / frames})
+
+    cost = {'frames': frames, 'user_us': process['user'] * 1e6 / frames, 'sys_us': process['sys'] * 1e6 / frames,
+            'vcsw': per_frame(process['vcsw']), 'ivcsw': per_frame(process['ivcsw']), 'syscalls': per_frame(process['syscalls']),
+            'threads': rows}
+    cost['convert_us'] = sum(r['convert_us'] for r in rows)
+    cost['syscall_us'] = cost['sys_us']
+    cost['other_us'] = max(cost['user_us'] - cost['convert_us'], 0.0)
+    cost['wait_us'] = sum(r['wait_us'] for r in rows)
+    cost['cores'] = (process['user'] + process['sys']) / wall
+    cost['max_streams'] = (os.cpu_count() or 1) / cost['cores'] if cost['cores'] > 0 else None
+
+    hz = hz or cpu_hz()
+    cost['cycles'] = {k: cost[k + '_us'] * hz / 1e6 for k in ('convert', 'syscall', 'other', 'wait')} if hz else None
+
+    cost['driver'] = None
+    if throughput:
+        cost['driver'] = {'{}_{}'.format(d, u): throughput[d][u] / frames
+                          for d in ('kdrv_w', 'kdrv_r') if d in throughput for u in ('us', 'kb')}
+    return cost
+
 def main():
 
     # Instantiate mxa
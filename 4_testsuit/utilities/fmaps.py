@@ -0,0 +1,173 @@
+"""
+Golden feature maps of a testcase folder.
+
+The simulator writes one text file per port and frame under `fmaps/`
+(`ifmap_truth_{port}_{frame}`, `ofmap_{port}_{frame}`). Parsing them with
+np.loadtxt dominates regression runs of large models, so they are converted
+once into one `.npy` per port holding all frames ([frames] + port shape),
+which later runs memory-map instead of parsing.
+"""
+import numpy as np
+import os, glob, argparse, tempfile
+from pathlib import Path
+
+IFMAP = 'ifmap_truth'
+OFMAP = 'ofmap'
+
+# text values are printed with 6 decimals, keep float32 when it holds them that well
+_F32_TOL = 1e-6
+
+def npy_path(testcase, kind, port):
+    return Path(testcase, 'fmaps', '{}_{}.npy'.format(kind, port))
+
+def text_path(testcase, kind, port, frame):
+    return Path(testcase, 'fmaps', '{}_{}_{}'.format(kind, port, frame))
+
+def _text_frames(testcase, kind, port):
+    n = 0
+    while text_path(testcase, kind, port, n).is_file():
+        n += 1
+    return n
+
+def convert_port(testcase, kind, port, shape, dtype=None):
+    """
+    Converts the text frames of one port into its `.npy`, returns the path or None
+    if the port has no text frames. `dtype` forces the stored type (e.g. uint8
+    ifmaps), otherwise float32 is used unless it would round the values.
+    """
+    frames = _text_frames(testcase, kind, port)
+    if frames == 0:
+        return None
+
+    data = np.stack([np.loadtxt(str(text_path(testcase, kind, port, f))).reshape(shape) for f in range(frames)])
+    if dtype is None:
+        f32 = data.astype(np.float32)
+        dtype = np.float32 if np.all(np.abs(f32 - data) <= _F32_TOL * np.maximum(1.0, np.abs(data))) else np.float64
+    data = data.astype(dtype)
+
+    # unique temporary next to the target, so concurrent converters never share it
+    path = npy_path(testcase, kind, port)
+    fd, tmp = tempfile.mkstemp(prefix=path.stem + '.', suffix='.tmp.npy', dir=str(path.parent))
+    try:
+        with os.fdopen(fd, 'wb') as f:
+            np.save(f, data)
+        os.replace(tmp, str(path))
+    except BaseException:
+        os.unlink(tmp)
+        raise
+    return path
+
+def _stale(testcase, kind, port, path):
+    mtime = path.stat().st_mtime
+    return any(text_path(testcase, kind, port, f).stat().st_mtime > mtime for f in range(_text_frames(testcase, kind, port)))
+
+def load_port(testcase, kind, port, shape, frames, dtype=None):
+    """
+    All `frames` golden frames of one port as a read-only memory-mapped
+    [frames] + shape array, converting the text files first if there is no
+    (up to date) `.npy` yet.
+    """
+    path = npy_path(testcase, kind, port)
+    if not path.is_file() or _stale(testcase, kind, port, path):
+        if convert_port(testcase, kind, port, shape, dtype) is None:
+            raise FileNotFoundError('no {} frames for port {} in {}'.format(kind, port, testcase))
+
+    data = np.load(str(path), mmap_mode='r')
+    if data.shape[0] < frames or data.shape[1:] != tuple(int(d) for d in shape):
+        raise ValueError('{} has shape {}, expected {} frames of {}'.format(path, data.shape, frames, tuple(shape)))
+    if dtype is not None and data.dtype != dtype:
+        return data[:frames].astype(dtype)
+    # plain ndarray view of the mapping, Benchmark.run() takes no subclasses
+    return np.asarray(data[:frames])
+
+def load_testcase(testcase, dfp_info, frames):
+    """
+    Golden ifmaps and ofmaps of the active ports of a testcase, as lists of
+    [frames] + shape arrays. Ifmaps come in the type they are streamed in
+    (uint8 for rgb888 ports, float32 otherwise).
+    """
+    ifmaps = []
+    for i,(k,v) in enumerate(dfp_info['input_ports'].items()):
+        if not v['active']:
+            continue
+        dtype = np.uint8 if v['packing_format'] == 'rgb888' else np.float32
+        ifmaps.append(load_port(testcase, IFMAP, i, v['shape'], frames, dtype))
+
+    ofmaps = []
+    for i,(k,v) in enumerate(dfp_info['output_ports'].items()):
+        if not v['active']:
+            continue
+        ofmaps.append(load_port(testcase, OFMAP, i, v['shape'], frames))
+    return ifmaps, ofmaps
+
+def compare(outputs, goldens, atol=1e-4, equal_nan=False):
+    """
+    Compares all frames of every output port against its golden, one
+    vectorized check per port, stopping at the first port that differs.
+    NaNs match each other only with `equal_nan`.
+
+    Returns
+    -------
+    ok, report : bool, dict
+        report is None when all ports match, otherwise 'port', 'reason'
+        ('shape' or 'value') and, for value mismatches, the first failing
+        'frame', its 'index' within the frame, 'max_err' and the number of
+        'mismatches'.
+    """
+    for p,(out, gold) in enumerate(zip(outputs, goldens)):
+        if out.shape != gold.shape:
+            return False, {'port': p, 'reason': 'shape', 'shape': out.shape, 'expected': gold.shape}
+
+        close = np.isclose(out, gold, atol=atol, equal_nan=equal_nan)
+        if close.all():
+            continue
+        bad = np.flatnonzero(~close)
+        frame_size = max(out[0].size, 1) if out.ndim > 1 else 1
+        err = np.abs(out.astype(np.float64) - gold)
+        return False, {'port': p, 'reason': 'value', 'frame': int(bad[0] // frame_size), 'index': int(bad[0] % frame_size),
+                       'max_err': float(np.nanmax(err)), 'mismatches': int(bad.size)}
+    return True, None
+
+def describe(report):
+    if report is None:
+        return 'match'
+    if report['reason'] == 'shape':
+        return 'port {}: shape {} expected {}'.format(report['port'], report['shape'], report['expected'])
+    return 'port {}: {} mismatches, first at frame {} index {}, max err {:.3g}'.format(
+           report['port'], report['mismatches'], report['frame'], report['index'], report['max_err'])
+
+def main():
+    """
+    One-time conversion of every testcase folder under --dir.
+    """
+    from utilities.dfp_inspect import dfp_inspect
+
+    parser = argparse.ArgumentParser(description = "\033[34mConvert text golden fmaps to .npy\033[0m")
+    parser.add_argument("--dir",
+                        dest    =   "dataflow_dir",
+                        action  =   "store",
+                        type    =   str,
+                        default =   "dfp",
+                        metavar =   "",
+                        help    =   "the root folder of the testcase folders")
+    cmd_arg = parser.parse_args()
+
+    for t in sorted(glob.glob(str(Path(cmd_arg.dataflow_dir, '*')))):
+        dfp_path = Path(t, 'model.dfp')
+        if not dfp_path.is_file() or not Path(t, 'fmaps').is_dir():
+            continue
+        dfp_info = dfp_inspect(str(dfp_path))
+        if dfp_info is None:
+            continue
+        converted = []
+        for kind, ports in ((IFMAP, dfp_info['input_ports']), (OFMAP, dfp_info['output_ports'])):
+            for i,(k,v) in enumerate(ports.items()):
+                if not v['active']:
+                    continue
+                dtype = (np.uint8 if v['packing_format'] == 'rgb888' else np.float32) if kind == IFMAP else None
+                if convert_port(t, kind, i, v['shape'], dtype) is not None:
+                    converted.append('{}_{}'.format(kind, i))
+        print('{}: {}'.format(Path(t).name, ', '.join(converted) if converted else 'no text fmaps'))
+
+if __name__=="__main__":
+    main()